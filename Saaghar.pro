@@ -196,7 +196,20 @@ include($$PWD/locale/locale.pri)
 include($$PWD/data/data.pri)
 include($$PWD/doc/doc.pri)
 
-INSTALLS += target
+## 'qmake CONFIG+=saaghar_bench' builds the headless benchmark harness
+## 'saaghar-bench' instead of Saaghar, see bench/bench.pri
+CONFIG(saaghar_bench) {
+    !build_pass:message("BENCHMARK BUILD")
+    TARGET = saaghar-bench
+    CONFIG += console
+    CONFIG -= app_bundle
+    DEFINES += SAAGHAR_BENCH
+
+    include($$PWD/bench/bench.pri)
+}
+else {
+    INSTALLS += target
+}
 
 mac {
     QMAKE_BUNDLE_DATA += utilities \
@@ -0,0 +1,23 @@
+# saaghar-bench: headless benchmarks of the non-GUI parts of Saaghar.
+#
+#   qmake CONFIG+=saaghar_bench && make
+#   saaghar-bench generate --scale 5 --output corpus-5x.s3db
+#   saaghar-bench run --database corpus-5x.s3db --output results.json
+#   saaghar-bench pack --database ganjoor.s3db
+#   saaghar-bench check
+#
+# Results are JSON (or CSV) so they can be compared between releases.
+
+DEPENDPATH += $$PWD
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/corpusgenerator.h \
+    $$PWD/selfcheck.h \
+    $$PWD/benchmark.h
+
+SOURCES += \
+    $$PWD/benchmain.cpp \
+    $$PWD/corpusgenerator.cpp \
+    $$PWD/selfcheck.cpp \
+    $$PWD/benchmark.cpp
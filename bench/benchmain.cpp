@@ -0,0 +1,212 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "benchmark.h"
+#include "corpusgenerator.h"
+#include "databasebrowser.h"
+#include "poempack.h"
+#include "searchresultwidget.h"
+#include "selfcheck.h"
+#include "version.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+namespace
+{
+void printUsage(QTextStream &out)
+{
+    out << "Usage:\n"
+        << "  saaghar-bench generate [--scale 1|5|20] [--seed N] --output FILE\n"
+        << "      creates a synthetic Ganjoor database, scale 1 is about the real corpus size\n"
+        << "  saaghar-bench run [--database FILE] [--scale N] [--seed N] [--iterations N]\n"
+        << "                    [--suites " << Benchmark::availableSuites().join(",") << "]\n"
+        << "                    [--format json|csv] [--output FILE]\n"
+        << "      runs suites, a corpus is generated in temp directory if no database is given,\n"
+        << "      otherwise '--seed' has to be the one that database is generated with\n"
+        << "  saaghar-bench check\n"
+        << "      runs correctness checks of search and highlighting\n"
+        << "  saaghar-bench pack --database FILE [--output FILE] [--skip-vowel-signs] [--skip-vowel-letters]\n"
+        << "      converts a database to a read-only poem pack like Saaghar's 'Create Read-only Pack',\n"
+        << "      Saaghar uses the pack next to its database when the database is read-only. texts are\n"
+        << "      normalized by given search options, without them by Saaghar's default options\n";
+}
+
+QString argumentValue(const QStringList &args, const QString &name, const QString &defaultValue = QString())
+{
+    const int index = args.indexOf(name);
+
+    return (index != -1 && index + 1 < args.size()) ? args.at(index + 1) : defaultValue;
+}
+}
+
+int main(int argc, char* argv[])
+{
+#if QT_VERSION >= 0x050000
+    // fonts are needed by justification suite but not a display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+#endif
+
+    QApplication app(argc, argv);
+    app.setApplicationName("saaghar-bench");
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList args = app.arguments().mid(1);
+    if (args.isEmpty() || args.contains("--help") || args.contains("-h")) {
+        printUsage(out);
+        return args.isEmpty() ? 1 : 0;
+    }
+
+    const QString command = args.first();
+    const int scale = argumentValue(args, "--scale", "1").toInt();
+    const quint32 seed = argumentValue(args, "--seed", "1").toUInt();
+
+    CorpusGenerator generator(scale, seed);
+
+    if (command == "generate") {
+        const QString output = argumentValue(args, "--output");
+        if (output.isEmpty()) {
+            printUsage(err);
+            return 1;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        QString error;
+        if (!generator.generate(output, &error)) {
+            err << "Generating failed: " << error << "\n";
+            return 1;
+        }
+
+        const CorpusGenerator::Stats stats = generator.stats();
+        err << QString("%1: %2 poets, %3 categories, %4 poems, %5 verses in %6 s\n")
+            .arg(output).arg(stats.poets).arg(stats.cats).arg(stats.poems).arg(stats.verses)
+            .arg(timer.elapsed() / 1000.0);
+        return 0;
+    }
+    else if (command == "check") {
+        SelfCheck check(&out);
+        const int failures = check.run();
+        err << failures << " check(s) failed\n";
+        return failures == 0 ? 0 : 1;
+    }
+    else if (command == "pack") {
+        const QString database = argumentValue(args, "--database");
+        if (database.isEmpty()) {
+            printUsage(err);
+            return 1;
+        }
+        const QString output = argumentValue(args, "--output", PoemPack::packFileName(database));
+
+        SearchResultWidget::skipVowelSigns = args.contains("--skip-vowel-signs");
+        SearchResultWidget::skipVowelLetters = args.contains("--skip-vowel-letters");
+
+        DatabaseBrowser::setAccessMode(DatabaseBrowser::ReadOnly);
+        DatabaseBrowser::setDefaultDatabasename(database);
+        const QString connectionID = DatabaseBrowser::defaultConnectionId();
+        if (!DatabaseBrowser::isValid(connectionID)) {
+            err << "Database could not be opened: " << database << "\n";
+            return 1;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        QString error;
+        if (!PoemPack::write(connectionID, output, &error)) {
+            err << "Packing failed: " << error << "\n";
+            return 1;
+        }
+
+        err << QString("%1: %2 bytes in %3 s\n").arg(output).arg(QFileInfo(output).size()).arg(timer.elapsed() / 1000.0);
+        return 0;
+    }
+    else if (command != "run") {
+        printUsage(err);
+        return 1;
+    }
+
+    QString database = argumentValue(args, "--database");
+    bool generatedDatabase = false;
+    if (database.isEmpty()) {
+        database = QDir::tempPath() + QString("/saaghar-bench-%1x-%2.s3db").arg(scale).arg(seed);
+        generatedDatabase = true;
+
+        err << "Generating corpus: " << database << "\n";
+        QString error;
+        if (!generator.generate(database, &error)) {
+            err << "Generating failed: " << error << "\n";
+            return 1;
+        }
+    }
+
+    QStringList suites = argumentValue(args, "--suites", Benchmark::availableSuites().join(",")).split(",", QString::SkipEmptyParts);
+    foreach (const QString &suite, suites) {
+        if (!Benchmark::availableSuites().contains(suite)) {
+            err << "Unknown suite: " << suite << "\n";
+            return 1;
+        }
+    }
+
+    Benchmark benchmark(database, &generator, argumentValue(args, "--iterations", "5").toInt());
+    benchmark.addMetadata("saaghar_version", SAAGHAR_VERSION);
+    benchmark.addMetadata("git_revision", GIT_REVISION);
+    benchmark.addMetadata("qt_version", qVersion());
+    benchmark.addMetadata("database", QFileInfo(database).fileName());
+    benchmark.addMetadata("database_size", QString::number(QFileInfo(database).size()));
+    benchmark.addMetadata("scale", generatedDatabase ? QString::number(scale) : QString("unknown"));
+    benchmark.addMetadata("seed", QString::number(seed));
+    benchmark.addMetadata("font", app.font().family() + " " + QString::number(app.font().pointSizeF()));
+
+    if (!benchmark.run(suites)) {
+        err << "Database could not be opened: " << database << "\n";
+        return 1;
+    }
+
+    const QString results = argumentValue(args, "--format", "json") == "csv" ? benchmark.toCsv() : benchmark.toJson();
+    const QString output = argumentValue(args, "--output");
+
+    if (output.isEmpty()) {
+        out << results;
+    }
+    else {
+        QFile file(output);
+        if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+            err << "Can not write to: " << output << "\n";
+            return 1;
+        }
+        QTextStream fileStream(&file);
+        fileStream.setCodec("UTF-8");
+        fileStream << results;
+    }
+
+    return 0;
+}
@@ -0,0 +1,463 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "benchmark.h"
+#include "concurrenttasks.h"
+#include "corpusgenerator.h"
+#include "databasebrowser.h"
+#include "searchpatternmanager.h"
+#include "tools.h"
+#include "importer/importermanager.h"
+#include "importer/importer_interface.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFontMetrics>
+#include <QSqlQuery>
+#include <QVariant>
+
+#define NSECS_PER_MSEC 1000000.0
+
+namespace
+{
+QString jsonString(const QString &str)
+{
+    QString escaped;
+    escaped.reserve(str.size() + 2);
+    escaped += QLatin1Char('"');
+
+    for (int i = 0; i < str.size(); ++i) {
+        const QChar ch = str.at(i);
+        if (ch == QLatin1Char('"') || ch == QLatin1Char('\\')) {
+            escaped += QLatin1Char('\\');
+            escaped += ch;
+        }
+        else if (ch.unicode() < 0x20) {
+            escaped += QString("\\u%1").arg(ch.unicode(), 4, 16, QLatin1Char('0'));
+        }
+        else {
+            escaped += ch;
+        }
+    }
+
+    escaped += QLatin1Char('"');
+    return escaped;
+}
+
+QString jsonNumber(double value)
+{
+    return QString::number(value, 'f', 3);
+}
+}
+
+double Benchmark::Result::minMs() const
+{
+    if (samples.isEmpty()) {
+        return 0;
+    }
+
+    qint64 min = samples.first();
+    foreach (qint64 sample, samples) {
+        min = qMin(min, sample);
+    }
+
+    return min / NSECS_PER_MSEC;
+}
+
+double Benchmark::Result::medianMs() const
+{
+    if (samples.isEmpty()) {
+        return 0;
+    }
+
+    QList<qint64> sorted = samples;
+    qSort(sorted);
+    const int middle = sorted.size() / 2;
+
+    return (sorted.size() % 2 == 1
+            ? sorted.at(middle)
+            : (sorted.at(middle - 1) + sorted.at(middle)) / 2) / NSECS_PER_MSEC;
+}
+
+double Benchmark::Result::meanMs() const
+{
+    if (samples.isEmpty()) {
+        return 0;
+    }
+
+    qint64 total = 0;
+    foreach (qint64 sample, samples) {
+        total += sample;
+    }
+
+    return total / NSECS_PER_MSEC / samples.size();
+}
+
+double Benchmark::Result::maxMs() const
+{
+    qint64 max = 0;
+    foreach (qint64 sample, samples) {
+        max = qMax(max, sample);
+    }
+
+    return max / NSECS_PER_MSEC;
+}
+
+Benchmark::Benchmark(const QString &databaseFile, CorpusGenerator* generator, int iterations)
+    : m_databaseFile(databaseFile),
+      m_generator(generator),
+      m_iterations(qMax(1, iterations))
+{
+}
+
+QStringList Benchmark::availableSuites()
+{
+    return QStringList() << "catalog" << "search" << "normalization" << "justification" << "import";
+}
+
+void Benchmark::addMetadata(const QString &key, const QString &value)
+{
+    m_metadata << qMakePair(key, value);
+}
+
+bool Benchmark::run(const QStringList &suites)
+{
+    DatabaseBrowser::setDefaultDatabasename(m_databaseFile);
+    m_connectionID = DatabaseBrowser::defaultConnectionId();
+
+    if (!DatabaseBrowser::isConnected(m_connectionID) || !DatabaseBrowser::isValid(m_connectionID)) {
+        return false;
+    }
+
+    foreach (const QString &suite, suites) {
+        if (suite == "catalog") {
+            runCatalog();
+        }
+        else if (suite == "search") {
+            runSearch();
+        }
+        else if (suite == "normalization") {
+            runNormalization();
+        }
+        else if (suite == "justification") {
+            runJustification();
+        }
+        else if (suite == "import") {
+            runImport();
+        }
+    }
+
+    return true;
+}
+
+QStringList Benchmark::sampleVerses(int count, bool hemistichsOnly)
+{
+    QStringList verses;
+
+    QSqlQuery q(DatabaseBrowser::database(m_connectionID));
+    q.setForwardOnly(true);
+    q.exec(QString("SELECT text FROM verse %1 ORDER BY rowid LIMIT %2")
+           .arg(hemistichsOnly ? QString("WHERE position IN (%1, %2)").arg(Right).arg(Left) : QString())
+           .arg(count));
+
+    while (q.next()) {
+        verses << q.value(0).toString();
+    }
+
+    return verses;
+}
+
+// the same order as outline's tree: poets, their categories and poems
+void Benchmark::runCatalog()
+{
+    DatabaseBrowser* browser = DatabaseBrowser::instance();
+
+    Result result;
+    result.suite = "catalog";
+    result.name = "load-tree";
+
+    QElapsedTimer timer;
+    for (int i = -1; i < m_iterations; ++i) {
+        qint64 items = 0;
+        timer.start();
+
+        const QVector<GanjoorPoet> poets = browser->poets(m_connectionID, false);
+        items += poets.size();
+
+        QList<int> catIDs;
+        foreach (const GanjoorPoet &poet, poets) {
+            catIDs << poet._CatID;
+        }
+
+        while (!catIDs.isEmpty()) {
+            const int catID = catIDs.takeFirst();
+
+            const QVector<GanjoorCat> subCats = browser->subCategories(catID, m_connectionID);
+            foreach (const GanjoorCat &cat, subCats) {
+                catIDs << cat._ID;
+            }
+            items += subCats.size();
+
+            items += browser->poems(catID, m_connectionID).size();
+        }
+
+        if (i >= 0) {
+            result.samples << timer.nsecsElapsed();
+            result.items = items;
+        }
+    }
+
+    m_results << result;
+}
+
+// runs the same search task that Saaghar runs, in the calling thread and without result cache
+qint64 Benchmark::searchHits(const QString &phrase)
+{
+    SearchPatternManager::instance()->setInputPhrase(phrase);
+    SearchPatternManager::instance()->init();
+    const QVector<QStringList> phraseVectorList = SearchPatternManager::instance()->outputPhrases();
+    const QVector<QStringList> excludedVectorList = SearchPatternManager::instance()->outputExcludedLlist();
+
+    qint64 hits = 0;
+
+    for (int i = 0; i < phraseVectorList.size(); ++i) {
+        const QStringList &phraseList = phraseVectorList.at(i);
+        if (phraseList.isEmpty()) {
+            continue;
+        }
+
+        QVariantHash arguments = DatabaseBrowser::searchArguments("ALL", QString(), phraseList, excludedVectorList.value(i),
+                                 0, false, m_connectionID);
+        // each iteration has to search again
+        arguments.insert("cacheKey", QString());
+
+        ConcurrentTask searchTask;
+        hits += searchTask.exec(ConcurrentTask::Search, arguments).value<SearchResults>().size();
+    }
+
+    return hits;
+}
+
+void Benchmark::runSearch()
+{
+    // common, medium and rare words, ANDed words, an exact phrase and a wildcard
+    QList<QPair<QString, QString> > phrases;
+    phrases << qMakePair(QString("common-word"), m_generator->word(3))
+            << qMakePair(QString("medium-word"), m_generator->word(300))
+            << qMakePair(QString("rare-word"), m_generator->word(10000))
+            << qMakePair(QString("and-words"), m_generator->word(3) + " " + m_generator->word(40))
+            << qMakePair(QString("exact-phrase"), "\"" + m_generator->word(1) + " " + m_generator->word(2) + "\"")
+            << qMakePair(QString("wildcard"), m_generator->word(20).left(2) + "*");
+
+    QElapsedTimer timer;
+    for (int p = 0; p < phrases.size(); ++p) {
+        Result result;
+        result.suite = "search";
+        result.name = phrases.at(p).first;
+
+        for (int i = -1; i < m_iterations; ++i) {
+            timer.start();
+            const qint64 hits = searchHits(phrases.at(p).second);
+            if (i >= 0) {
+                result.samples << timer.nsecsElapsed();
+                result.items = hits;
+            }
+        }
+
+        m_results << result;
+    }
+}
+
+void Benchmark::runNormalization()
+{
+    const QStringList verses = sampleVerses(100000);
+    const QStringList excludeList = QStringList() << " ";
+
+    QElapsedTimer timer;
+    for (int c = 0; c < 3; ++c) {
+        Result result;
+        result.suite = "normalization";
+        result.name = c == 0 ? "simpleCleanString" : (c == 1 ? "cleanString" : "cleanStringFast");
+        result.items = verses.size();
+
+        for (int i = -1; i < m_iterations; ++i) {
+            int totalSize = 0;
+            timer.start();
+            foreach (const QString &verse, verses) {
+                if (c == 0) {
+                    totalSize += Tools::simpleCleanString(verse).size();
+                }
+                else if (c == 1) {
+                    totalSize += Tools::cleanString(verse, excludeList).size();
+                }
+                else {
+                    totalSize += Tools::cleanStringFast(verse, excludeList).size();
+                }
+            }
+            if (i >= 0) {
+                result.samples << timer.nsecsElapsed();
+            }
+            Q_UNUSED(totalSize)
+        }
+
+        m_results << result;
+    }
+}
+
+void Benchmark::runJustification()
+{
+    const QStringList hemistichs = sampleVerses(10000, true);
+    const QFontMetrics fontMetrics(QApplication::font());
+
+    QElapsedTimer timer;
+    foreach (int width, QList<int>() << 250 << 500) {
+        Result result;
+        result.suite = "justification";
+        result.name = QString("width-%1").arg(width);
+        result.items = hemistichs.size();
+
+        for (int i = -1; i < m_iterations; ++i) {
+            timer.start();
+            foreach (const QString &hemistich, hemistichs) {
+                Tools::justifiedText(hemistich, fontMetrics, width);
+            }
+            if (i >= 0) {
+                result.samples << timer.nsecsElapsed();
+            }
+        }
+
+        m_results << result;
+    }
+}
+
+void Benchmark::runImport()
+{
+    ImporterInterface* importer = ImporterManager::instance()->importer("txt");
+    if (!importer) {
+        return;
+    }
+
+    ImporterInterface::Options options;
+    options.contentTypes = ImporterInterface::Options::Poem;
+    importer->setOptions(options);
+
+    // independent of the state of corpus generator
+    CorpusGenerator textGenerator(1, 1);
+    const QString text = textGenerator.importText(500);
+    const QString scratchFile = QDir::tempPath() + "/saaghar-bench-import.s3db";
+
+    Result parseResult;
+    parseResult.suite = "import";
+    parseResult.name = "parse-txt";
+
+    Result storeResult;
+    storeResult.suite = "import";
+    storeResult.name = "store-dataset";
+
+    QElapsedTimer timer;
+    for (int i = -1; i < m_iterations; ++i) {
+        timer.start();
+        importer->import(text);
+        const CatContents contents = importer->importData();
+        const qint64 parseTime = timer.nsecsElapsed();
+
+        QFile::remove(scratchFile);
+        const QString scratchConnectionID = DatabaseBrowser::getIdForDataBase(scratchFile);
+        DatabaseBrowser::createEmptyDataBase(scratchConnectionID);
+
+        GanjoorCat root;
+        root._Text = "saaghar-bench";
+
+        timer.start();
+        DatabaseBrowser::instance()->storeAsDataset(contents, QList<GanjoorCat>() << root, false, scratchConnectionID);
+        const qint64 storeTime = timer.nsecsElapsed();
+
+        DatabaseBrowser::removeDatabase(scratchFile);
+
+        if (i >= 0) {
+            parseResult.samples << parseTime;
+            parseResult.items = contents.poems.size();
+            storeResult.samples << storeTime;
+            storeResult.items = contents.poems.size();
+        }
+    }
+
+    QFile::remove(scratchFile);
+
+    m_results << parseResult << storeResult;
+}
+
+QString Benchmark::toJson() const
+{
+    QStringList metadata;
+    for (int i = 0; i < m_metadata.size(); ++i) {
+        metadata << QString("    %1: %2").arg(jsonString(m_metadata.at(i).first)).arg(jsonString(m_metadata.at(i).second));
+    }
+
+    QStringList results;
+    foreach (const Result &result, m_results) {
+        QStringList samples;
+        foreach (qint64 sample, result.samples) {
+            samples << jsonNumber(sample / NSECS_PER_MSEC);
+        }
+
+        const double median = result.medianMs();
+        results << QString("    {\"suite\": %1, \"case\": %2, \"iterations\": %3, \"items\": %4, "
+                           "\"min_ms\": %5, \"median_ms\": %6, \"mean_ms\": %7, \"max_ms\": %8, "
+                           "\"items_per_s\": %9, \"samples_ms\": [%10]}")
+                .arg(jsonString(result.suite))
+                .arg(jsonString(result.name))
+                .arg(result.samples.size())
+                .arg(result.items)
+                .arg(jsonNumber(result.minMs()))
+                .arg(jsonNumber(median))
+                .arg(jsonNumber(result.meanMs()))
+                .arg(jsonNumber(result.maxMs()))
+                .arg(jsonNumber(median > 0 ? result.items * 1000.0 / median : 0))
+                .arg(samples.join(", "));
+    }
+
+    return QString("{\n  \"metadata\": {\n%1\n  },\n  \"results\": [\n%2\n  ]\n}\n")
+           .arg(metadata.join(",\n"))
+           .arg(results.join(",\n"));
+}
+
+QString Benchmark::toCsv() const
+{
+    QStringList lines;
+    lines << "suite,case,iterations,items,min_ms,median_ms,mean_ms,max_ms";
+
+    foreach (const Result &result, m_results) {
+        lines << QString("%1,%2,%3,%4,%5,%6,%7,%8")
+              .arg(result.suite)
+              .arg(result.name)
+              .arg(result.samples.size())
+              .arg(result.items)
+              .arg(jsonNumber(result.minMs()))
+              .arg(jsonNumber(result.medianMs()))
+              .arg(jsonNumber(result.meanMs()))
+              .arg(jsonNumber(result.maxMs()));
+    }
+
+    return lines.join("\n") + "\n";
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QList>
+#include <QPair>
+#include <QStringList>
+
+class CorpusGenerator;
+
+// Runs benchmark suites against a Ganjoor database. Every case runs one
+// untimed warm up pass and then 'iterations' timed passes.
+class Benchmark
+{
+public:
+    struct Result {
+        Result() : items(0) {}
+
+        QString suite;
+        QString name;
+        // items processed in each pass, e.g. verses or matches
+        qint64 items;
+        // nanoseconds of each pass
+        QList<qint64> samples;
+
+        double minMs() const;
+        double medianMs() const;
+        double meanMs() const;
+        double maxMs() const;
+    };
+
+    Benchmark(const QString &databaseFile, CorpusGenerator* generator, int iterations = 5);
+
+    static QStringList availableSuites();
+
+    // returns false if the database could not be opened
+    bool run(const QStringList &suites);
+
+    QList<Result> results() const { return m_results; }
+    void addMetadata(const QString &key, const QString &value);
+
+    QString toJson() const;
+    QString toCsv() const;
+
+private:
+    void runCatalog();
+    void runSearch();
+    void runNormalization();
+    void runJustification();
+    void runImport();
+
+    qint64 searchHits(const QString &phrase);
+    QStringList sampleVerses(int count, bool hemistichsOnly = false);
+
+    QString m_databaseFile;
+    QString m_connectionID;
+    CorpusGenerator* m_generator;
+    int m_iterations;
+
+    QList<QPair<QString, QString> > m_metadata;
+    QList<Result> m_results;
+};
+
+#endif // BENCHMARK_H
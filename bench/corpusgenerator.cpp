@@ -0,0 +1,282 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "corpusgenerator.h"
+#include "databasebrowser.h"
+#include "databaseelements.h"
+
+#include <QFile>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+// sizes of scale 1
+#define POETS_PER_SCALE 100
+#define CATS_PER_POET 4
+#define POEMS_PER_CAT 60
+#define VOCABULARY_SIZE 30000
+
+namespace
+{
+const ushort LETTERS[] = {
+    0x0627, 0x0628, 0x067E, 0x062A, 0x062B, 0x062C, 0x0686, 0x062D, 0x062E, 0x062F,
+    0x0630, 0x0631, 0x0632, 0x0698, 0x0633, 0x0634, 0x0635, 0x0636, 0x0637, 0x0638,
+    0x0639, 0x063A, 0x0641, 0x0642, 0x06A9, 0x06AF, 0x0644, 0x0645, 0x0646, 0x0648,
+    0x0647, 0x06CC
+};
+const int LETTERS_COUNT = sizeof(LETTERS) / sizeof(LETTERS[0]);
+
+// fatha, kasra, damma, tashdid
+const ushort DIACRITICS[] = {0x064E, 0x0650, 0x064F, 0x0651};
+
+const QChar ZWNJ(0x200C);
+const QChar TATWEEL(0x0640);
+}
+
+CorpusGenerator::CorpusGenerator(int scale, quint32 seed)
+    : m_scale(qMax(1, scale)),
+      m_state(seed ? seed : 1)
+{
+    createVocabulary();
+}
+
+// xorshift32, qrand() is not the same on all platforms
+quint32 CorpusGenerator::nextRandom()
+{
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+
+    return m_state;
+}
+
+int CorpusGenerator::random(int minBound, int maxBound)
+{
+    return minBound + int(nextRandom() % quint32(maxBound - minBound + 1));
+}
+
+bool CorpusGenerator::chance(int percent)
+{
+    return random(0, 99) < percent;
+}
+
+void CorpusGenerator::createVocabulary()
+{
+    m_vocabulary.clear();
+
+    QSet<QString> used;
+    while (m_vocabulary.size() < VOCABULARY_SIZE) {
+        // frequent words are shorter, 2 and 3 letters words are enough for top of the list
+        const int length = random(2, 3 + (m_vocabulary.size() * 5) / VOCABULARY_SIZE);
+
+        QString word;
+        for (int i = 0; i < length; ++i) {
+            word += QChar(LETTERS[random(0, LETTERS_COUNT - 1)]);
+        }
+
+        if (!used.contains(word)) {
+            used.insert(word);
+            m_vocabulary << word;
+        }
+    }
+}
+
+QString CorpusGenerator::word(int rank) const
+{
+    return m_vocabulary.at(qBound(0, rank, m_vocabulary.size() - 1));
+}
+
+QString CorpusGenerator::randomWord()
+{
+    // a rough Zipf distribution: most picks are from the top of the list
+    const double u = double(nextRandom()) / double(0xFFFFFFFFu);
+    QString word = m_vocabulary.at(int(u * u * u * (m_vocabulary.size() - 1)));
+
+    // noise that search and normalization have to deal with
+    if (chance(5)) {
+        word.insert(1, QChar(DIACRITICS[random(0, 3)]));
+    }
+    if (chance(3)) {
+        word.replace(QChar(0x06CC), QChar(0x064A)); // Arabic Ye
+        word.replace(QChar(0x06A9), QChar(0x0643)); // Arabic Kaf
+    }
+    if (chance(2)) {
+        word.insert(word.size() / 2, TATWEEL);
+    }
+    if (chance(2)) {
+        word += ZWNJ + m_vocabulary.at(random(0, 99));
+    }
+
+    return word;
+}
+
+QString CorpusGenerator::randomLine(int minWords, int maxWords)
+{
+    const int count = random(minWords, maxWords);
+
+    QStringList words;
+    for (int i = 0; i < count; ++i) {
+        words << randomWord();
+    }
+
+    return words.join(" ");
+}
+
+bool CorpusGenerator::generate(const QString &fileName, QString* error)
+{
+    m_stats = Stats();
+
+    if (QFile::exists(fileName) && !QFile::remove(fileName)) {
+        if (error) {
+            *error = QString("Can not overwrite '%1'").arg(fileName);
+        }
+        return false;
+    }
+
+    const QString connectionID = DatabaseBrowser::getIdForDataBase(fileName);
+    if (!DatabaseBrowser::createEmptyDataBase(connectionID)) {
+        if (error) {
+            *error = DatabaseBrowser::database(connectionID).lastError().text();
+        }
+        DatabaseBrowser::removeDatabase(fileName);
+        return false;
+    }
+
+    QSqlDatabase db = DatabaseBrowser::database(connectionID);
+    db.transaction();
+
+    QSqlQuery insertPoet(db);
+    insertPoet.prepare("INSERT INTO poet (id, name, cat_id, description) VALUES (?, ?, ?, ?)");
+    QSqlQuery insertCat(db);
+    insertCat.prepare("INSERT INTO cat (id, poet_id, text, parent_id, url) VALUES (?, ?, ?, ?, ?)");
+    QSqlQuery insertPoem(db);
+    insertPoem.prepare("INSERT INTO poem (id, cat_id, title, url) VALUES (?, ?, ?, ?)");
+    QSqlQuery insertVerse(db);
+    insertVerse.prepare("INSERT INTO verse (poem_id, vorder, position, text) VALUES (?, ?, ?, ?)");
+
+    int catID = 0;
+    int poemID = 0;
+    bool ok = true;
+
+    const int poetsCount = POETS_PER_SCALE * m_scale;
+    for (int poetID = 1; ok && poetID <= poetsCount; ++poetID) {
+        const int poetCatID = ++catID;
+        const QString poetName = randomLine(1, 2);
+
+        insertPoet.addBindValue(poetID);
+        insertPoet.addBindValue(poetName);
+        insertPoet.addBindValue(poetCatID);
+        insertPoet.addBindValue(randomLine(20, 60));
+        ok = ok && insertPoet.exec();
+
+        insertCat.addBindValue(poetCatID);
+        insertCat.addBindValue(poetID);
+        insertCat.addBindValue(poetName);
+        insertCat.addBindValue(0);
+        insertCat.addBindValue(QString("http://ganjoor.net/bench/%1/").arg(poetID));
+        ok = ok && insertCat.exec();
+        ++m_stats.poets;
+        ++m_stats.cats;
+
+        for (int c = 0; ok && c < CATS_PER_POET; ++c) {
+            const int subCatID = ++catID;
+            insertCat.addBindValue(subCatID);
+            insertCat.addBindValue(poetID);
+            insertCat.addBindValue(randomLine(1, 2));
+            insertCat.addBindValue(poetCatID);
+            insertCat.addBindValue(QString("http://ganjoor.net/bench/%1/%2/").arg(poetID).arg(subCatID));
+            ok = ok && insertCat.exec();
+            ++m_stats.cats;
+
+            // classical, modern (nimaei) and prose poems
+            const int kind = random(0, 9);
+            for (int p = 0; ok && p < POEMS_PER_CAT; ++p) {
+                ++poemID;
+                insertPoem.addBindValue(poemID);
+                insertPoem.addBindValue(subCatID);
+                insertPoem.addBindValue(randomLine(2, 4));
+                insertPoem.addBindValue(QString("http://ganjoor.net/bench/%1/%2/sh%3").arg(poetID).arg(subCatID).arg(p + 1));
+                ok = ok && insertPoem.exec();
+                ++m_stats.poems;
+
+                const int versesCount = kind < 7 ? 2 * random(6, 20) : random(4, 30);
+                for (int v = 0; ok && v < versesCount; ++v) {
+                    int position;
+                    QString text;
+                    if (kind < 7) {
+                        position = v % 2 == 0 ? Right : Left;
+                        text = randomLine(3, 7);
+                    }
+                    else if (kind < 9) {
+                        position = Single;
+                        text = randomLine(1, 6);
+                    }
+                    else {
+                        position = Paragraph;
+                        text = randomLine(15, 60);
+                    }
+
+                    insertVerse.addBindValue(poemID);
+                    insertVerse.addBindValue(v + 1);
+                    insertVerse.addBindValue(position);
+                    insertVerse.addBindValue(text);
+                    ok = ok && insertVerse.exec();
+                    ++m_stats.verses;
+                }
+            }
+        }
+    }
+
+    if (!ok || !db.commit()) {
+        if (error) {
+            *error = db.lastError().text();
+        }
+        db.rollback();
+        ok = false;
+    }
+
+    insertPoet.clear();
+    insertCat.clear();
+    insertPoem.clear();
+    insertVerse.clear();
+    db = QSqlDatabase();
+    DatabaseBrowser::removeDatabase(fileName);
+
+    return ok;
+}
+
+QString CorpusGenerator::importText(int poemsCount)
+{
+    QStringList lines;
+    for (int p = 0; p < poemsCount; ++p) {
+        lines << randomLine(2, 4);
+
+        const int versesCount = 2 * random(6, 20);
+        for (int v = 0; v < versesCount; ++v) {
+            lines << randomLine(3, 7);
+        }
+        lines << QString();
+    }
+
+    return lines.join("\n");
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CORPUSGENERATOR_H
+#define CORPUSGENERATOR_H
+
+#include <QStringList>
+
+// Generates a Ganjoor schema database filled with synthetic Persian-like
+// text. Output only depends on scale and seed, so benchmarks are repeatable.
+// At scale 1 its size is about the size of Ganjoor's distributed database.
+class CorpusGenerator
+{
+public:
+    struct Stats {
+        Stats() : poets(0), cats(0), poems(0), verses(0) {}
+
+        int poets;
+        int cats;
+        int poems;
+        int verses;
+    };
+
+    explicit CorpusGenerator(int scale = 1, quint32 seed = 1);
+
+    bool generate(const QString &fileName, QString* error = 0);
+    Stats stats() const { return m_stats; }
+
+    // words sorted by frequency, rank 0 is the most frequent word
+    QString word(int rank) const;
+    int vocabularySize() const { return m_vocabulary.size(); }
+
+    // verses of some poems as the text format of TxtImporter
+    QString importText(int poemsCount);
+
+private:
+    quint32 nextRandom();
+    int random(int minBound, int maxBound);
+    bool chance(int percent);
+
+    QString randomWord();
+    QString randomLine(int minWords, int maxWords);
+    void createVocabulary();
+
+    int m_scale;
+    quint32 m_state;
+    QStringList m_vocabulary;
+    Stats m_stats;
+};
+
+#endif // CORPUSGENERATOR_H
@@ -0,0 +1,131 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "selfcheck.h"
+#include "keywordhighlighter.h"
+#include "positionalindex.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTextStream>
+
+static const char* selfCheckConnection = "saaghar-bench-selfcheck";
+
+// a NEAR clause of 'operands' with the same 'distance' between each two of them
+static PositionalClause nearClause(const QStringList &operands, int distance)
+{
+    PositionalClause clause;
+    foreach (const QString &operand, operands) {
+        clause.operands << operand.split(QLatin1Char(' '), QString::SkipEmptyParts);
+    }
+    for (int i = 1; i < operands.size(); ++i) {
+        clause.distances << distance;
+    }
+
+    return clause;
+}
+
+SelfCheck::SelfCheck(QTextStream* log)
+    : m_log(log),
+      m_failures(0)
+{
+}
+
+int SelfCheck::run()
+{
+    m_failures = 0;
+
+    checkKeywordHighlighter();
+    checkNearClauses();
+
+    return m_failures;
+}
+
+void SelfCheck::verify(bool condition, const QString &name)
+{
+    *m_log << (condition ? "PASS " : "FAIL ") << name << "\n";
+
+    if (!condition) {
+        ++m_failures;
+    }
+}
+
+void SelfCheck::checkKeywordHighlighter()
+{
+    // gol and golestan
+    const QString gol = QString::fromUtf8("\xda\xaf\xd9\x84");
+    const QString golestan = QString::fromUtf8("\xda\xaf\xd9\x84\xd8\xb3\xd8\xaa\xd8\xa7\xd9\x86");
+
+    KeywordHighlighter highlighter(QStringList() << gol << golestan);
+    KeywordHighlighter::Spans spans = highlighter.matches(golestan);
+    verify(spans.size() == 1 && spans.at(0).start == 0 && spans.at(0).length == golestan.size(),
+           "highlighter: longer keyword wins over its prefix");
+
+    spans = highlighter.matches(gol + " " + golestan);
+    verify(spans.size() == 2 && spans.at(0).length == gol.size() && spans.at(1).length == golestan.size(),
+           "highlighter: prefix keyword is still highlighted alone");
+}
+
+void SelfCheck::checkNearClauses()
+{
+    const QStringList verses = QStringList()
+                               << "a b c"
+                               << "a b x x x b c"
+                               << "c x a b";
+
+    const PositionalClause phraseNear = nearClause(QStringList() << "a b" << "c", 1);
+    const PositionalClause chain = nearClause(QStringList() << "a" << "b" << "c", 1);
+
+    // row by row evaluation
+    verify(PositionalIndex::matches(PositionalIndex::tokenize(verses.at(0)), phraseNear),
+           "near: distance is measured from end of phrase operand");
+    verify(PositionalIndex::matches(PositionalIndex::tokenize(verses.at(2)), nearClause(QStringList() << "c" << "a b", 2)),
+           "near: operands match in either order");
+    verify(PositionalIndex::matches(PositionalIndex::tokenize(verses.at(0)), chain),
+           "near: chain matches adjacent operands");
+    verify(!PositionalIndex::matches(PositionalIndex::tokenize(verses.at(1)), chain),
+           "near: chain keeps positions of middle operand");
+
+    // the same clauses through the index
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", selfCheckConnection);
+        db.setDatabaseName(":memory:");
+        db.open();
+
+        QSqlQuery q(db);
+        q.exec("CREATE TABLE verse (poem_id INTEGER, vorder INTEGER, position INTEGER, text NVARCHAR(300))");
+        q.prepare("INSERT INTO verse (poem_id, vorder, position, text) VALUES (1, ?, 0, ?)");
+        for (int i = 0; i < verses.size(); ++i) {
+            q.addBindValue(i + 1);
+            q.addBindValue(verses.at(i));
+            q.exec();
+        }
+
+        PositionalIndex* index = PositionalIndex::instance();
+        verify(index->prepare(selfCheckConnection, CancelToken()), "near: index is built");
+
+        verify(index->find(phraseNear) == (QSet<qint64>() << PositionalIndex::verseKey(1, 1)),
+               "near: indexed distance is measured from end of phrase operand");
+        verify(index->find(chain) == (QSet<qint64>() << PositionalIndex::verseKey(1, 1)),
+               "near: indexed chain keeps positions of middle operand");
+    }
+    QSqlDatabase::removeDatabase(selfCheckConnection);
+}
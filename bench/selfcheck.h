@@ -0,0 +1,49 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SELFCHECK_H
+#define SELFCHECK_H
+
+#include <QStringList>
+
+class QTextStream;
+
+// Correctness checks of search and highlighting parts that benchmarks measure,
+// they use an in-memory database. 'saaghar-bench check' runs them.
+class SelfCheck
+{
+public:
+    explicit SelfCheck(QTextStream* log);
+
+    // returns number of failed checks
+    int run();
+
+private:
+    void checkKeywordHighlighter();
+    void checkNearClauses();
+
+    void verify(bool condition, const QString &name);
+
+    QTextStream* m_log;
+    int m_failures;
+};
+
+#endif // SELFCHECK_H
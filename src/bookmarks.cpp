@@ -44,6 +44,7 @@
 
 #include <QMessageBox>
 #include <QHeaderView>
+#include <QUrl>
 #include <QDebug>
 
 #include "bookmarks.h"
@@ -52,8 +53,14 @@
 
 const int ID_DATA = Qt::UserRole + 1;
 
+// journal is compacted into the XBEL file when it grows beyond this
+const int maxJournalEntries = 512;
+
 Bookmarks::Bookmarks(QWidget* parent)
     : QTreeWidget(parent)
+    , m_journalEntries(0)
+    , m_journalBroken(false)
+    , m_journalPaused(false)
 {
     setLayoutDirection(Qt::RightToLeft);
     setTextElideMode(Qt::ElideMiddle);
@@ -103,6 +110,8 @@ bool Bookmarks::read(QIODevice* device)
     }
 
     clear();
+    m_domElementForItem.clear();
+    m_verseItems.clear();
 
     disconnect(this, SIGNAL(itemChanged(QTreeWidgetItem*,int)),
                this, SLOT(updateDomElement(QTreeWidgetItem*,int)));
@@ -157,6 +166,17 @@ void Bookmarks::updateDomElement(QTreeWidgetItem* item, int column)
                 element.setAttribute("href", item->data(1, Qt::UserRole).toString());
             }
         }
+
+        if (!m_journalPaused) {
+            const QString itemData = item->data(0, Qt::UserRole).toString();
+            if (column == 1 && m_verseItems.contains(verseKey(itemData), item)) {
+                appendToJournal(QStringList() << "C" << itemData << item->text(1));
+            }
+            else {
+                // the journal just records changes of verse bookmarks' comments
+                m_journalBroken = true;
+            }
+        }
     }
 }
 
@@ -233,6 +253,9 @@ void Bookmarks::parseFolderElement(const QDomElement &element,
             }
             if (!metaData.isNull() && metaData.attribute("owner") == "http://saaghar.pozh.org") {
                 childItem->setData(0, Qt::UserRole, metaData.text());
+                if (id == "Verses") {
+                    m_verseItems.insert(verseKey(metaData.text()), childItem);
+                }
             }
             else {
                 qDebug() << "This DOM-NODE SHOULD deleted--->" << title;
@@ -310,44 +333,29 @@ QStringList Bookmarks::bookmarkList(const QString &type)
     return bookmarkedItemList;
 }
 
+bool Bookmarks::isBookmarked(int poemID, int verseOrder) const
+{
+    return m_verseItems.contains(qMakePair(poemID, verseOrder));
+}
+
+Bookmarks::VerseKey Bookmarks::verseKey(const QString &itemData)
+{
+    const int separator = itemData.indexOf(QLatin1Char('|'));
+    return qMakePair(itemData.left(separator).toInt(), itemData.mid(separator + 1).toInt());
+}
+
 bool Bookmarks::updateBookmarkState(const QString &type, const QVariant &data, bool state)
 {
     if (type == "Verses" || type == tr("Verses")) {
-        QDomElement verseNode = findChildNode("folder", "Verses");
-        if (verseNode.isNull()) {
-            QDomElement root = m_domDocument.createElement("folder");
-            QDomElement child = m_domDocument.createElement("title");
-            QDomText newTitleText = m_domDocument.createTextNode(tr("Verses"));
-            root.setAttribute("folded", "no");
-            child.appendChild(newTitleText);
-            root.appendChild(child);
-            m_domDocument.documentElement().appendChild(root);
-            verseNode = root;
-            parseFolderElement(root);
-        }
+        const QStringList dataList = data.toStringList();
 
-        QTreeWidgetItem* parentItem = m_domElementForItem.key(verseNode);
         //REMOVE OPERATION
         if (!state) {
-            int countOfChildren = parentItem->childCount();
-            int numOfDel = 0;
             bool allMatchedRemoved = true;
-            for (int i = 0; i < countOfChildren; ++i) {
-                QTreeWidgetItem* childItem = parentItem->child(i);
-                if (!childItem) {
-                    continue;
-                }
-
-                if (childItem->data(0, Qt::UserRole).toString() == data.toStringList().at(0) + "|" + data.toStringList().at(1)) {
-                    ++numOfDel;
-
-                    if (unBookmarkItem(childItem)) {
-                        --i; //because one of children was deleted
-                        --countOfChildren;
-                    }
-                    else {
-                        allMatchedRemoved = false;
-                    }
+            const QList<QTreeWidgetItem*> items = m_verseItems.values(qMakePair(dataList.at(0).toInt(), dataList.at(1).toInt()));
+            foreach (QTreeWidgetItem* item, items) {
+                if (!unBookmarkItem(item)) {
+                    allMatchedRemoved = false;
                 }
             }
 
@@ -356,41 +364,8 @@ bool Bookmarks::updateBookmarkState(const QString &type, const QVariant &data, b
             return allMatchedRemoved;
         }
 
-        QDomElement bookmark = m_domDocument.createElement("bookmark");
-        QDomElement bookmarkTitle = m_domDocument.createElement("title");
-        QDomElement bookmarkDescription = m_domDocument.createElement("desc");
-        QDomElement bookmarkInfo = m_domDocument.createElement("info");
-        QDomElement infoMetaData = m_domDocument.createElement("metadata");
-
-        infoMetaData.setAttribute("owner", "http://saaghar.pozh.org");
-        QDomText bookmarkSaagharMetadata = m_domDocument.createTextNode(data.toStringList().at(0) + "|" + data.toStringList().at(1));
-        infoMetaData.appendChild(bookmarkSaagharMetadata);
-        bookmarkInfo.appendChild(infoMetaData);
-        bookmark.appendChild(bookmarkTitle);
-        bookmark.appendChild(bookmarkDescription);
-        bookmark.appendChild(bookmarkInfo);
-        verseNode.appendChild(bookmark);
-
-        qDebug() << data << state;
-        QDomElement firstChild = m_domDocument.documentElement().firstChildElement("folder");
-        firstChild.text();
-        QTreeWidgetItem* item = createItem(bookmark, parentItem);
-        item->setIcon(0, m_bookmarkIcon);
-
-        QString title = data.toStringList().at(2);
-        item->setText(0, title);
-        item->setToolTip(0, title);
-        item->setData(0, Qt::UserRole, data.toStringList().at(0) + "|" + data.toStringList().at(1));
-        item->setData(1, Qt::UserRole, data.toStringList().at(3));
-        if (data.toStringList().size() == 5) {
-            item->setText(1, data.toStringList().at(4));
-            item->setToolTip(1, data.toStringList().at(4));
-        }
-
-        if (parentItem->childCount() == 1) {
-            resizeColumnToContents(0);
-            resizeColumnToContents(1);
-        }
+        addVerseBookmark(dataList);
+        appendToJournal(QStringList() << "A" << dataList);
 
         return true;
     }
@@ -399,6 +374,205 @@ bool Bookmarks::updateBookmarkState(const QString &type, const QVariant &data, b
     return false;
 }
 
+QTreeWidgetItem* Bookmarks::addVerseBookmark(const QStringList &data)
+{
+    QDomElement verseNode = findChildNode("folder", "Verses");
+    if (verseNode.isNull()) {
+        QDomElement root = m_domDocument.createElement("folder");
+        QDomElement child = m_domDocument.createElement("title");
+        QDomText newTitleText = m_domDocument.createTextNode(tr("Verses"));
+        root.setAttribute("folded", "no");
+        child.appendChild(newTitleText);
+        root.appendChild(child);
+        m_domDocument.documentElement().appendChild(root);
+        verseNode = root;
+        parseFolderElement(root);
+    }
+
+    QTreeWidgetItem* parentItem = m_domElementForItem.key(verseNode);
+
+    QDomElement bookmark = m_domDocument.createElement("bookmark");
+    QDomElement bookmarkTitle = m_domDocument.createElement("title");
+    QDomElement bookmarkDescription = m_domDocument.createElement("desc");
+    QDomElement bookmarkInfo = m_domDocument.createElement("info");
+    QDomElement infoMetaData = m_domDocument.createElement("metadata");
+
+    infoMetaData.setAttribute("owner", "http://saaghar.pozh.org");
+    QDomText bookmarkSaagharMetadata = m_domDocument.createTextNode(data.at(0) + "|" + data.at(1));
+    infoMetaData.appendChild(bookmarkSaagharMetadata);
+    bookmarkInfo.appendChild(infoMetaData);
+    bookmark.appendChild(bookmarkTitle);
+    bookmark.appendChild(bookmarkDescription);
+    bookmark.appendChild(bookmarkInfo);
+    verseNode.appendChild(bookmark);
+
+    // filling the item updates its DOM element, that's not a change of its own
+    const bool journalPaused = m_journalPaused;
+    m_journalPaused = true;
+
+    QTreeWidgetItem* item = createItem(bookmark, parentItem);
+    item->setIcon(0, m_bookmarkIcon);
+
+    QString title = data.at(2);
+    item->setText(0, title);
+    item->setToolTip(0, title);
+    item->setData(0, Qt::UserRole, data.at(0) + "|" + data.at(1));
+    item->setData(1, Qt::UserRole, data.at(3));
+    if (data.size() == 5) {
+        item->setText(1, data.at(4));
+        item->setToolTip(1, data.at(4));
+    }
+
+    m_journalPaused = journalPaused;
+
+    m_verseItems.insert(qMakePair(data.at(0).toInt(), data.at(1).toInt()), item);
+
+    if (parentItem->childCount() == 1) {
+        resizeColumnToContents(0);
+        resizeColumnToContents(1);
+    }
+
+    return item;
+}
+
+void Bookmarks::removeItem(QTreeWidgetItem* item, bool notify)
+{
+    QDomElement elementForRemoving = m_domElementForItem.take(item);
+    if (!elementForRemoving.isNull()) {
+        elementForRemoving.parentNode().removeChild(elementForRemoving);
+    }
+
+    const QString itemData = item->data(0, Qt::UserRole).toString();
+    m_verseItems.remove(verseKey(itemData), item);
+
+    if (notify) {
+        QString text = item->text(0);
+
+        int newLineIndex = text.indexOf("\n") + 1;
+        int secondNewLineIndex = text.indexOf("\n", newLineIndex);
+        int length = secondNewLineIndex > 0 ? secondNewLineIndex - newLineIndex : text.size() - newLineIndex;
+        text = text.mid(newLineIndex, length);
+
+        QString type = item->data(0, ID_DATA).toString();
+        if (type.isEmpty()) {
+            //old files that their 'folder' tags don't use 'id' attribute
+            // just contain 'folder' tags of type 'Verses'!
+            type = "Verses";
+        }
+        emit showBookmarkedItem(type, text, itemData, false, true);
+    }
+
+    delete item;
+}
+
+void Bookmarks::setJournalFile(const QString &fileName)
+{
+    if (m_journal.isOpen()) {
+        m_journal.close();
+    }
+
+    m_journal.setFileName(fileName);
+    m_journalEntries = 0;
+    m_journalBroken = false;
+
+    replayJournal();
+
+    if (!m_journal.open(QFile::WriteOnly | QFile::Append)) {
+        qDebug() << "Can not open bookmarks journal:" << m_journal.errorString();
+    }
+}
+
+bool Bookmarks::needsCompaction() const
+{
+    return m_journalBroken || !m_journal.isOpen() || m_journalEntries > maxJournalEntries;
+}
+
+void Bookmarks::clearJournal()
+{
+    if (m_journal.isOpen()) {
+        m_journal.resize(0);
+    }
+
+    m_journalEntries = 0;
+    m_journalBroken = false;
+}
+
+void Bookmarks::appendToJournal(const QStringList &record)
+{
+    if (m_journalPaused) {
+        return;
+    }
+    if (!m_journal.isOpen()) {
+        m_journalBroken = true;
+        return;
+    }
+
+    // one record per line, fields are percent-encoded so they never contain tabs or newlines
+    QByteArray line;
+    for (int i = 0; i < record.size(); ++i) {
+        if (i > 0) {
+            line += '\t';
+        }
+        line += QUrl::toPercentEncoding(record.at(i));
+    }
+    line += '\n';
+
+    if (m_journal.write(line) != line.size() || !m_journal.flush()) {
+        m_journalBroken = true;
+    }
+    ++m_journalEntries;
+}
+
+void Bookmarks::replayJournal()
+{
+    if (!m_journal.open(QFile::ReadOnly)) {
+        return;
+    }
+
+    m_journalPaused = true;
+
+    while (!m_journal.atEnd()) {
+        const QByteArray line = m_journal.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QStringList fields;
+        foreach (const QByteArray &field, line.split('\t')) {
+            fields << QUrl::fromPercentEncoding(field);
+        }
+        ++m_journalEntries;
+
+        const QString op = fields.at(0);
+        if (op == "A" && fields.size() >= 5) {
+            // the XBEL file may already contain it when saving was interrupted
+            // before the journal was cleared
+            if (!m_verseItems.contains(verseKey(fields.at(1) + "|" + fields.at(2)))) {
+                addVerseBookmark(fields.mid(1));
+            }
+        }
+        else if (op == "R" && fields.size() == 2) {
+            const QList<QTreeWidgetItem*> items = m_verseItems.values(verseKey(fields.at(1)));
+            if (!items.isEmpty()) {
+                removeItem(items.first(), false);
+            }
+        }
+        else if (op == "C" && fields.size() == 3) {
+            foreach (QTreeWidgetItem* item, m_verseItems.values(verseKey(fields.at(1)))) {
+                item->setText(1, fields.at(2));
+                item->setToolTip(1, fields.at(2));
+            }
+        }
+        else {
+            qDebug() << "Invalid bookmarks journal record:" << line;
+            m_journalBroken = true;
+        }
+    }
+
+    m_journalPaused = false;
+    m_journal.close();
+}
+
 void Bookmarks::doubleClicked(QTreeWidgetItem* item, int column)
 {
     //setFlag() emits itemChanged() SIGNAL!
@@ -476,37 +650,25 @@ bool Bookmarks::unBookmarkItem(QTreeWidgetItem* item)
         }
     }
     if (deleteItem) {
-        if (!elementForRemoving.isNull()) {
-            elementForRemoving.parentNode().removeChild(elementForRemoving);
+        const QString itemData = item->data(0, Qt::UserRole).toString();
+        if (m_verseItems.contains(verseKey(itemData), item)) {
+            appendToJournal(QStringList() << "R" << itemData);
         }
-
-        QString text = item->text(0);
-
-        int newLineIndex = text.indexOf("\n") + 1;
-        int secondNewLineIndex = text.indexOf("\n", newLineIndex);
-        int length = secondNewLineIndex > 0 ? secondNewLineIndex - newLineIndex : text.size() - newLineIndex;
-        text = text.mid(newLineIndex, length);
-
-        QString type = item->data(0, ID_DATA).toString();
-        if (type.isEmpty()) {
-            //old files that their 'folder' tags don't use 'id' attribute
-            // just contain 'folder' tags of type 'Verses'!
-            type = "Verses";
+        else {
+            m_journalBroken = true;
         }
-        emit showBookmarkedItem(type, text, item->data(0, Qt::UserRole).toString(), false, true);
-        delete item;
-        item = 0;
+
+        removeItem(item);
     }
     return deleteItem;
 }
 
 void Bookmarks::insertBookmarkList(const QVariantList &list)
 {
-    QStringList bookmarkedData = bookmarkList("Verses");
     for (int i = 0; i < list.size(); ++i) {
         QStringList data = list.at(i).toStringList();
 
-        if (!bookmarkedData.contains(data.at(0) + "|" + data.at(1))) {
+        if (!isBookmarked(data.at(0).toInt(), data.at(1).toInt())) {
             updateBookmarkState("Verses", list.at(i), true);
         }
 
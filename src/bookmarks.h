@@ -46,8 +46,10 @@
 #define BOOKMARKS_H
 
 #include <QDomDocument>
+#include <QFile>
 #include <QHash>
 #include <QIcon>
+#include <QPair>
 #include <QTreeWidget>
 
 class Bookmarks : public QTreeWidget
@@ -62,6 +64,13 @@ public:
     bool updateBookmarkState(const QString &type, const QVariant &data, bool state);
     QStringList bookmarkList(const QString &type);
     void insertBookmarkList(const QVariantList &list);
+    bool isBookmarked(int poemID, int verseOrder) const;
+
+    // changes are appended to a journal file and replayed on top of the XBEL
+    // file, so the whole document is written just when the journal is compacted
+    void setJournalFile(const QString &fileName);
+    bool needsCompaction() const;
+    void clearJournal();
 
 private slots:
     bool unBookmarkItem(QTreeWidgetItem* item = 0);
@@ -75,8 +84,22 @@ private:
                             QTreeWidgetItem* parentItem = 0, const QString &elementID = QString());
     QTreeWidgetItem* createItem(const QDomElement &element,
                                 QTreeWidgetItem* parentItem = 0, const QString &elementID = QString());
+    QTreeWidgetItem* addVerseBookmark(const QStringList &data);
+    void removeItem(QTreeWidgetItem* item, bool notify = true);
+
+    void appendToJournal(const QStringList &record);
+    void replayJournal();
+
+    typedef QPair<int, int> VerseKey;
+    static VerseKey verseKey(const QString &itemData);
 
     QDomDocument m_domDocument;
+    // (poem id, verse order) of bookmarks within 'Verses' folder
+    QMultiHash<VerseKey, QTreeWidgetItem*> m_verseItems;
+    QFile m_journal;
+    int m_journalEntries;
+    bool m_journalBroken;
+    bool m_journalPaused;
     QHash<QTreeWidgetItem*, QDomElement> m_domElementForItem;
     QIcon m_folderIcon;
     QIcon m_bookmarkIcon;
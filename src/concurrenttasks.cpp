@@ -25,20 +25,94 @@
 #include "progressmanager.h"
 #include "saagharapplication.h"
 #include "futureprogress.h"
+#include "corpusexporter.h"
+#include "corpusstatistics.h"
+#include "searchresultcache.h"
+#include "searchpatternmanager.h"
+#include "positionalindex.h"
+#include "trigramindex.h"
+#include "searchplanner.h"
+#include "poempack.h"
+#include "tracer.h"
 
 #include <QMetaType>
 #include <QNetworkReply>
 #include <QThread>
 #include <QThreadPool>
 #include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrentMap>
 
 #define TASK_CANCELED if (isCanceled()) return QVariant();
 
+// when indexes select rows of fewer poems, rows are fetched by poem id instead of a LIKE scan
+const int maxCandidatePoems = 4096;
+
+// verses of one poem, used by database clean up
+struct PoemVerses {
+    int poemID;
+    QStringList verses;
+};
+
+// number of leading spaces that all verses of the poem have in common
+static int commonIndentation(const PoemVerses &poem)
+{
+    int minStartingSpace = -1;
+    foreach (const QString &verse, poem.verses) {
+        int spaces = 0;
+        while (spaces < verse.size() && verse.at(spaces) == QLatin1Char(' ')) {
+            ++spaces;
+        }
+
+        if (spaces < minStartingSpace || minStartingSpace == -1) {
+            minStartingSpace = spaces;
+        }
+        if (minStartingSpace == 0) {
+            break;
+        }
+    }
+
+    return qMax(0, minStartingSpace);
+}
+
+// the checkpoint file keeps the database file and the last poem id that its clean up is committed
+static int readCleanupCheckpoint(const QString &fileName, const QString &databaseFile)
+{
+    QFile file(fileName);
+    if (fileName.isEmpty() || !file.open(QFile::ReadOnly | QFile::Text)) {
+        return 0;
+    }
+
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    const QString checkpointDatabase = in.readLine();
+    const int lastPoemID = in.readLine().toInt();
+
+    return checkpointDatabase == databaseFile ? lastPoemID : 0;
+}
+
+static void writeCleanupCheckpoint(const QString &fileName, const QString &databaseFile, int lastPoemID)
+{
+    QFile file(fileName);
+    if (fileName.isEmpty() || !file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        return;
+    }
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << databaseFile << "\n" << lastPoemID << "\n";
+}
+
 ConcurrentTask::ConcurrentTask(QObject* parent)
     : QObject(parent),
       QRunnable(),
-      m_cancel(false),
-      m_displayFullNotification(sApp->displayFullNotification() && sApp->notificationPosition() != ProgressManager::Disabled),
+      m_taskType(Search),
+      m_lane(-1),
+      // headless tools (e.g. saaghar-bench) don't run a SaagharApplication
+      m_displayFullNotification(qobject_cast<SaagharApplication*>(qApp) &&
+                                sApp->displayFullNotification() && sApp->notificationPosition() != ProgressManager::Disabled),
       m_progressObject(0),
       m_futureProgress(0),
       m_isQueued(false),
@@ -53,33 +127,75 @@ ConcurrentTask::~ConcurrentTask()
 {
 }
 
-void ConcurrentTask::start(const QString &type, const QVariantHash &argumants, bool queued)
+QString ConcurrentTask::typeName(Type type)
 {
-    if (type != "SEARCH" && type != "UPDATE" && type != "DB_CLEANUP") {
-        return;
+    switch (type) {
+    case Search:
+        return QLatin1String("SEARCH");
+    case Update:
+        return QLatin1String("UPDATE");
+    case DatabaseCleanup:
+        return QLatin1String("DB_CLEANUP");
+    case Export:
+        return QLatin1String("EXPORT");
+    case Statistics:
+        return QLatin1String("STATISTICS");
+    case Pack:
+        return QLatin1String("DB_PACK");
     }
 
+    return QString();
+}
+
+void ConcurrentTask::start(Type type, const QVariantHash &argumants, bool queued)
+{
     if (ConcurrentTaskManager::instance()->isAllTaskCanceled()) {
         return;
     }
 
-    m_type = type;
+    m_taskType = type;
+    m_type = typeName(type);
     m_options = argumants;
     m_isQueued = queued;
 
-    m_shouldPrependTask = type == "UPDATE" && VAR_GET(m_options, checkByUser).toBool();
+    const bool checkByUser = type == Update && VAR_GET(m_options, checkByUser).toBool();
+
+    if (m_lane < 0) {
+        switch (type) {
+        case Search:
+            m_lane = Interactive;
+            break;
+        case Update:
+            m_lane = checkByUser ? Interactive : Prefetch;
+            break;
+        case DatabaseCleanup:
+        case Export:
+        case Statistics:
+        case Pack:
+            m_lane = Maintenance;
+            break;
+        }
+    }
 
     if (sApp->notificationPosition() != ProgressManager::Disabled) {
         m_progressObject = new QFutureInterface<void>;
 
-        ProgressManager::ProgressFlags progressFlags = m_shouldPrependTask
+        ProgressManager::ProgressFlags progressFlags = checkByUser
                 ? (ProgressManager::ShowInApplicationIcon | ProgressManager::PrependInsteadAppend)
                 : ProgressManager::ShowInApplicationIcon;
 
-        m_futureProgress = sApp->progressManager()->addTimedTask(*m_progressObject,
-                           VAR_GET(m_options, taskTitle).toString(),
-                           m_type, 5,
-                           progressFlags);
+        if (m_taskType == Export || m_taskType == DatabaseCleanup || m_taskType == Statistics) {
+            // export, clean up and statistics report their real progress
+            m_futureProgress = sApp->progressManager()->addTask(m_progressObject->future(),
+                               VAR_GET(m_options, taskTitle).toString(),
+                               m_type, progressFlags);
+        }
+        else {
+            m_futureProgress = sApp->progressManager()->addTimedTask(*m_progressObject,
+                               VAR_GET(m_options, taskTitle).toString(),
+                               m_type, 5,
+                               progressFlags);
+        }
 
         connect(m_futureProgress, SIGNAL(canceled()), this, SLOT(setCanceled()));
         connect(m_searchUiObject, SIGNAL(cancelProgress()), m_futureProgress, SLOT(cancel()));
@@ -88,14 +204,15 @@ void ConcurrentTask::start(const QString &type, const QVariantHash &argumants, b
     ConcurrentTaskManager::instance()->addConcurrentTask(this);
 
     if (!m_isQueued) {
-        sApp->tasksThreadPool()->start(this, (m_shouldPrependTask ? 1 : 0));
+        enqueue();
     }
 }
 
 #ifdef SAAGHAR_DEBUG
-void ConcurrentTask::directStart(const QString &type, const QVariantHash &argumants)
+void ConcurrentTask::directStart(Type type, const QVariantHash &argumants)
 {
-    m_type = type;
+    m_taskType = type;
+    m_type = typeName(type);
     m_options = argumants;
     qint64 start = QDateTime::currentMSecsSinceEpoch();
 
@@ -108,29 +225,33 @@ void ConcurrentTask::directStart(const QString &type, const QVariantHash &arguma
 }
 #endif
 
+void ConcurrentTask::enqueue()
+{
+    m_enqueueTimer.start();
+    sApp->tasksThreadPool()->start(this, m_lane);
+}
+
 void ConcurrentTask::run()
 {
-    const qint64 start = QDateTime::currentMSecsSinceEpoch();
+    const qint64 waited = m_enqueueTimer.elapsed();
+    QElapsedTimer runTimer;
+    runTimer.start();
 
+    // interactive tasks should not be starved by the lowered priority of background ones
     QThread::Priority prio = QThread::currentThread()->priority();
     prio = prio == QThread::InheritPriority ? QThread::NormalPriority : prio;
-    sApp->setPriority(QThread::currentThread());
+    if (m_lane == Interactive) {
+        QThread::currentThread()->setPriority(QThread::NormalPriority);
+    }
+    else {
+        sApp->setPriority(QThread::currentThread());
+    }
 
     if (m_progressObject) {
         m_progressObject->reportStarted();
     }
 
-    QVariant result;
-
-    if (m_type == "SEARCH") {
-        result = startSearch(m_options);
-    }
-    else if (m_type == "UPDATE") {
-        result = checkForUpdates();
-    }
-    else if (m_type == "DB_CLEANUP") {
-        result = cleanUpDatabase();
-    }
+    const QVariant result = execute();
 
     if (m_progressObject) {
         m_progressObject->reportFinished();
@@ -140,31 +261,70 @@ void ConcurrentTask::run()
 
     QThread::currentThread()->setPriority(prio);
 
-    const int duration = QDateTime::currentMSecsSinceEpoch() - start;
+    const qint64 duration = runTimer.elapsed();
 #ifdef SAAGHAR_DEBUG
-    qDebug() << __LINE__ << __FUNCTION__ << duration;
+    qDebug() << __LINE__ << __FUNCTION__ << m_type << "waited:" << waited << "ran:" << duration;
 #endif
 
+    ConcurrentTaskManager::instance()->recordLatency(m_taskType, waited, duration, isCanceled());
+
     emit concurrentResultReady(m_type, result);
+}
 
+QVariant ConcurrentTask::exec(Type type, const QVariantHash &argumants)
+{
+    m_taskType = type;
+    m_type = typeName(type);
+    m_options = argumants;
+
+    return execute();
+}
 
-    if (duration < 20) {
-        QThread::msleep(20 - duration);
+QVariant ConcurrentTask::execute()
+{
+    QVariant result;
+
+    switch (m_taskType) {
+    case Search: {
+        TRACE_SPAN("task", "SEARCH");
+        result = startSearch(m_options);
+        break;
+    }
+    case Update: {
+        TRACE_SPAN("task", "UPDATE");
+        result = checkForUpdates();
+        break;
+    }
+    case DatabaseCleanup: {
+        TRACE_SPAN("task", "DB_CLEANUP");
+        result = cleanUpDatabase();
+        break;
+    }
+    case Export: {
+        TRACE_SPAN("task", "EXPORT");
+        result = exportCorpus();
+        break;
+    }
+    case Statistics: {
+        TRACE_SPAN("task", "STATISTICS");
+        result = buildStatistics();
+        break;
     }
-    else if (duration < 50) {
-        QThread::msleep(20);
+    case Pack: {
+        TRACE_SPAN("task", "DB_PACK");
+        result = packDatabase();
+        break;
     }
-    else if (duration < 100) {
-        QThread::msleep(10);
     }
+
+    return result;
 }
 
 void ConcurrentTask::startQueued()
 {
     if (m_isQueued) {
         m_isQueued = false;
-        sApp->tasksThreadPool()->start(this, (m_shouldPrependTask ? 1 : 0));
-        sApp->processEvents();
+        enqueue();
     }
 }
 
@@ -173,70 +333,233 @@ QVariant ConcurrentTask::startSearch(const QVariantHash &options)
     TASK_CANCELED;
 
     const QString &theConnectionID = VAR_GET(options, connectionID).toString();
-    const QString &connectionID = sApp->databaseBrowser()->getIdForDataBase(sApp->databaseBrowser()->databaseFileFromID(theConnectionID), QThread::currentThread());
+    const QString &connectionID = DatabaseBrowser::instance()->getIdForDataBase(DatabaseBrowser::instance()->databaseFileFromID(theConnectionID), QThread::currentThread());
     const QString &strQuery = VAR_GET(options, strQuery).toString();
     const QString &currentSelectionPath = VAR_GET(options, currentSelectionPath).toString();
     const QStringList &phraseList = VAR_GET(options, phraseList).toStringList();
     const QStringList &excludedList = VAR_GET(options, excludedList).toStringList();
     const QStringList &excludeWhenCleaning = VAR_GET(options, excludeWhenCleaning).toStringList();
+    const QString &cacheKey = VAR_GET(options, cacheKey).toString();
+    const int cacheGeneration = VAR_GET(options, cacheGeneration).toInt();
+    const int approximateDistance = VAR_GET(options, approximateDistance).toInt();
 
     SearchResults searchResults;
 
-    QSqlDatabase threadDatabase = sApp->databaseBrowser()->database(connectionID);
+    if (!cacheKey.isEmpty() && SearchResultCache::instance()->find(cacheKey, &searchResults)) {
+        if (m_displayFullNotification) {
+            emit searchStatusChanged(DatabaseBrowser::tr("Last-Search Result(s): %1").arg(searchResults.size()));
+        }
+
+        return QVariant::fromValue(searchResults);
+    }
+
+    QSqlDatabase threadDatabase = DatabaseBrowser::instance()->database(connectionID);
     if (!threadDatabase.isOpen()) {
         qDebug() << QString("ConcurrentTask::startSearch: A database for thread %1 could not be opened!").arg(QString::number((quintptr)QThread::currentThread()));
         return QVariant();
     }
 
+    DatabaseBrowser::setQueryOnly(connectionID, true);
+
     int andedPhraseCount = phraseList.size();
     int excludedCount = excludedList.size();
     int numOfFounded = 0;
 
+    // exact phrases and NEAR clauses, and all plain phrases of an approximate search,
+    // are evaluated by token positions. the positional index is built just for NEAR
+    // clauses and approximate search, exact phrases are verified row by row.
+    // a plain phrase of an approximate search matches as a substring too, so
+    // its close variants don't select candidate rows
+    QVector<PositionalClause> positionalClauses(andedPhraseCount);
+    QVector<bool> isPositional(andedPhraseCount, false);
+    QVector<bool> isApproximate(andedPhraseCount, false);
+    bool needsPositionalIndex = false;
+    for (int t = 0; t < andedPhraseCount; ++t) {
+        isPositional[t] = SearchPatternManager::positionalClause(phraseList.at(t), &positionalClauses[t], approximateDistance > 0);
+        isApproximate[t] = isPositional.at(t) && approximateDistance > 0 &&
+                           !SearchPatternManager::positionalClause(phraseList.at(t));
+        needsPositionalIndex = needsPositionalIndex ||
+                               (isPositional.at(t) && (positionalClauses.at(t).operands.size() > 1 || approximateDistance > 0));
+    }
+
+    // titles are not indexed, they are checked row by row
+    bool usePositionalIndex = false;
+    bool hasPositionalMatches = false;
+    QSet<qint64> positionalMatches;
+    QVector<QSet<qint64> > approximateMatches(andedPhraseCount);
+    if (needsPositionalIndex && currentSelectionPath != "ALL_TITLES") {
+        TRACE_SPAN("search", "positional index");
+
+        usePositionalIndex = PositionalIndex::instance()->prepare(connectionID, m_cancelToken);
+
+        TASK_CANCELED;
+
+        for (int t = 0; usePositionalIndex && t < andedPhraseCount; ++t) {
+            if (!isPositional.at(t)) {
+                continue;
+            }
+
+            const QSet<qint64> matches = PositionalIndex::instance()->find(positionalClauses.at(t), approximateDistance);
+            if (isApproximate.at(t)) {
+                approximateMatches[t] = matches;
+            }
+            else if (!hasPositionalMatches) {
+                positionalMatches = matches;
+                hasPositionalMatches = true;
+            }
+            else {
+                positionalMatches.intersect(matches);
+            }
+        }
+    }
+
     TASK_CANCELED;
 
-    QSqlQuery q(threadDatabase);
+    // literal parts of other phrases select candidate rows, the phrases are verified row by row.
+    // when spaces are removed from searched text (rhyme search) the index text doesn't match it
+    bool useTrigramIndex = false;
+    QSet<qint64> trigramMatches;
+    if (excludeWhenCleaning.contains(" ")) {
+        QStringList indexablePhrases;
+        for (int t = 0; t < andedPhraseCount; ++t) {
+            if ((!isPositional.at(t) || (!usePositionalIndex && positionalClauses.at(t).operands.size() == 1 && approximateDistance == 0)) &&
+                    TrigramIndex::isIndexable(phraseList.at(t))) {
+                indexablePhrases << phraseList.at(t);
+            }
+        }
 
-#ifdef SAAGHAR_DEBUG
-    int start = QDateTime::currentDateTime().toTime_t() * 1000 + QDateTime::currentDateTime().time().msec();
-#endif
+        if (!indexablePhrases.isEmpty()) {
+            TRACE_SPAN("search", "trigram index");
 
-    q.exec(strQuery);
+            const TrigramIndex::Table table = (currentSelectionPath == "ALL_TITLES" ? TrigramIndex::Titles : TrigramIndex::Verses);
+            useTrigramIndex = TrigramIndex::instance()->prepare(table, connectionID, m_cancelToken) &&
+                              TrigramIndex::instance()->find(table, indexablePhrases, &trigramMatches);
+        }
+    }
 
-#ifdef SAAGHAR_DEBUG
-    int end = QDateTime::currentDateTime().toTime_t() * 1000 + QDateTime::currentDateTime().time().msec();
-    int miliSec = end - start;
-    qDebug() << "duration=" << miliSec;
-#endif
+    TASK_CANCELED;
+
+    QString candidatesQuery = strQuery;
+    const QSet<qint64>* candidates = 0;
+    if (useTrigramIndex) {
+        candidates = &trigramMatches;
+    }
+    if (hasPositionalMatches && (!candidates || positionalMatches.size() < candidates->size())) {
+        candidates = &positionalMatches;
+    }
+
+    if (candidates && !candidates->isEmpty()) {
+        QSet<int> poemIDs;
+        foreach (qint64 key, *candidates) {
+            poemIDs.insert(int(key >> 32));
+            if (poemIDs.size() > maxCandidatePoems) {
+                break;
+            }
+        }
+
+        if (poemIDs.size() <= maxCandidatePoems) {
+            QStringList ids;
+            foreach (int id, poemIDs) {
+                ids << QString::number(id);
+            }
+
+            if (currentSelectionPath == "ALL") {
+                candidatesQuery = QString("SELECT poem_id, text, vorder FROM verse WHERE poem_id IN (%1) ORDER BY poem_id").arg(ids.join(","));
+            }
+            else if (currentSelectionPath == "ALL_TITLES") {
+                candidatesQuery = QString("SELECT id, title FROM poem WHERE id IN (%1) ORDER BY id").arg(ids.join(","));
+            }
+            else {
+                candidatesQuery = QString("SELECT poem_id, text, vorder FROM verse WHERE poem_id IN (%1) AND poem_id IN (SELECT id FROM poem WHERE cat_id IN (%2)) ORDER BY poem_id").arg(ids.join(",")).arg(currentSelectionPath);
+            }
+        }
+    }
+
+    QSqlQuery q(threadDatabase);
+
+    // there is nothing to find when an index has no candidate
+    const bool hasCandidates = !candidates || !candidates->isEmpty();
+
+    // a poem pack is scanned in place instead of running the query
+    const PoemPack* pack = DatabaseBrowser::poemPack(connectionID);
+    QSet<int> scannedCats;
+    QSet<int> scannedPoems;
+    if (pack) {
+        if (currentSelectionPath != "ALL" && currentSelectionPath != "ALL_TITLES") {
+            foreach (const QString &catID, currentSelectionPath.split(",", QString::SkipEmptyParts)) {
+                scannedCats.insert(catID.trimmed().toInt());
+            }
+        }
+        if (candidates) {
+            foreach (qint64 key, *candidates) {
+                scannedPoems.insert(int(key >> 32));
+            }
+        }
+    }
+    else if (hasCandidates) {
+        TRACE_SPAN("search", "search query");
+        q.exec(candidatesQuery);
+    }
+    PoemPack::Scanner scanner(pack, currentSelectionPath == "ALL_TITLES", scannedCats, scannedPoems);
+    const bool useNormalizedText = pack && pack->hasNormalizedText() && excludeWhenCleaning == (QStringList() << " ");
+
+    // cheap and selective phrases reject a row first, rhyme and radif that load
+    // verses of the poem are checked last
+    const QList<int> filterOrder = SearchPlanner::filterOrder(phraseList, connectionID,
+                                   currentSelectionPath == "ALL_TITLES", approximateDistance > 0);
 
     int numOfNearResult = 0;
     int nextStep = 0;
     const int updateLenght = 217;
 
     int lastPoemID = -1;
-    QList<GanjoorVerse*> verses;
+    QVector<GanjoorVerse> verses;
 
     TASK_CANCELED
 
-    while (q.next()) {
+    while (pack ? (hasCandidates && scanner.next()) : q.next()) {
         TASK_CANCELED
 
         ++numOfNearResult;
 
-        QSqlRecord qrec = q.record();
-        int poemID = qrec.value(0).toInt();
+        int poemID;
+        QString verseText;
+        int verseOrder;
+        if (pack) {
+            poemID = scanner.poemID();
+            verseText = scanner.text();
+            verseOrder = scanner.verseOrder();
+        }
+        else {
+            QSqlRecord qrec = q.record();
+            poemID = qrec.value(0).toInt();
 
 //          if (idList.contains(poemID))
 //              continue;//we need just first result
 
-        QString verseText = qrec.value(1).toString();
+            verseText = qrec.value(1).toString();
 
-        // assume title's order is zero!
-        int verseOrder = (currentSelectionPath == "ALL_TITLES" ? 0 : qrec.value(2).toInt());
+            // assume title's order is zero!
+            verseOrder = (currentSelectionPath == "ALL_TITLES" ? 0 : qrec.value(2).toInt());
+        }
 
-        QString foundVerse = Tools::cleanStringFast(verseText, excludeWhenCleaning);
+        const qint64 verseKey = PositionalIndex::verseKey(poemID, verseOrder);
+        if ((hasPositionalMatches && !positionalMatches.contains(verseKey)) ||
+                (useTrigramIndex && !trigramMatches.contains(verseKey))) {
+            continue;
+        }
 
-        // for whole word option when word is in the start or end of verse
-        foundVerse = " " + foundVerse + " ";
+        QString foundVerse;
+        if (useNormalizedText) {
+            // it's padded already
+            foundVerse = scanner.normalizedText();
+        }
+        else {
+            foundVerse = Tools::cleanStringFast(verseText, excludeWhenCleaning);
+
+            // for whole word option when word is in the start or end of verse
+            foundVerse = " " + foundVerse + " ";
+        }
 
         //excluded list
         bool excludeCurrentVerse = false;
@@ -248,46 +571,70 @@ QVariant ConcurrentTask::startSearch(const QVariantHash &options)
         }
 
         if (!excludeCurrentVerse) {
-            for (int t = 0; t < andedPhraseCount; ++t) {
+            QStringList verseTokens;
+            for (int f = 0; f < andedPhraseCount; ++f) {
+                const int t = filterOrder.at(f);
+                if (isApproximate.at(t)) {
+                    // close variants of phrase's words, otherwise the phrase itself is checked below
+                    bool approximateMatch;
+                    if (usePositionalIndex) {
+                        approximateMatch = approximateMatches.at(t).contains(verseKey);
+                    }
+                    else {
+                        if (verseTokens.isEmpty()) {
+                            verseTokens = PositionalIndex::tokenize(verseText);
+                        }
+                        approximateMatch = PositionalIndex::matches(verseTokens, positionalClauses.at(t), approximateDistance);
+                    }
+
+                    if (approximateMatch) {
+                        continue;
+                    }
+                }
+                else if (isPositional.at(t)) {
+                    if (usePositionalIndex) {
+                        continue;
+                    }
+
+                    if (verseTokens.isEmpty()) {
+                        verseTokens = PositionalIndex::tokenize(verseText);
+                    }
+                    if (!PositionalIndex::matches(verseTokens, positionalClauses.at(t), approximateDistance)) {
+                        excludeCurrentVerse = true;
+                        break;
+                    }
+                    continue;
+                }
+
                 QString tphrase = phraseList.at(t);
                 if (tphrase.contains("==")) {
                     tphrase.remove("==");
                     if (lastPoemID != poemID/* && findRhyme*/) {
                         lastPoemID = poemID;
-                        int versesSize = verses.size();
-                        for (int j = 0; j < versesSize; ++j) {
-                            delete verses[j];
-                            verses[j] = 0;
-                        }
 
                         TASK_CANCELED;
 
-                        verses = sApp->databaseBrowser()->getVerses(poemID, connectionID);
+                        verses = DatabaseBrowser::instance()->verses(poemID, connectionID);
                     }
 
                     TASK_CANCELED;
 
-                    excludeCurrentVerse = !sApp->databaseBrowser()->isRadif(verses, tphrase, verseOrder);
+                    excludeCurrentVerse = !DatabaseBrowser::instance()->isRadif(verses, tphrase, verseOrder);
                     break;
                 }
                 if (tphrase.contains("=")) {
                     tphrase.remove("=");
                     if (lastPoemID != poemID/* && findRhyme*/) {
                         lastPoemID = poemID;
-                        int versesSize = verses.size();
-                        for (int j = 0; j < versesSize; ++j) {
-                            delete verses[j];
-                            verses[j] = 0;
-                        }
 
                         TASK_CANCELED;
 
-                        verses = sApp->databaseBrowser()->getVerses(poemID, connectionID);
+                        verses = DatabaseBrowser::instance()->verses(poemID, connectionID);
                     }
 
                     TASK_CANCELED;
 
-                    excludeCurrentVerse = !sApp->databaseBrowser()->isRhyme(verses, tphrase, verseOrder);
+                    excludeCurrentVerse = !DatabaseBrowser::instance()->isRhyme(verses, tphrase, verseOrder);
                     break;
                 }
                 if (!tphrase.contains("%")) {
@@ -340,10 +687,10 @@ QVariant ConcurrentTask::startSearch(const QVariantHash &options)
             emit searchStatusChanged(DatabaseBrowser::tr("Search Result(s): %1").arg(numOfFounded));
         }
 
-        GanjoorPoem gPoem = sApp->databaseBrowser()->getPoem(poemID, connectionID);
+        GanjoorPoem gPoem = DatabaseBrowser::instance()->getPoem(poemID, connectionID);
 
         // TODO: Add connectionID to item
-        searchResults.insertMulti(poemID, "verseText=" + verseText + "|poemTitle=" + gPoem._Title + "|poetName=" + sApp->databaseBrowser()->getPoetForCat(gPoem._CatID, connectionID)._Name);
+        searchResults.insertMulti(poemID, "verseText=" + verseText + "|poemTitle=" + gPoem._Title + "|poetName=" + DatabaseBrowser::instance()->getPoetForCat(gPoem._CatID, connectionID)._Name);
     }
 
     //for the last result
@@ -351,10 +698,12 @@ QVariant ConcurrentTask::startSearch(const QVariantHash &options)
         emit searchStatusChanged(DatabaseBrowser::tr("Last-Search Result(s): %1").arg(numOfFounded));
     }
 
-    qDeleteAll(verses);
-
     TASK_CANCELED;
 
+    if (!cacheKey.isEmpty()) {
+        SearchResultCache::instance()->insert(cacheKey, searchResults, cacheGeneration);
+    }
+
     return QVariant::fromValue(searchResults);
 }
 
@@ -411,82 +760,369 @@ QVariant ConcurrentTask::cleanUpDatabase()
 {
     TASK_CANCELED;
 
-    static const QRegExp startSpaceRegExp("^ +");
     const QString &theConnectionID = VAR_GET(m_options, connectionID).toString();
-    const QString &connectionID = sApp->databaseBrowser()->getIdForDataBase(sApp->databaseBrowser()->databaseFileFromID(theConnectionID), QThread::currentThread());
+    const QString &databaseFile = sApp->databaseBrowser()->databaseFileFromID(theConnectionID);
+    const QString &connectionID = sApp->databaseBrowser()->getIdForDataBase(databaseFile, QThread::currentThread());
+    const QString &checkpointFile = VAR_GET(m_options, checkpointFile).toString();
+
+    // thread's connection may be used by search tasks before
+    DatabaseBrowser::setQueryOnly(connectionID, false);
 
     QSqlDatabase threadDatabase = sApp->databaseBrowser()->database(connectionID);
-    if (!threadDatabase.isOpen() || !threadDatabase.transaction()) {
-        qDebug() << QString("ConcurrentTask::cleanUpDatabase: A database for thread %1 could not be opened or transaction can not be began!").arg(QString::number((quintptr)QThread::currentThread()));
+    if (!threadDatabase.isOpen()) {
+        qDebug() << QString("ConcurrentTask::cleanUpDatabase: A database for thread %1 could not be opened!").arg(QString::number((quintptr)QThread::currentThread()));
         return QVariant();
     }
 
     QSqlQuery q(threadDatabase);
-    QSqlQuery vq(threadDatabase);
-
-    const QString TATWEEL = "ـ";
-    QString strQuery = QString("UPDATE verse SET text=REPLACE(text, \'%1\', \'\') WHERE text LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(text, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
-    q.exec(strQuery);
-    strQuery = QString("UPDATE poem SET title=REPLACE(title, \'%1\', \'\') WHERE title LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(title, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
-    q.exec(strQuery);
-    strQuery = QString("UPDATE cat SET text=REPLACE(text, \'%1\', \'\') WHERE text LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(text, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
-    q.exec(strQuery);
-    strQuery = QString("UPDATE poet SET name=REPLACE(name, \'%1\', \'\') WHERE name LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(name, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
-    q.exec(strQuery);
-
-    q.exec("SELECT id FROM poem");
-    QSqlRecord qrec;
-    QSqlRecord vqrec;
-    while (q.next()) {
-        qrec = q.record();
-        int poemID = qrec.value(0).toInt();
-        strQuery = QString("SELECT text FROM verse WHERE poem_id=%1").arg(poemID);
-
-        vq.exec(strQuery);
-        int minStartingSpace = -1;
-        while (vq.next()) {
-            vqrec = vq.record();
-            QString verse = vqrec.value(0).toString();
-            if (startSpaceRegExp.indexIn(verse) >= 0) {
-                const QString cap1 = startSpaceRegExp.cap(0);
-                int capSize = cap1.size();
-                if (capSize < minStartingSpace || minStartingSpace == -1) {
-                    minStartingSpace = capSize;
-                }
+    bool databaseChanged = false;
+
+    // set-based fixes, they are fast and run within their own transaction
+    if (threadDatabase.transaction()) {
+        const QString TATWEEL = "ـ";
+        QString strQuery = QString("UPDATE verse SET text=REPLACE(text, \'%1\', \'\') WHERE text LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(text, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
+        q.exec(strQuery);
+        databaseChanged = databaseChanged || q.numRowsAffected() > 0;
+        strQuery = QString("UPDATE poem SET title=REPLACE(title, \'%1\', \'\') WHERE title LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(title, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
+        q.exec(strQuery);
+        databaseChanged = databaseChanged || q.numRowsAffected() > 0;
+        strQuery = QString("UPDATE cat SET text=REPLACE(text, \'%1\', \'\') WHERE text LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(text, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
+        q.exec(strQuery);
+        databaseChanged = databaseChanged || q.numRowsAffected() > 0;
+        strQuery = QString("UPDATE poet SET name=REPLACE(name, \'%1\', \'\') WHERE name LIKE \'%%1%\' AND LENGTH(REPLACE(REPLACE(name, \'%1\', \'\'), \' \', \'\')) > 1").arg(TATWEEL);
+        q.exec(strQuery);
+        databaseChanged = databaseChanged || q.numRowsAffected() > 0;
+
+        if (!threadDatabase.commit()) {
+            threadDatabase.rollback();
+            databaseChanged = false;
+        }
+    }
 
-                if (minStartingSpace == 0) {
-                    break;
-                }
+    // poems are cleaned up batch by batch in id order, each batch is committed
+    // on its own so the write lock is held shortly and a canceled or
+    // interrupted clean up continues from the last committed batch
+    int lastPoemID = readCleanupCheckpoint(checkpointFile, databaseFile);
+
+    int total = 0;
+    int done = 0;
+    q.exec(QString("SELECT COUNT(id), SUM(id <= %1) FROM poem").arg(lastPoemID));
+    if (q.next()) {
+        total = q.value(0).toInt();
+        done = q.value(1).toInt();
+    }
+    q.finish();
+
+    if (m_progressObject) {
+        m_progressObject->setProgressRange(0, total);
+        m_progressObject->setProgressValue(done);
+    }
+
+    const int batchSize = 256;
+    const qint64 startTime = QDateTime::currentMSecsSinceEpoch();
+    int cleaned = 0;
+    bool finished = false;
+
+    QSqlQuery updateQuery(threadDatabase);
+    updateQuery.prepare("UPDATE verse SET text=SUBSTR(text, ?) WHERE poem_id=?");
+
+    while (!isCanceled()) {
+        QList<PoemVerses> batch;
+        QHash<int, int> indexOfPoem;
+        q.exec(QString("SELECT id FROM poem WHERE id > %1 ORDER BY id LIMIT %2").arg(lastPoemID).arg(batchSize));
+        while (q.next()) {
+            PoemVerses poem;
+            poem.poemID = q.value(0).toInt();
+            indexOfPoem.insert(poem.poemID, batch.size());
+            batch << poem;
+        }
+
+        if (batch.isEmpty()) {
+            finished = true;
+            break;
+        }
+
+        // batch's ids are consecutive poem ids, so verse table is read once and in poem order
+        q.exec(QString("SELECT poem_id, text FROM verse WHERE poem_id BETWEEN %1 AND %2 ORDER BY poem_id")
+               .arg(batch.first().poemID).arg(batch.last().poemID));
+        while (q.next()) {
+            const int index = indexOfPoem.value(q.value(0).toInt(), -1);
+            if (index >= 0) {
+                batch[index].verses << q.value(1).toString();
+            }
+        }
+        q.finish();
+
+        // computing fixes is CPU bound and runs on global pool, writing stays serial
+        const QList<int> indentations = QtConcurrent::blockingMapped<QList<int> >(batch, commonIndentation);
+
+        if (!threadDatabase.transaction()) {
+            qDebug() << "ConcurrentTask::cleanUpDatabase: transaction can not be began!" << threadDatabase.lastError().text();
+            break;
+        }
+
+        for (int i = 0; i < batch.size(); ++i) {
+            if (indentations.at(i) > 0) {
+                updateQuery.addBindValue(indentations.at(i) + 1);
+                updateQuery.addBindValue(batch.at(i).poemID);
+                updateQuery.exec();
+                databaseChanged = true;
+            }
+        }
+
+        if (!threadDatabase.commit()) {
+            threadDatabase.rollback();
+            break;
+        }
+
+        lastPoemID = batch.last().poemID;
+        writeCleanupCheckpoint(checkpointFile, databaseFile, lastPoemID);
+
+        done += batch.size();
+        cleaned += batch.size();
+
+        if (m_progressObject) {
+            const qint64 elapsed = qMax(Q_INT64_C(1), QDateTime::currentMSecsSinceEpoch() - startTime);
+            m_progressObject->setProgressValueAndText(done, tr("%1 poems/s").arg(cleaned * 1000 / elapsed));
+        }
+    }
+
+    updateQuery.finish();
+
+    if (finished && !checkpointFile.isEmpty()) {
+        QFile::remove(checkpointFile);
+    }
+
+    if (databaseChanged) {
+        QMetaObject::invokeMethod(sApp->databaseBrowser(), "databaseUpdated", Qt::QueuedConnection, Q_ARG(QString, theConnectionID));
+    }
+
+    if (m_futureProgress && isCanceled()) {
+        m_futureProgress->setTitle(tr("Clean Up Database: %1").arg(tr("Canceled by user")));
+    }
+
+    return cleaned;
+}
+
+QVariant ConcurrentTask::exportCorpus()
+{
+    TASK_CANCELED;
+
+    const QString &theConnectionID = VAR_GET(m_options, connectionID).toString();
+    const QString &connectionID = sApp->databaseBrowser()->getIdForDataBase(sApp->databaseBrowser()->databaseFileFromID(theConnectionID), QThread::currentThread());
+    const int catID = VAR_GET(m_options, catID).toInt();
+    const CorpusExporter::Format format = (CorpusExporter::Format)VAR_GET(m_options, format).toInt();
+    const bool singleFile = VAR_GET(m_options, singleFile).toBool();
+    const QString &outputPath = VAR_GET(m_options, outputPath).toString();
+    const QString &documentTitle = VAR_GET(m_options, documentTitle).toString();
+
+    CorpusExporter::Style style;
+    style.fontFamily = VAR_GET(m_options, fontFamily).toString();
+    style.color = VAR_GET(m_options, fontColor).toString();
+    style.pointSize = VAR_GET(m_options, fontSize).toInt();
+    style.bold = VAR_GET(m_options, fontBold).toBool();
+
+    if (!sApp->databaseBrowser()->database(connectionID).isOpen()) {
+        qDebug() << QString("ConcurrentTask::exportCorpus: A database for thread %1 could not be opened!").arg(QString::number((quintptr)QThread::currentThread()));
+        return tr("The database could not be opened.");
+    }
+
+    DatabaseBrowser::setQueryOnly(connectionID, true);
+
+    const QList<GanjoorPoem> poems = sApp->databaseBrowser()->getPoemsOfSubtree(catID, connectionID);
+    const int total = poems.size();
+
+    if (m_progressObject) {
+        m_progressObject->setProgressRange(0, total);
+    }
+
+    QFile singleOutput(outputPath);
+    QTextStream singleStream;
+    if (singleFile) {
+        if (!singleOutput.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+            return tr("%1 could not be opened for writing:\n%2").arg(outputPath, singleOutput.errorString());
+        }
+
+        singleStream.setDevice(&singleOutput);
+        singleStream.setCodec("UTF-8");
+        singleStream << CorpusExporter::documentHeader(documentTitle, format, style);
+    }
+    else if (!QDir().mkpath(outputPath)) {
+        return tr("The directory %1 could not be created.").arg(outputPath);
+    }
+
+    // poems are loaded and rendered batch by batch to keep memory usage bounded
+    const int batchSize = 64;
+    const qint64 startTime = QDateTime::currentMSecsSinceEpoch();
+    int exported = 0;
+    int failed = 0;
+    QString failedFile;
+
+    for (int i = 0; i < total && !isCanceled(); i += batchSize) {
+        const QList<GanjoorPoem> batch = poems.mid(i, batchSize);
+
+        QList<int> ids;
+        foreach (const GanjoorPoem &poem, batch) {
+            ids << poem._ID;
+        }
+
+        const QMap<int, QList<GanjoorVerse> > verses = sApp->databaseBrowser()->getVersesOfPoems(ids, connectionID);
+
+        QList<CorpusExporter::PoemData> batchData;
+        foreach (const GanjoorPoem &poem, batch) {
+            CorpusExporter::PoemData data;
+            data.poem = poem;
+            data.verses = verses.value(poem._ID);
+            batchData << data;
+        }
+
+        // rendering is CPU bound and runs on global pool, writing stays serial
+        const QStringList rendered = QtConcurrent::blockingMapped<QStringList>(batchData, CorpusExporter::Renderer(format));
+
+        for (int j = 0; j < rendered.size(); ++j) {
+            if (singleFile) {
+                singleStream << rendered.at(j);
             }
             else {
-                minStartingSpace = 0;
-                break;
+                const GanjoorPoem &poem = batch.at(j);
+                QFile file(outputPath + "/" + CorpusExporter::poemFileName(poem, format));
+                if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+                    if (failed++ == 0) {
+                        failedFile = QString("%1: %2").arg(file.fileName(), file.errorString());
+                    }
+                    continue;
+                }
+
+                QTextStream out(&file);
+                out.setCodec("UTF-8");
+                out << CorpusExporter::documentHeader(poem._Title, format, style)
+                    << rendered.at(j)
+                    << CorpusExporter::documentFooter(format);
+            }
+
+            ++exported;
+        }
+
+        if (m_progressObject) {
+            const qint64 elapsed = qMax(Q_INT64_C(1), QDateTime::currentMSecsSinceEpoch() - startTime);
+            m_progressObject->setProgressValueAndText(exported, tr("%1 poems/s").arg(exported * 1000 / elapsed));
+        }
+    }
+
+    if (singleFile) {
+        singleStream << CorpusExporter::documentFooter(format);
+        singleStream.flush();
+        if (singleOutput.error() != QFile::NoError) {
+            return tr("%1 could not be written:\n%2").arg(outputPath, singleOutput.errorString());
+        }
+        singleOutput.close();
+    }
+
+    if (m_futureProgress && isCanceled()) {
+        m_futureProgress->setTitle(tr("Export: %1").arg(tr("Canceled by user")));
+        return QVariant();
+    }
+
+    if (failed > 0) {
+        return tr("%1 of %2 poems could not be written, the first one:\n%3").arg(failed).arg(total).arg(failedFile);
+    }
+
+    return QString();
+}
+
+QVariant ConcurrentTask::buildStatistics()
+{
+    TASK_CANCELED;
+
+    const QString &theConnectionID = VAR_GET(m_options, connectionID).toString();
+    const QString databaseFile = sApp->databaseBrowser()->databaseFileFromID(theConnectionID);
+    const QString &connectionID = sApp->databaseBrowser()->getIdForDataBase(databaseFile, QThread::currentThread());
+    const QString stamp = CorpusStatistics::stamp(connectionID);
+
+    if (CorpusStatistics::cached(stamp)) {
+        return stamp;
+    }
+
+    if (!sApp->databaseBrowser()->database(connectionID).isOpen()) {
+        qDebug() << QString("ConcurrentTask::buildStatistics: A database for thread %1 could not be opened!").arg(QString::number((quintptr)QThread::currentThread()));
+        return QVariant();
+    }
+
+    const QList<GanjoorPoet> poets = sApp->databaseBrowser()->poets(connectionID, false).toList();
+    const int total = poets.size();
+
+    if (m_progressObject) {
+        m_progressObject->setProgressRange(0, total);
+    }
+
+    // each poet is counted on a worker of global pool and per poet tables are
+    // merged here, batches let progress be reported and canceling be quick
+    const int batchSize = qMax(1, QThread::idealThreadCount() * 2);
+    const qint64 startTime = QDateTime::currentMSecsSinceEpoch();
+    QSharedPointer<CorpusStatistics::Corpus> corpus(new CorpusStatistics::Corpus);
+
+    for (int i = 0; i < total && !isCanceled(); i += batchSize) {
+        const QList<CorpusStatistics::PoetStatistics> counted = QtConcurrent::blockingMapped<QList<CorpusStatistics::PoetStatistics> >(poets.mid(i, batchSize), CorpusStatistics::PoetCounter(databaseFile, m_cancelToken));
+
+        TASK_CANCELED;
+
+        {
+            TRACE_SPAN("task", "merge statistics");
+            foreach (const CorpusStatistics::PoetStatistics &poet, counted) {
+                CorpusStatistics::merge(corpus.data(), poet);
             }
         }
 
-        if (minStartingSpace > 0) {
-           strQuery = QString("UPDATE verse SET text=SUBSTR(text, %1) WHERE poem_id=%2").arg(minStartingSpace + 1).arg(poemID);
-           vq.exec(strQuery);
+        if (m_progressObject) {
+            const qint64 elapsed = qMax(Q_INT64_C(1), QDateTime::currentMSecsSinceEpoch() - startTime);
+            m_progressObject->setProgressValueAndText(qMin(total, i + batchSize), tr("%1 verses/s").arg(qint64(corpus->verses) * 1000 / elapsed));
         }
     }
 
-    if (isCanceled() || !threadDatabase.commit()) {
-        threadDatabase.rollback();
+    if (isCanceled()) {
+        if (m_futureProgress) {
+            m_futureProgress->setTitle(tr("Statistics: %1").arg(tr("Canceled by user")));
+        }
+        return QVariant();
     }
 
-    return QVariant();
+    CorpusStatistics::insert(stamp, corpus);
+
+    return stamp;
 }
 
-bool ConcurrentTask::isCanceled()
+// returns an error message, it's empty when the pack is written
+QVariant ConcurrentTask::packDatabase()
 {
-    return m_cancel;
+    TASK_CANCELED;
+
+    const QString &theConnectionID = VAR_GET(m_options, connectionID).toString();
+    const QString databaseFile = sApp->databaseBrowser()->databaseFileFromID(theConnectionID);
+    const QString &connectionID = sApp->databaseBrowser()->getIdForDataBase(databaseFile, QThread::currentThread());
+
+    if (!sApp->databaseBrowser()->database(connectionID).isOpen()) {
+        return tr("The database could not be opened.");
+    }
+
+    DatabaseBrowser::setQueryOnly(connectionID, true);
+
+    // normalized texts are cleaned by current search options
+    const QString &packFile = VAR_GET(m_options, packFile).toString();
+    QString error;
+    if (!PoemPack::write(connectionID, packFile, &error)) {
+        return error.isEmpty() ? tr("Unknown error") : error;
+    }
+
+    // the new pack is used from now on
+    PoemPack::removeOtherPacks(databaseFile, packFile);
+    PoemPack::invalidate(databaseFile);
+
+    return QString();
 }
 
 void ConcurrentTask::setCanceled()
 {
-    m_mutex.lock();
-    m_cancel = true;
-    m_mutex.unlock();
+    m_cancelToken.cancel();
 
     emit canceled();
 }
@@ -518,16 +1154,23 @@ void ConcurrentTaskManager::startQueuedTasks()
 
 void ConcurrentTaskManager::addConcurrentTask(ConcurrentTask* task)
 {
-    if (m_cancel) {
+    if (isAllTaskCanceled()) {
         return;
     }
 
+    // drop finished and deleted tasks
+    for (int i = m_tasks.size() - 1; i >= 0; --i) {
+        if (!m_tasks.at(i) || !m_tasks.at(i).data()) {
+            m_tasks.removeAt(i);
+        }
+    }
+
     m_tasks.append(TaskPointer(task));
 }
 
 void ConcurrentTaskManager::finish()
 {
-    m_cancel = true;
+    m_cancelToken.cancel();
 
     foreach (const TaskPointer &wp, m_tasks) {
         if (wp && wp.data()) {
@@ -535,23 +1178,75 @@ void ConcurrentTaskManager::finish()
         }
     }
 
+    // running tasks check their tokens frequently, so this returns soon
     sApp->tasksThreadPool()->waitForDone();
 }
 
 bool ConcurrentTaskManager::isAllTaskCanceled()
 {
-    return m_cancel;
+    return m_cancelToken.isCanceled();
 }
 
 void ConcurrentTaskManager::switchToStartState()
 {
-    m_cancel = false;
+    m_cancelToken.reset();
+}
+
+void ConcurrentTaskManager::recordLatency(ConcurrentTask::Type type, qint64 waited, qint64 ran, bool canceled)
+{
+    m_statsMutex.lock();
+
+    LatencyStats &stats = m_latencyStats[type];
+    ++stats.count;
+    if (canceled) {
+        ++stats.canceled;
+    }
+    stats.totalWait += waited;
+    stats.maxWait = qMax(stats.maxWait, waited);
+    stats.totalRun += ran;
+    stats.maxRun = qMax(stats.maxRun, ran);
+
+    m_statsMutex.unlock();
+
+    emit latencyStatsChanged();
+}
+
+QMap<int, ConcurrentTaskManager::LatencyStats> ConcurrentTaskManager::latencyStats() const
+{
+    QMutexLocker locker(&m_statsMutex);
+
+    return m_latencyStats;
+}
+
+QString ConcurrentTaskManager::latencyReport() const
+{
+    const QMap<int, LatencyStats> stats = latencyStats();
+
+    if (stats.isEmpty()) {
+        return tr("No task has been run yet.");
+    }
+
+    QStringList lines;
+    QMap<int, LatencyStats>::const_iterator it = stats.constBegin();
+    while (it != stats.constEnd()) {
+        const LatencyStats &s = it.value();
+        lines << tr("%1: %2 task(s), %3 canceled; wait avg %4 ms, max %5 ms; run avg %6 ms, max %7 ms")
+              .arg(ConcurrentTask::typeName(ConcurrentTask::Type(it.key())))
+              .arg(s.count)
+              .arg(s.canceled)
+              .arg(s.totalWait / s.count)
+              .arg(s.maxWait)
+              .arg(s.totalRun / s.count)
+              .arg(s.maxRun);
+        ++it;
+    }
+
+    return lines.join("\n");
 }
 
 ConcurrentTaskManager::ConcurrentTaskManager(QObject* parent)
     : QObject(parent),
-      m_tasks(),
-      m_cancel(false)
+      m_tasks()
 {
     connect(sApp->progressManager(), SIGNAL(allTasksCanceled()), this, SLOT(finish()));
 }
@@ -22,8 +22,12 @@
 #ifndef CONCURRENTTASKS_H
 #define CONCURRENTTASKS_H
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMap>
 #include <QMutex>
 #include <QRunnable>
+#include <QSharedPointer>
 #include <QtConcurrentRun>
 #include <QVariant>
 
@@ -35,37 +39,87 @@
 
 class FutureProgress;
 
+// A cancellation flag that can be shared between a task and its subtasks,
+// it's checked lock free from worker threads.
+class CancelToken
+{
+public:
+    CancelToken() : m_state(new QAtomicInt(0)) {}
+
+    void cancel() { m_state->fetchAndStoreOrdered(1); }
+    void reset() { m_state->fetchAndStoreOrdered(0); }
+    bool isCanceled() const { return m_state->fetchAndAddOrdered(0) != 0; }
+
+private:
+    QSharedPointer<QAtomicInt> m_state;
+};
+
 class ConcurrentTask : public QObject, QRunnable
 {
     Q_OBJECT
 
 public:
+    enum Type {
+        Search,
+        Update,
+        DatabaseCleanup,
+        Export,
+        Statistics,
+        Pack
+    };
+
+    // used as thread pool priority, so higher lanes are served first
+    enum Lane {
+        Maintenance = 0,
+        Prefetch = 1,
+        Interactive = 2
+    };
+
     explicit ConcurrentTask(QObject* parent = 0);
     ~ConcurrentTask();
 
-    void start(const QString &type, const QVariantHash &argumants = QVariantHash(), bool queued = false);
+    void start(Type type, const QVariantHash &argumants = QVariantHash(), bool queued = false);
 
 #ifdef SAAGHAR_DEBUG
-    void directStart(const QString &type, const QVariantHash &argumants = QVariantHash());
+    void directStart(Type type, const QVariantHash &argumants = QVariantHash());
 #endif
 
     void run();
+    // runs the task in the calling thread without progress and queueing and returns
+    // its result, search tasks don't need a SaagharApplication (e.g. in saaghar-bench)
+    QVariant exec(Type type, const QVariantHash &argumants);
 
     void startQueued();
 
+    // overrides the default lane of task type, must be called before start()
+    void setLane(Lane lane) { m_lane = lane; }
+    Lane lane() const { return Lane(m_lane); }
+
+    CancelToken cancelToken() const { return m_cancelToken; }
+
+    static QString typeName(Type type);
+
 public slots:
     void setCanceled();
 
 private:
-    bool isCanceled();
+    bool isCanceled() const { return m_cancelToken.isCanceled(); }
+    void enqueue();
+    QVariant execute();
+
     QVariant startSearch(const QVariantHash &options);
     QVariant checkForUpdates();
     QVariant cleanUpDatabase();
+    QVariant exportCorpus();
+    QVariant buildStatistics();
+    QVariant packDatabase();
 
-    QMutex m_mutex;
+    Type m_taskType;
     QString m_type;
+    int m_lane;
     QVariantHash m_options;
-    bool m_cancel;
+    CancelToken m_cancelToken;
+    QElapsedTimer m_enqueueTimer;
 
     bool m_displayFullNotification;
 
@@ -73,7 +127,6 @@ private:
     FutureProgress* m_futureProgress;
 
     bool m_isQueued;
-    bool m_shouldPrependTask;
 
     QObject* m_searchUiObject;
 
@@ -97,9 +150,28 @@ public:
     bool isAllTaskCanceled();
     void switchToStartState();
 
+    struct LatencyStats {
+        LatencyStats() : count(0), canceled(0), totalWait(0), maxWait(0), totalRun(0), maxRun(0) {}
+
+        int count;
+        int canceled;
+        qint64 totalWait;
+        qint64 maxWait;
+        qint64 totalRun;
+        qint64 maxRun;
+    };
+
+    // 'waited' is the time spent in queue and 'ran' is the execution time (ms)
+    void recordLatency(ConcurrentTask::Type type, qint64 waited, qint64 ran, bool canceled);
+    QMap<int, LatencyStats> latencyStats() const;
+    QString latencyReport() const;
+
 public slots:
     void finish();
 
+signals:
+    void latencyStatsChanged();
+
 private:
     Q_DISABLE_COPY(ConcurrentTaskManager)
     ConcurrentTaskManager(QObject* parent = 0);
@@ -112,7 +184,10 @@ private:
 #endif
 
     QList<TaskPointer> m_tasks;
-    bool m_cancel;
+    CancelToken m_cancelToken;
+
+    mutable QMutex m_statsMutex;
+    QMap<int, LatencyStats> m_latencyStats;
 };
 
 #endif // CONCURRENTTASKS_H
@@ -0,0 +1,237 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "corpusexporter.h"
+#include "version.h"
+
+#if QT_VERSION < 0x050000
+#include <QTextDocument>
+#endif
+
+static QString htmlEscaped(const QString &text)
+{
+#if QT_VERSION >= 0x050000
+    return text.toHtmlEscaped();
+#else
+    return Qt::escape(text);
+#endif
+}
+
+QString CorpusExporter::suffix(Format format)
+{
+    switch (format) {
+    case HtmlFormat:
+        return QLatin1String("html");
+    case TeXFormat:
+        return QLatin1String("tex");
+    case TextFormat:
+    default:
+        return QLatin1String("txt");
+    }
+}
+
+CorpusExporter::Format CorpusExporter::formatFromSuffix(const QString &suffix)
+{
+    if (suffix.compare(QLatin1String("html"), Qt::CaseInsensitive) == 0) {
+        return HtmlFormat;
+    }
+    else if (suffix.compare(QLatin1String("tex"), Qt::CaseInsensitive) == 0) {
+        return TeXFormat;
+    }
+
+    return TextFormat;
+}
+
+QString CorpusExporter::poemFileName(const GanjoorPoem &poem, Format format)
+{
+    return QString("%1.%2").arg(poem._ID).arg(suffix(format));
+}
+
+QString CorpusExporter::renderPoem(const PoemData &data, Format format)
+{
+    switch (format) {
+    case HtmlFormat:
+        return renderHtmlBody(data);
+    case TeXFormat:
+        return renderTeXBody(data);
+    case TextFormat:
+    default:
+        return renderTextBody(data);
+    }
+}
+
+QString CorpusExporter::documentHeader(const QString &title, Format format, const Style &style)
+{
+    switch (format) {
+    case HtmlFormat:
+        return QString("<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 3.2//EN\">\n<HTML>\n<HEAD>\n"
+                       "<META HTTP-EQUIV=\"CONTENT-TYPE\" CONTENT=\"text/html; charset=utf-8\">\n"
+                       "<TITLE>%1</TITLE>\n<META NAME=\"GENERATOR\" CONTENT=\"Saaghar, a Persian poetry "
+                       "software, http://saaghar.pozh.org\">\n</HEAD>\n\n"
+                       "<BODY DIR=RTL STYLE=\"FONT-FAMILY: %2; COLOR: %3; FONT-SIZE: %4pt; %5\">\n")
+               // one multi-arg call, '%n' in the title or font name is not expanded
+               .arg(htmlEscaped(title), style.fontFamily,
+                    style.color.isEmpty() ? QString("black") : style.color,
+                    QString::number(style.pointSize),
+                    style.bold ? QString("FONT-WEIGHT: bold;") : QString());
+    case TeXFormat:
+        return QString("%%%%%\n%This file is generated automatically by Saaghar %1, 2010 http://pozh.org\n%%%%%\n"
+                       "%XePersian and bidipoem packages must have been installed on your TeX distribution for compiling this document\n"
+                       "%You can compile this document by running XeLaTeX on it, twice.\n%%%%%\n"
+                       "\\documentclass{article}\n\\usepackage{hyperref}%\n\\usepackage[Kashida]{xepersian}\n\\usepackage{bidipoem}\n"
+                       "\\settextfont{%2}\n\\hypersetup{\npdftitle={%3},%\npdfsubject={Poem},%\npdfkeywords={Poem, Persian},%\n"
+                       "pdfcreator={Saaghar, a Persian poetry software, http://saaghar.pozh.org},%\npdfview=FitV,\n}\n"
+                       "\\renewcommand{\\poemcolsepskip}{1.5cm}\n\\begin{document}\n")
+               .arg(SAAGHAR_VERSION, style.fontFamily, title);
+    case TextFormat:
+    default:
+        return QString();
+    }
+}
+
+QString CorpusExporter::documentFooter(Format format)
+{
+    switch (format) {
+    case HtmlFormat:
+        return QLatin1String("</BODY>\n</HTML>\n");
+    case TeXFormat:
+        return QLatin1String("\\end{document}\n%End of document\n");
+    case TextFormat:
+    default:
+        return QString();
+    }
+}
+
+QString CorpusExporter::renderHtmlBody(const PoemData &data)
+{
+    QString tableBody;
+    const int size = data.verses.size();
+
+    for (int i = 0; i < size; ++i) {
+        const GanjoorVerse &verse = data.verses.at(i);
+        QString text = htmlEscaped(verse._Text);
+
+        switch (verse._Position) {
+        case Right:
+            if (i + 1 < size && data.verses.at(i + 1)._Position == Left) {
+                ++i;
+                tableBody += QString("<TR>\n<TD ALIGN=LEFT>%1</TD>\n<TD></TD>\n<TD ALIGN=RIGHT>%2</TD>\n</TR>\n")
+                             .arg(text, htmlEscaped(data.verses.at(i)._Text));
+            }
+            else {
+                tableBody += QString("<TR>\n<TD ALIGN=LEFT>%1</TD>\n<TD></TD>\n<TD></TD>\n</TR>\n").arg(text);
+            }
+            break;
+        case Left:
+            tableBody += QString("<TR>\n<TD></TD>\n<TD></TD>\n<TD ALIGN=RIGHT>%1</TD>\n</TR>\n").arg(text);
+            break;
+        case CenteredVerse1:
+        case CenteredVerse2:
+            tableBody += QString("<TR>\n<TD COLSPAN=3 ALIGN=CENTER>%1</TD>\n</TR>\n").arg(text);
+            break;
+        case Paragraph:
+        case Single:
+        default:
+            text.replace("  ", " &nbsp;");
+            tableBody += QString("<TR>\n<TD COLSPAN=3 ALIGN=RIGHT>%1</TD>\n</TR>\n").arg(text);
+            break;
+        }
+    }
+
+    return QString("<H3 ALIGN=CENTER>%1</H3>\n"
+                   "<TABLE ALIGN=CENTER DIR=RTL FRAME=VOID CELLSPACING=0 COLS=3 RULES=NONE BORDER=0>\n"
+                   "<TBODY>\n%2</TBODY>\n</TABLE>\n<BR>\n")
+           .arg(htmlEscaped(data.poem._Title), tableBody);
+}
+
+QString CorpusExporter::renderTeXBody(const PoemData &data)
+{
+    QString poemType = QLatin1String("traditionalpoem");
+    foreach (const GanjoorVerse &verse, data.verses) {
+        if (verse._Position == Single) {
+            poemType = QLatin1String("modernpoem");
+            break;
+        }
+    }
+
+    const QString beginEnvironment = QString("\\begin{%1}\n").arg(poemType);
+    const QString endEnvironment = QString("\\end{%1}\n").arg(poemType);
+
+    QString body = QString("\\begin{center}\n%1\\\\\n\\end{center}\n").arg(data.poem._Title);
+    bool inEnvironment = false;
+    const int size = data.verses.size();
+
+    for (int i = 0; i < size; ++i) {
+        const GanjoorVerse &verse = data.verses.at(i);
+        QString text = verse._Text;
+
+        if (verse._Position == Paragraph) {
+            if (inEnvironment) {
+                body += endEnvironment;
+                inEnvironment = false;
+            }
+            body += QString("\n%1\n\n").arg(text);
+            continue;
+        }
+
+        if (!inEnvironment) {
+            body += beginEnvironment;
+            inEnvironment = true;
+        }
+
+        if (verse._Position == Right && i + 1 < size && data.verses.at(i + 1)._Position == Left) {
+            ++i;
+            body += QString("%1 & %2 \\\\\n").arg(text, data.verses.at(i)._Text);
+        }
+        else {
+            if (verse._Position == Single) {
+                text.replace(" ", "\\ ");
+            }
+            body += QString("%1\\\\\n").arg(text);
+        }
+    }
+
+    if (inEnvironment) {
+        body += endEnvironment;
+    }
+
+    return body;
+}
+
+QString CorpusExporter::renderTextBody(const PoemData &data)
+{
+    QString body = data.poem._Title + QLatin1String("\n\n");
+    const int size = data.verses.size();
+
+    for (int i = 0; i < size; ++i) {
+        const GanjoorVerse &verse = data.verses.at(i);
+
+        if (verse._Position == Right && i + 1 < size && data.verses.at(i + 1)._Position == Left) {
+            ++i;
+            body += verse._Text + QLatin1String("          "/*ten blank spaces*/) + data.verses.at(i)._Text + QLatin1String("\n");
+        }
+        else {
+            body += verse._Text + QLatin1String("\n");
+        }
+    }
+
+    return body + QLatin1String("\n");
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CORPUSEXPORTER_H
+#define CORPUSEXPORTER_H
+
+#include "databaseelements.h"
+
+#include <QCoreApplication>
+#include <QList>
+#include <QStringList>
+
+// Renders poems straight from database elements, so it doesn't need
+// a rendered QTableWidget and can be used from worker threads.
+class CorpusExporter
+{
+    Q_DECLARE_TR_FUNCTIONS(CorpusExporter)
+
+public:
+    enum Format {
+        HtmlFormat,
+        TeXFormat,
+        TextFormat
+    };
+
+    // captured on GUI thread, fonts can not be resolved safely on workers
+    struct Style {
+        QString fontFamily;
+        QString color;
+        int pointSize;
+        bool bold;
+
+        Style() : pointSize(18), bold(false) {}
+    };
+
+    struct PoemData {
+        GanjoorPoem poem;
+        QList<GanjoorVerse> verses;
+    };
+
+    // functor for QtConcurrent::mapped()
+    struct Renderer {
+        typedef QString result_type;
+
+        Renderer(Format format) : m_format(format) {}
+        QString operator()(const PoemData &data) const { return CorpusExporter::renderPoem(data, m_format); }
+
+        Format m_format;
+    };
+
+    static QString suffix(Format format);
+    static Format formatFromSuffix(const QString &suffix);
+
+    static QString renderPoem(const PoemData &data, Format format);
+    static QString documentHeader(const QString &title, Format format, const Style &style = Style());
+    static QString documentFooter(Format format);
+
+    // poem's file name relative to export directory
+    static QString poemFileName(const GanjoorPoem &poem, Format format);
+
+private:
+    static QString renderHtmlBody(const PoemData &data);
+    static QString renderTeXBody(const PoemData &data);
+    static QString renderTextBody(const PoemData &data);
+};
+
+#endif // CORPUSEXPORTER_H
@@ -0,0 +1,240 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "corpusstatistics.h"
+#include "databasebrowser.h"
+#include "positionalindex.h"
+#include "saagharapplication.h"
+#include "searchresultcache.h"
+#include "tools.h"
+#include "tracer.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVector>
+#include <QtAlgorithms>
+
+// statistics of the last counted database
+static QMutex statisticsMutex;
+static QString cachedStamp;
+static QSharedPointer<CorpusStatistics::Corpus> cachedCorpus;
+
+// keys of the first 'maxLines' verses that have 'keyword' as a token
+static QList<qint64> scannedVerses(const QString &connectionID, const QString &keyword, int maxLines, const CancelToken &cancelToken)
+{
+    QList<qint64> keys;
+
+    QSqlQuery q(DatabaseBrowser::database(connectionID));
+    q.setForwardOnly(true);
+    q.exec("SELECT poem_id, vorder, text FROM verse ORDER BY poem_id, vorder");
+
+    int count = 0;
+    while (keys.size() < maxLines && q.next()) {
+        if (++count % 4096 == 0 && cancelToken.isCanceled()) {
+            break;
+        }
+
+        if (PositionalIndex::tokenize(q.value(2).toString()).contains(keyword)) {
+            keys << PositionalIndex::verseKey(q.value(0).toInt(), q.value(1).toInt());
+        }
+    }
+
+    return keys;
+}
+
+static bool moreFrequent(const QPair<QString, int> &first, const QPair<QString, int> &second)
+{
+    return first.second > second.second || (first.second == second.second && first.first < second.first);
+}
+
+CorpusStatistics::PoetStatistics CorpusStatistics::PoetCounter::operator()(const GanjoorPoet &poet) const
+{
+    PoetStatistics statistics;
+    statistics.poetID = poet._ID;
+    statistics.poetName = poet._Name;
+
+    if (m_cancelToken.isCanceled()) {
+        return statistics;
+    }
+
+    TRACE_SPAN("task", "count poet");
+
+    const QString connectionID = DatabaseBrowser::getIdForDataBase(m_databaseFile, QThread::currentThread());
+    DatabaseBrowser::setQueryOnly(connectionID, true);
+
+    QSqlQuery q(DatabaseBrowser::database(connectionID));
+    q.setForwardOnly(true);
+    q.exec(QString("SELECT verse.text FROM verse, poem, cat WHERE verse.poem_id = poem.id AND poem.cat_id = cat.id AND cat.poet_id = %1").arg(poet._ID));
+
+    while (q.next()) {
+        if (statistics.verses % 4096 == 0 && m_cancelToken.isCanceled()) {
+            break;
+        }
+
+        ++statistics.verses;
+
+        const QStringList tokens = PositionalIndex::tokenize(q.value(0).toString());
+        statistics.tokens += tokens.size();
+        foreach (const QString &token, tokens) {
+            ++statistics.frequencies[token];
+        }
+    }
+
+    return statistics;
+}
+
+QString CorpusStatistics::stamp(const QString &connectionID)
+{
+    return SearchResultCache::instance()->indexStamp(DatabaseBrowser::databaseFileFromID(connectionID));
+}
+
+QSharedPointer<CorpusStatistics::Corpus> CorpusStatistics::cached(const QString &stamp)
+{
+    QMutexLocker locker(&statisticsMutex);
+
+    return cachedStamp == stamp ? cachedCorpus : QSharedPointer<Corpus>();
+}
+
+void CorpusStatistics::insert(const QString &stamp, const QSharedPointer<Corpus> &corpus)
+{
+    QMutexLocker locker(&statisticsMutex);
+
+    cachedStamp = stamp;
+    cachedCorpus = corpus;
+}
+
+void CorpusStatistics::merge(Corpus* corpus, const PoetStatistics &poet)
+{
+    corpus->verses += poet.verses;
+    corpus->tokens += poet.tokens;
+
+    Frequencies::const_iterator it = poet.frequencies.constBegin();
+    while (it != poet.frequencies.constEnd()) {
+        corpus->frequencies[it.key()] += it.value();
+        ++it;
+    }
+
+    corpus->poets << poet;
+}
+
+QList<QPair<QString, int> > CorpusStatistics::topTerms(const Frequencies &frequencies, int count)
+{
+    QList<QPair<QString, int> > terms;
+    terms.reserve(frequencies.size());
+
+    Frequencies::const_iterator it = frequencies.constBegin();
+    while (it != frequencies.constEnd()) {
+        terms << qMakePair(it.key(), it.value());
+        ++it;
+    }
+
+    qSort(terms.begin(), terms.end(), moreFrequent);
+
+    return terms.mid(0, count);
+}
+
+QList<CorpusStatistics::ConcordanceLine> CorpusStatistics::concordance(const QString &connectionID, const QString &term,
+        int context, int maxLines, const CancelToken &cancelToken)
+{
+    QList<ConcordanceLine> lines;
+
+    const QString keyword = Tools::cleanString(term).trimmed();
+    if (keyword.isEmpty() || keyword.contains(QLatin1Char(' '))) {
+        return lines;
+    }
+
+    const QString threadConnectionID = DatabaseBrowser::getIdForDataBase(DatabaseBrowser::databaseFileFromID(connectionID), QThread::currentThread());
+    DatabaseBrowser::setQueryOnly(threadConnectionID, true);
+
+    // verses are selected by positional index, so a concordance costs a term lookup.
+    // a database that is too large for the index is scanned
+    QList<qint64> keys;
+    PositionalIndex* index = PositionalIndex::instance();
+    if (index->prepare(threadConnectionID, cancelToken)) {
+        PositionalClause clause;
+        clause.operands << (QStringList() << keyword);
+        keys = index->find(clause).toList();
+        qSort(keys);
+        keys = keys.mid(0, maxLines);
+    }
+    else if (!cancelToken.isCanceled()) {
+        keys = scannedVerses(threadConnectionID, keyword, maxLines, cancelToken);
+    }
+
+    if (keys.isEmpty() || cancelToken.isCanceled()) {
+        return lines;
+    }
+
+    QMap<int, QList<int> > versesOfPoems;
+    foreach (qint64 key, keys) {
+        versesOfPoems[int(key >> 32)] << int(key & 0xFFFFFFFF);
+    }
+
+    QStringList ids;
+    foreach (int poemID, versesOfPoems.keys()) {
+        ids << QString::number(poemID);
+    }
+
+    QSqlQuery q(DatabaseBrowser::database(threadConnectionID));
+    q.setForwardOnly(true);
+    q.exec(QString("SELECT poem_id, vorder, text FROM verse WHERE poem_id IN (%1) ORDER BY poem_id, vorder").arg(ids.join(",")));
+
+    int lastPoemID = -1;
+    QString poemTitle;
+    QString poetName;
+    while (q.next() && !cancelToken.isCanceled()) {
+        const int poemID = q.value(0).toInt();
+        const int verseOrder = q.value(1).toInt();
+        if (!versesOfPoems.value(poemID).contains(verseOrder)) {
+            continue;
+        }
+
+        if (poemID != lastPoemID) {
+            lastPoemID = poemID;
+            const GanjoorPoem poem = sApp->databaseBrowser()->getPoem(poemID, threadConnectionID);
+            poemTitle = poem._Title;
+            poetName = sApp->databaseBrowser()->getPoetForCat(poem._CatID, threadConnectionID)._Name;
+        }
+
+        // context is shown with original spelling of words
+        const QStringList words = q.value(2).toString().split(QLatin1Char(' '), QString::SkipEmptyParts);
+        for (int i = 0; i < words.size(); ++i) {
+            if (Tools::cleanStringFast(words.at(i), QStringList() << " ") != keyword) {
+                continue;
+            }
+
+            ConcordanceLine line;
+            line.poemID = poemID;
+            line.verseOrder = verseOrder;
+            line.left = QStringList(words.mid(qMax(0, i - context), qMin(i, context))).join(" ");
+            line.keyword = words.at(i);
+            line.right = QStringList(words.mid(i + 1, context)).join(" ");
+            line.poemTitle = poemTitle;
+            line.poetName = poetName;
+            lines << line;
+            break;
+        }
+    }
+
+    return lines;
+}
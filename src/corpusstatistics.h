@@ -0,0 +1,97 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CORPUSSTATISTICS_H
+#define CORPUSSTATISTICS_H
+
+#include "concurrenttasks.h"
+#include "databaseelements.h"
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSharedPointer>
+#include <QStringList>
+
+// Word frequencies, per poet vocabularies and concordance lines of a database.
+// Counting runs on worker threads, one poet per worker, and its result is
+// cached until any database is updated.
+class CorpusStatistics
+{
+public:
+    typedef QHash<QString, int> Frequencies;
+
+    struct PoetStatistics {
+        int poetID;
+        QString poetName;
+        int verses;
+        int tokens;
+        Frequencies frequencies;
+
+        PoetStatistics() : poetID(0), verses(0), tokens(0) {}
+    };
+
+    struct Corpus {
+        int verses;
+        int tokens;
+        Frequencies frequencies;
+        QList<PoetStatistics> poets;
+
+        Corpus() : verses(0), tokens(0) {}
+    };
+
+    // functor for QtConcurrent::mapped(), it streams verses of one poet
+    struct PoetCounter {
+        typedef PoetStatistics result_type;
+
+        PoetCounter(const QString &databaseFile, const CancelToken &cancelToken)
+            : m_databaseFile(databaseFile), m_cancelToken(cancelToken) {}
+        PoetStatistics operator()(const GanjoorPoet &poet) const;
+
+        QString m_databaseFile;
+        CancelToken m_cancelToken;
+    };
+
+    struct ConcordanceLine {
+        int poemID;
+        int verseOrder;
+        QString left;
+        QString keyword;
+        QString right;
+        QString poemTitle;
+        QString poetName;
+    };
+
+    // statistics of a database are valid while its stamp doesn't change
+    static QString stamp(const QString &connectionID);
+    static QSharedPointer<Corpus> cached(const QString &stamp);
+    static void insert(const QString &stamp, const QSharedPointer<Corpus> &corpus);
+
+    static void merge(Corpus* corpus, const PoetStatistics &poet);
+    // the most frequent terms, in descending order of frequency
+    static QList<QPair<QString, int> > topTerms(const Frequencies &frequencies, int count);
+
+    // verses that contain 'term' as a whole word with 'context' words around it, runs on a worker thread
+    static QList<ConcordanceLine> concordance(const QString &connectionID, const QString &term,
+            int context, int maxLines, const CancelToken &cancelToken);
+};
+
+#endif // CORPUSSTATISTICS_H
@@ -0,0 +1,275 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "corpusstatisticswidget.h"
+#include "databasebrowser.h"
+#include "saagharapplication.h"
+#include "tools.h"
+
+#include <QComboBox>
+#include <QFont>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSearchLineEdit>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <QtConcurrentRun>
+
+// rows of frequency table, a vocabulary has hundreds of thousands terms
+const int maxFrequencyRows = 1000;
+const int maxConcordanceLines = 2000;
+// words that are shown on each side of keyword
+const int concordanceContext = 4;
+
+CorpusStatisticsWidget::CorpusStatisticsWidget(QWidget* parent)
+    : QWidget(parent),
+      m_connectionID(DatabaseBrowser::defaultConnectionId())
+{
+    setObjectName("CorpusStatisticsWidget");
+
+    m_poetComboBox = new QComboBox(this);
+    m_poetComboBox->setEnabled(false);
+    connect(m_poetComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(showFrequencies()));
+
+    m_computeButton = new QPushButton(tr("Compute"), this);
+    connect(m_computeButton, SIGNAL(clicked()), this, SLOT(computeStatistics()));
+
+    m_summaryLabel = new QLabel(this);
+
+    m_frequencyTable = new QTableWidget(0, 2, this);
+    m_frequencyTable->setHorizontalHeaderLabels(QStringList() << tr("Word") << tr("Frequency"));
+    m_frequencyTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_frequencyTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_frequencyTable->verticalHeader()->hide();
+    m_frequencyTable->horizontalHeader()->setStretchLastSection(true);
+    connect(m_frequencyTable, SIGNAL(itemDoubleClicked(QTableWidgetItem*)), this, SLOT(frequencyDoubleClicked(QTableWidgetItem*)));
+
+    m_concordanceEdit = new QSearchLineEdit(this);
+#if QT_VERSION >= 0x040700
+    m_concordanceEdit->setPlaceholderText(tr("Concordance of a word"));
+#else
+    m_concordanceEdit->setToolTip(tr("Concordance of a word"));
+#endif
+    connect(m_concordanceEdit, SIGNAL(returnPressed()), this, SLOT(startConcordance()));
+
+    m_concordanceTable = new QTableWidget(0, 3, this);
+    m_concordanceTable->setHorizontalHeaderLabels(QStringList() << tr("Before") << tr("Word") << tr("After"));
+    m_concordanceTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_concordanceTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_concordanceTable->verticalHeader()->hide();
+    connect(m_concordanceTable, SIGNAL(itemDoubleClicked(QTableWidgetItem*)), this, SLOT(concordanceDoubleClicked(QTableWidgetItem*)));
+
+    m_concordanceWatcher = new QFutureWatcher<QList<CorpusStatistics::ConcordanceLine> >(this);
+    connect(m_concordanceWatcher, SIGNAL(finished()), this, SLOT(showConcordance()));
+
+    QHBoxLayout* toolsLayout = new QHBoxLayout;
+    toolsLayout->addWidget(m_poetComboBox, 1);
+    toolsLayout->addWidget(m_computeButton);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout;
+    mainLayout->addLayout(toolsLayout);
+    mainLayout->addWidget(m_summaryLabel);
+    mainLayout->addWidget(m_frequencyTable, 1);
+    mainLayout->addWidget(m_concordanceEdit);
+    mainLayout->addWidget(m_concordanceTable, 1);
+    setLayout(mainLayout);
+}
+
+CorpusStatisticsWidget::~CorpusStatisticsWidget()
+{
+    m_concordanceCancelToken.cancel();
+    emit cancelProgress();
+}
+
+void CorpusStatisticsWidget::setConnectionID(const QString &connectionID)
+{
+    if (m_connectionID == connectionID) {
+        return;
+    }
+
+    m_connectionID = connectionID;
+
+    // shown tables belong to the previous database
+    m_concordanceCancelToken.cancel();
+    m_corpus.clear();
+    m_poetComboBox->clear();
+    m_poetComboBox->setEnabled(false);
+    m_summaryLabel->clear();
+    m_frequencyTable->setRowCount(0);
+    m_concordanceTable->setRowCount(0);
+}
+
+void CorpusStatisticsWidget::computeStatistics()
+{
+    // statistics of an unchanged database are reused
+    QSharedPointer<CorpusStatistics::Corpus> corpus = CorpusStatistics::cached(CorpusStatistics::stamp(m_connectionID));
+    if (corpus) {
+        processStatisticsResult(ConcurrentTask::typeName(ConcurrentTask::Statistics), CorpusStatistics::stamp(m_connectionID));
+        return;
+    }
+
+    if (m_statisticsTask) {
+        return;
+    }
+
+    QVariantHash arguments;
+    const QString connectionID = m_connectionID;
+    const QString taskTitle = tr("Statistics: %1").arg(tr("Word Frequencies"));
+    VAR_ADD(arguments, connectionID);
+    VAR_ADD(arguments, taskTitle);
+
+    m_computeButton->setEnabled(false);
+    m_summaryLabel->setText(tr("Counting words..."));
+
+    m_statisticsTask = new ConcurrentTask(this);
+    connect(m_statisticsTask, SIGNAL(concurrentResultReady(QString,QVariant)), this, SLOT(processStatisticsResult(QString,QVariant)));
+    m_statisticsTask->start(ConcurrentTask::Statistics, arguments);
+}
+
+void CorpusStatisticsWidget::processStatisticsResult(const QString &type, const QVariant &results)
+{
+    Q_UNUSED(type)
+
+    // finished tasks are deleted with their parent
+    m_statisticsTask = 0;
+    m_computeButton->setEnabled(true);
+
+    m_corpus = CorpusStatistics::cached(results.toString());
+    if (!m_corpus) {
+        m_summaryLabel->setText(tr("Statistics are not available."));
+        return;
+    }
+
+    m_poetComboBox->blockSignals(true);
+    m_poetComboBox->clear();
+    m_poetComboBox->addItem(tr("All Poets"), -1);
+    for (int i = 0; i < m_corpus->poets.size(); ++i) {
+        m_poetComboBox->addItem(m_corpus->poets.at(i).poetName, i);
+    }
+    m_poetComboBox->setEnabled(true);
+    m_poetComboBox->blockSignals(false);
+
+    showFrequencies();
+}
+
+void CorpusStatisticsWidget::showFrequencies()
+{
+    if (!m_corpus) {
+        return;
+    }
+
+    const int poetIndex = m_poetComboBox->itemData(m_poetComboBox->currentIndex()).toInt();
+
+    int verses = m_corpus->verses;
+    int tokens = m_corpus->tokens;
+    const CorpusStatistics::Frequencies* frequencies = &m_corpus->frequencies;
+    if (poetIndex >= 0 && poetIndex < m_corpus->poets.size()) {
+        const CorpusStatistics::PoetStatistics &poet = m_corpus->poets.at(poetIndex);
+        verses = poet.verses;
+        tokens = poet.tokens;
+        frequencies = &poet.frequencies;
+    }
+
+    m_summaryLabel->setText(tr("Verses: %1, Words: %2, Vocabulary: %3")
+                            .arg(verses).arg(tokens).arg(frequencies->size()));
+
+    const QList<QPair<QString, int> > terms = CorpusStatistics::topTerms(*frequencies, maxFrequencyRows);
+
+    m_frequencyTable->setUpdatesEnabled(false);
+    m_frequencyTable->setRowCount(terms.size());
+    for (int i = 0; i < terms.size(); ++i) {
+        m_frequencyTable->setItem(i, 0, new QTableWidgetItem(terms.at(i).first));
+        m_frequencyTable->setItem(i, 1, new QTableWidgetItem(QString::number(terms.at(i).second)));
+    }
+    m_frequencyTable->setUpdatesEnabled(true);
+}
+
+void CorpusStatisticsWidget::frequencyDoubleClicked(QTableWidgetItem* item)
+{
+    QTableWidgetItem* wordItem = m_frequencyTable->item(item->row(), 0);
+    if (!wordItem) {
+        return;
+    }
+
+    m_concordanceEdit->setText(wordItem->text());
+    startConcordance();
+}
+
+void CorpusStatisticsWidget::startConcordance()
+{
+    // a running concordance is abandoned, its result is not shown
+    m_concordanceCancelToken.cancel();
+    m_concordanceCancelToken = CancelToken();
+
+    m_concordanceTable->setRowCount(0);
+
+    const QString term = m_concordanceEdit->text().trimmed();
+    if (term.isEmpty()) {
+        return;
+    }
+
+    m_concordanceWatcher->setFuture(QtConcurrent::run(CorpusStatistics::concordance, m_connectionID, term,
+                                    concordanceContext, maxConcordanceLines, m_concordanceCancelToken));
+}
+
+void CorpusStatisticsWidget::showConcordance()
+{
+    if (m_concordanceCancelToken.isCanceled()) {
+        return;
+    }
+
+    const QList<CorpusStatistics::ConcordanceLine> lines = m_concordanceWatcher->result();
+
+    m_concordanceTable->setUpdatesEnabled(false);
+    m_concordanceTable->setRowCount(lines.size());
+    for (int i = 0; i < lines.size(); ++i) {
+        const CorpusStatistics::ConcordanceLine &line = lines.at(i);
+        const QString toolTip = line.poetName + ": " + line.poemTitle;
+
+        QTableWidgetItem* leftItem = new QTableWidgetItem(line.left);
+        leftItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        QTableWidgetItem* keywordItem = new QTableWidgetItem(line.keyword);
+        keywordItem->setTextAlignment(Qt::AlignCenter);
+        QFont keywordFont = keywordItem->font();
+        keywordFont.setBold(true);
+        keywordItem->setFont(keywordFont);
+        QTableWidgetItem* rightItem = new QTableWidgetItem(line.right);
+
+        foreach (QTableWidgetItem* item, QList<QTableWidgetItem*>() << leftItem << keywordItem << rightItem) {
+            item->setToolTip(toolTip);
+            item->setData(Qt::UserRole, line.poemID);
+            item->setData(Qt::UserRole + 1, line.verseOrder);
+        }
+
+        m_concordanceTable->setItem(i, 0, leftItem);
+        m_concordanceTable->setItem(i, 1, keywordItem);
+        m_concordanceTable->setItem(i, 2, rightItem);
+    }
+    m_concordanceTable->resizeColumnsToContents();
+    m_concordanceTable->setUpdatesEnabled(true);
+}
+
+void CorpusStatisticsWidget::concordanceDoubleClicked(QTableWidgetItem* item)
+{
+    emit verseRequested(item->data(Qt::UserRole).toInt(), item->data(Qt::UserRole + 1).toInt(), m_connectionID);
+}
@@ -0,0 +1,83 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CORPUSSTATISTICSWIDGET_H
+#define CORPUSSTATISTICSWIDGET_H
+
+#include "corpusstatistics.h"
+
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QWidget>
+
+class QComboBox;
+class QLabel;
+class QPushButton;
+class QSearchLineEdit;
+class QTableWidget;
+class QTableWidgetItem;
+
+// Browses word frequencies of whole corpus or one poet and concordance
+// (keyword in context) lines of a word, it's the content of statistics dock.
+class CorpusStatisticsWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    CorpusStatisticsWidget(QWidget* parent = 0);
+    ~CorpusStatisticsWidget();
+
+    // statistics and concordance of the database of active tab
+    void setConnectionID(const QString &connectionID);
+
+public slots:
+    void computeStatistics();
+
+private slots:
+    void processStatisticsResult(const QString &type, const QVariant &results);
+    void showFrequencies();
+    void frequencyDoubleClicked(QTableWidgetItem* item);
+    void startConcordance();
+    void showConcordance();
+    void concordanceDoubleClicked(QTableWidgetItem* item);
+
+private:
+    QComboBox* m_poetComboBox;
+    QPushButton* m_computeButton;
+    QLabel* m_summaryLabel;
+    QTableWidget* m_frequencyTable;
+    QSearchLineEdit* m_concordanceEdit;
+    QTableWidget* m_concordanceTable;
+
+    QString m_connectionID;
+    QSharedPointer<CorpusStatistics::Corpus> m_corpus;
+    QPointer<ConcurrentTask> m_statisticsTask;
+
+    QFutureWatcher<QList<CorpusStatistics::ConcordanceLine> >* m_concordanceWatcher;
+    CancelToken m_concordanceCancelToken;
+
+signals:
+    void verseRequested(int poemID, int verseOrder, const QString &connectionID);
+    // ConcurrentTask connects it to the progress of tasks that this widget is their parent
+    void cancelProgress();
+};
+
+#endif // CORPUSSTATISTICSWIDGET_H
@@ -21,12 +21,17 @@
 
 #include "databasebrowser.h"
 #include "nodatabasedialog.h"
+#include "poempack.h"
 #include "searchresultwidget.h"
 #include "tools.h"
 #include "concurrenttasks.h"
 #include "saagharapplication.h"
 #include "settingsmanager.h"
 #include "saagharwidget.h"
+#include "searchresultcache.h"
+#include "searchpatternmanager.h"
+#include "searchplanner.h"
+#include "tracer.h"
 
 #include <QApplication>
 #include <QMessageBox>
@@ -38,14 +43,28 @@
 #include <QTimer>
 #include <QTreeWidgetItem>
 #include <QThread>
+#include <QThreadStorage>
+#include <QUrl>
+#include <QSet>
 
 DatabaseBrowser* DatabaseBrowser::s_instance = 0;
+QHash<DatabaseBrowser::ThreadFileKey, QString> DatabaseBrowser::s_connectionIds;
+QHash<QString, QString> DatabaseBrowser::s_canonicalPaths;
+QMultiHash<QString, QString> DatabaseBrowser::s_fileConnections;
 QMultiHash<QThread*, QString> DatabaseBrowser::s_threadConnections;
+QMutex DatabaseBrowser::s_connectionsMutex;
+QHash<QString, DatabaseBrowser::PreparedQueries*> DatabaseBrowser::s_preparedQueries;
+QMutex DatabaseBrowser::s_preparedQueriesMutex;
+QAtomicInt DatabaseBrowser::s_preparesCount;
+QAtomicInt DatabaseBrowser::s_preparesAvoidedCount;
+QAtomicInt DatabaseBrowser::s_evictionsCount;
+QAtomicInt DatabaseBrowser::s_schemaVersion;
 
 DataBaseUpdater* DatabaseBrowser::dbUpdater = 0;
 QString DatabaseBrowser::s_defaultConnectionId;
 QString DatabaseBrowser::s_defaultDatabaseFileName;
 bool DatabaseBrowser::s_isDefaultDatabaseSet = false;
+DatabaseBrowser::AccessMode DatabaseBrowser::s_accessMode = DatabaseBrowser::ReadWrite;
 
 const int minNewPoetID = 1001;
 const int minNewCatID = 10001;
@@ -53,6 +72,9 @@ const int minNewPoemID = 100001;
 
 const int DatabaseVersion = 1;
 
+// maximum number of prepared statements that are kept per connection
+const int maxPreparedQueries = 48;
+
 #ifdef EMBEDDED_SQLITE
 QSQLiteDriver* DatabaseBrowser::sqlDriver = 0;
 #else
@@ -64,6 +86,33 @@ static QString threadToString(QThread* thread = 0)
     return QString::number((quintptr)(thread ? thread : QThread::currentThread()));
 }
 
+// removes the connections of its thread when the thread finishes. Idle threads of
+// a thread pool are kept alive, so 'destroyed()' is emitted too late or never and
+// a new thread may even get the address of a dead one.
+class ThreadConnectionsGuard
+{
+public:
+    ~ThreadConnectionsGuard() {
+        DatabaseBrowser::removeConnectionsOfThread(QThread::currentThread());
+    }
+};
+
+static QThreadStorage<ThreadConnectionsGuard*> threadConnectionsGuard;
+
+// uniformly distributed integer in [0, bound), 'qrand()' may provide just 15 bits (RAND_MAX == 32767)
+static int uniformRandomIndex(int bound)
+{
+    const quint32 range = 1u << 30;
+    const quint32 limit = range - (range % quint32(bound));
+    quint32 r;
+    do {
+        r = ((quint32(qrand()) & 0x7FFF) << 15) | (quint32(qrand()) & 0x7FFF);
+    }
+    while (r >= limit);
+
+    return int(r % quint32(bound));
+}
+
 DatabaseBrowser::DatabaseBrowser(const QString &sqliteDbCompletePath)
 {
     Q_ASSERT(s_instance == 0);
@@ -74,6 +123,9 @@ DatabaseBrowser::DatabaseBrowser(const QString &sqliteDbCompletePath)
 
     setObjectName(QLatin1String("DatabaseBrowser"));
 
+    connect(this, SIGNAL(databaseUpdated(QString)), this, SLOT(invalidatePoemSampler(QString)));
+    connect(this, SIGNAL(databaseUpdated(QString)), this, SLOT(invalidatePoemPack(QString)));
+
     QFileInfo dBFile(sqliteDbCompletePath);
     QString pathOfDatabase = dBFile.absolutePath();
 
@@ -93,7 +145,10 @@ DatabaseBrowser::DatabaseBrowser(const QString &sqliteDbCompletePath)
 
         QString errorString = database(defaultConnectionId).lastError().text();
 
-        removeDatabase(defaultConnectionId);
+        {
+            QMutexLocker locker(&s_connectionsMutex);
+            removeConnection(defaultConnectionId);
+        }
 
         NoDataBaseDialog noDataBaseDialog(0, Qt::WindowStaysOnTopHint);
         noDataBaseDialog.ui->pathLabel->setText(tr("Data Base Path:") + " " + sqliteDbCompletePath);
@@ -182,14 +237,22 @@ DatabaseBrowser::DatabaseBrowser(const QString &sqliteDbCompletePath)
 
     s_defaultConnectionId = defaultConnectionId;
 
-    // Saaghar just uses its first search path
-    sApp->setDefaultPath(SaagharApplication::DatabaseDirs, QDir::toNativeSeparators(pathOfDatabase));
+    // Saaghar just uses its first search path, headless tools (e.g. saaghar-bench)
+    // don't run a SaagharApplication
+    if (qobject_cast<SaagharApplication*>(qApp)) {
+        sApp->setDefaultPath(SaagharApplication::DatabaseDirs, QDir::toNativeSeparators(pathOfDatabase));
+    }
 
     cachedMaxCatID = cachedMaxPoemID = 0;
 }
 
 DatabaseBrowser::~DatabaseBrowser()
 {
+#ifdef SAAGHAR_DEBUG
+    qDebug() << preparedQueriesReport();
+#endif
+
+    qDeleteAll(m_poemSamplers);
 }
 
 QString DatabaseBrowser::databaseFileFromID(const QString &connectionID)
@@ -215,6 +278,126 @@ QSqlDatabase DatabaseBrowser::database(const QString &connectionID, bool open)
     return QSqlDatabase::database(connectionID, open);
 }
 
+QSqlQuery DatabaseBrowser::preparedQuery(const QString &statement, const QString &connectionID)
+{
+    // connectionID is bound to a thread, so the cache of each connection is
+    // used from one thread and the mutex just protects the connections' hash
+    s_preparedQueriesMutex.lock();
+    PreparedQueries* prepared = s_preparedQueries.value(connectionID, 0);
+    if (!prepared) {
+        prepared = new PreparedQueries;
+        s_preparedQueries.insert(connectionID, prepared);
+    }
+    s_preparedQueriesMutex.unlock();
+
+    const int schemaVersion = s_schemaVersion.fetchAndAddOrdered(0);
+    if (prepared->schemaVersion != schemaVersion) {
+        prepared->failures.clear();
+        prepared->schemaVersion = schemaVersion;
+    }
+
+    if (prepared->failures.contains(statement)) {
+        return prepared->failures.value(statement);
+    }
+
+    bool nested = false;
+    if (prepared->queries.contains(statement)) {
+        const QSqlQuery cached = prepared->queries.value(statement);
+
+        // an active query is still used by a caller up the stack, rebinding
+        // it would reset the caller's result set
+        nested = cached.isActive();
+        if (!nested) {
+            s_preparesAvoidedCount.ref();
+
+            if (prepared->usage.last() != statement) {
+                prepared->usage.removeOne(statement);
+                prepared->usage.append(statement);
+            }
+
+            // QSqlQuery is shared, so an evicted statement remains valid for its user
+            return cached;
+        }
+    }
+
+    QSqlQuery query(database(connectionID));
+    query.setForwardOnly(true);
+    if (!query.prepare(statement)) {
+        prepared->failures.insert(statement, query);
+        return query;
+    }
+
+    s_preparesCount.ref();
+
+    if (nested) {
+        return query;
+    }
+
+    if (prepared->usage.size() >= maxPreparedQueries) {
+        prepared->queries.remove(prepared->usage.takeFirst());
+        s_evictionsCount.ref();
+    }
+
+    prepared->queries.insert(statement, query);
+    prepared->usage.append(statement);
+
+    return query;
+}
+
+QString DatabaseBrowser::preparedQueriesReport()
+{
+    const int prepares = s_preparesCount.fetchAndAddOrdered(0);
+    const int avoided = s_preparesAvoidedCount.fetchAndAddOrdered(0);
+    const int evictions = s_evictionsCount.fetchAndAddOrdered(0);
+    const int total = prepares + avoided;
+
+    return QString("prepared statements: %1 prepared, %2 reused (%3%), %4 evicted")
+           .arg(prepares)
+           .arg(avoided)
+           .arg(total > 0 ? (avoided * 100) / total : 0)
+           .arg(evictions);
+}
+
+void DatabaseBrowser::setQueryOnly(const QString &connectionID, bool queryOnly)
+{
+    QSqlQuery q(database(connectionID));
+    q.exec(QString("PRAGMA query_only = %1").arg(queryOnly ? 1 : 0));
+}
+
+void DatabaseBrowser::configureConnection(QSqlDatabase &db, bool readOnly)
+{
+    if (!db.isOpen()) {
+        return;
+    }
+
+    QSqlQuery q(db);
+    // 16 MB page cache per connection (negative values are in KiB)
+    q.exec("PRAGMA cache_size = -16384");
+    q.exec("PRAGMA temp_store = MEMORY");
+
+    // read pages directly from the mapped file instead of copying them,
+    // it's ignored by SQLite versions older than 3.7.17
+    qint64 mmapSize = Q_INT64_C(268435456);
+    if (readOnly) {
+        // map whole of the database, it doesn't grow
+        mmapSize = qMax(mmapSize, QFileInfo(s_defaultDatabaseFileName).size() + Q_INT64_C(1048576));
+        q.exec("PRAGMA query_only = 1");
+    }
+    q.exec(QString("PRAGMA mmap_size = %1").arg(mmapSize));
+}
+
+void DatabaseBrowser::schemaChanged()
+{
+    s_schemaVersion.ref();
+}
+
+void DatabaseBrowser::releasePreparedQueries(const QString &connectionID)
+{
+    QMutexLocker locker(&s_preparedQueriesMutex);
+
+    delete s_preparedQueries.take(connectionID);
+}
+
 QString DatabaseBrowser::defaultDatabasename()
 {
     return s_defaultDatabaseFileName;
@@ -226,6 +409,28 @@ void DatabaseBrowser::setDefaultDatabasename(const QString &databaseName)
     s_defaultDatabaseFileName = databaseName;
 }
 
+void DatabaseBrowser::setAccessMode(DatabaseBrowser::AccessMode mode)
+{
+    s_accessMode = mode;
+}
+
+DatabaseBrowser::AccessMode DatabaseBrowser::accessMode()
+{
+    return s_accessMode;
+}
+
+PoemPack* DatabaseBrowser::poemPack(const QString &connectionID)
+{
+    // a database that can be changed is always read by SQL, just the default
+    // database is opened read-only
+    const QString databaseFile = databaseFileFromID(connectionID);
+    if (s_accessMode == ReadWrite || databaseFile != databaseFileFromID(s_defaultConnectionId)) {
+        return 0;
+    }
+
+    return PoemPack::forDatabase(databaseFile);
+}
+
 bool DatabaseBrowser::isConnected(const QString &connectionID)
 {
     return database(connectionID, true).isOpen();
@@ -242,36 +447,37 @@ bool DatabaseBrowser::isValid(QString connectionID)
     return false;
 }
 
-QList<GanjoorPoet*> DatabaseBrowser::getPoets(const QString &connectionID, bool sort)
+QVector<GanjoorPoet> DatabaseBrowser::poets(const QString &connectionID, bool sort)
 {
-    QList<GanjoorPoet*> poets;
-    if (isConnected(connectionID)) {
-        QSqlDatabase databaseObject = database(connectionID);
+    TRACE_SPAN("db", "DatabaseBrowser::poets");
 
-        QSqlQuery q(databaseObject);
+    QVector<GanjoorPoet> poets;
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        poets = pack->poets();
+
+        if (sort) {
+            qSort(poets.begin(), poets.end(), comparePoetsByName);
+        }
+    }
+    else if (isConnected(connectionID)) {
+        QSqlQuery q = preparedQuery("SELECT id, name, cat_id, description FROM poet", connectionID);
         bool descriptionExists = false;
-        if (q.exec("SELECT id, name, cat_id, description FROM poet")) {
+        if (q.exec()) {
             descriptionExists = true;
         }
         else {
-            q.exec("SELECT id, name, cat_id FROM poet");
+            q = preparedQuery("SELECT id, name, cat_id FROM poet", connectionID);
+            q.exec();
         }
 
-        q.first();
-        while (q.isValid() && q.isActive()) {
-            GanjoorPoet* gPoet = new GanjoorPoet();
-            QSqlRecord qrec = q.record();
-            if (descriptionExists) {
-                gPoet->init(qrec.value(0).toInt(), qrec.value(1).toString(), qrec.value(2).toInt(), qrec.value(3).toString());
-            }
-            else {
-                gPoet->init(qrec.value(0).toInt(), qrec.value(1).toString(), qrec.value(2).toInt(), "");
-            }
+        GanjoorPoet gPoet;
+        while (q.next()) {
+            gPoet.init(q.value(0).toInt(), q.value(1).toString(), q.value(2).toInt(), descriptionExists ? q.value(3).toString() : QString());
             poets.append(gPoet);
-            if (!q.next()) {
-                break;
-            }
         }
+        q.finish();
+
         if (sort) {
             qSort(poets.begin(), poets.end(), comparePoetsByName);
         }
@@ -280,19 +486,28 @@ QList<GanjoorPoet*> DatabaseBrowser::getPoets(const QString &connectionID, bool
     return poets;
 }
 
-bool DatabaseBrowser::comparePoetsByName(GanjoorPoet* poet1, GanjoorPoet* poet2)
+QList<GanjoorPoet*> DatabaseBrowser::getPoets(const QString &connectionID, bool sort)
+{
+    QList<GanjoorPoet*> lst;
+    foreach (const GanjoorPoet &poet, poets(connectionID, sort)) {
+        lst.append(new GanjoorPoet(poet));
+    }
+    return lst;
+}
+
+bool DatabaseBrowser::comparePoetsByName(const GanjoorPoet &poet1, const GanjoorPoet &poet2)
 {
     static bool isEnglish = VARS("General/UILanguage") == LS("en");
 
     if (isEnglish) {
-        return (QString::localeAwareCompare(poet1->_Name, poet2->_Name) < 0);
+        return (QString::localeAwareCompare(poet1._Name, poet2._Name) < 0);
     }
     else {
-        const bool poet1IsRtl = poet1->_Name.isRightToLeft();
-        const bool poet2IsRtl = poet2->_Name.isRightToLeft();
+        const bool poet1IsRtl = poet1._Name.isRightToLeft();
+        const bool poet2IsRtl = poet2._Name.isRightToLeft();
 
         if ((poet1IsRtl && poet2IsRtl) || (!poet1IsRtl && !poet2IsRtl)) {
-            return (QString::localeAwareCompare(poet1->_Name, poet2->_Name) < 0);
+            return (QString::localeAwareCompare(poet1._Name, poet2._Name) < 0);
         }
         else {
             if (poet1IsRtl && !poet2IsRtl) {
@@ -305,19 +520,19 @@ bool DatabaseBrowser::comparePoetsByName(GanjoorPoet* poet1, GanjoorPoet* poet2)
     }
 }
 
-bool DatabaseBrowser::compareCategoriesByName(GanjoorCat* cat1, GanjoorCat* cat2)
+bool DatabaseBrowser::compareCategoriesByName(const GanjoorCat &cat1, const GanjoorCat &cat2)
 {
     static bool isEnglish = VARS("General/UILanguage") == LS("en");
 
     if (isEnglish) {
-        return (QString::localeAwareCompare(cat1->_Text, cat2->_Text) < 0);
+        return (QString::localeAwareCompare(cat1._Text, cat2._Text) < 0);
     }
     else {
-        const bool cat1IsRtl = cat1->_Text.isRightToLeft();
-        const bool cat2IsRtl = cat2->_Text.isRightToLeft();
+        const bool cat1IsRtl = cat1._Text.isRightToLeft();
+        const bool cat2IsRtl = cat2._Text.isRightToLeft();
 
         if ((cat1IsRtl && cat2IsRtl) || (!cat1IsRtl && !cat2IsRtl)) {
-            return (QString::localeAwareCompare(cat1->_Text, cat2->_Text) < 0);
+            return (QString::localeAwareCompare(cat1._Text, cat2._Text) < 0);
         }
         else {
             if (cat1IsRtl && !cat2IsRtl) {
@@ -332,11 +547,19 @@ bool DatabaseBrowser::compareCategoriesByName(GanjoorCat* cat1, GanjoorCat* cat2
 
 GanjoorCat DatabaseBrowser::getCategory(int CatID, const QString &connectionID)
 {
+    TRACE_SPAN("db", "DatabaseBrowser::getCategory");
+
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        return pack->category(CatID);
+    }
+
     GanjoorCat gCat;
     gCat.init();
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        q.exec("SELECT poet_id, text, parent_id, url FROM cat WHERE id = " + QString::number(CatID));
+        QSqlQuery q = preparedQuery("SELECT poet_id, text, parent_id, url FROM cat WHERE id = ?", connectionID);
+        q.addBindValue(CatID);
+        q.exec();
         q.first();
         if (q.isValid() && q.isActive()) {
             QSqlRecord qrec = q.record();
@@ -346,22 +569,19 @@ GanjoorCat DatabaseBrowser::getCategory(int CatID, const QString &connectionID)
                 (qrec.value(1)).toString(),
                 (qrec.value(2)).toInt(),
                 (qrec.value(3)).toString());
-            return gCat;
         }
+        q.finish();
     }
     return gCat;
 }
 
 void DatabaseBrowser::removeThreadsConnections(QObject* obj)
 {
-    QThread* thread = qobject_cast<QThread*>(obj);
+    // 'obj' is already destroyed, it's just used as a key
+    QThread* thread = static_cast<QThread*>(obj);
 
     if (thread) {
-        QStringList connections = s_threadConnections.values(thread);
-
-        foreach (const QString &connection, connections) {
-            QSqlDatabase::removeDatabase(connection);
-        }
+        removeConnectionsOfThread(thread);
 
 #ifdef SAAGHAR_DEBUG
         qDebug() << "thread destroyed:" << thread;
@@ -369,22 +589,60 @@ void DatabaseBrowser::removeThreadsConnections(QObject* obj)
     }
 }
 
-QList<GanjoorCat*> DatabaseBrowser::getSubCategories(int CatID, const QString &connectionID)
+void DatabaseBrowser::removeConnectionsOfThread(QThread* thread)
 {
-    QList<GanjoorCat*> lst;
-    if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        q.exec("SELECT poet_id, text, url, ID FROM cat WHERE parent_id = " + QString::number(CatID));
-        q.first();
-        while (q.isValid() && q.isActive()) {
-            QSqlRecord qrec = q.record();
-            GanjoorCat* gCat = new GanjoorCat();
-            gCat->init((qrec.value(3)).toInt(), (qrec.value(0)).toInt(), (qrec.value(1)).toString(), CatID, (qrec.value(2)).toString());
+    QMutexLocker locker(&s_connectionsMutex);
+
+    foreach (const QString &connectionID, s_threadConnections.values(thread)) {
+        removeConnection(connectionID);
+    }
+}
+
+// 's_connectionsMutex' must be locked by caller
+void DatabaseBrowser::removeConnection(const QString &connectionID)
+{
+    releasePreparedQueries(connectionID);
+    QSqlDatabase::removeDatabase(connectionID);
+
+    QHash<ThreadFileKey, QString>::iterator it = s_connectionIds.begin();
+    while (it != s_connectionIds.end()) {
+        if (it.value() == connectionID) {
+            s_threadConnections.remove(it.key().first, connectionID);
+            it = s_connectionIds.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    s_fileConnections.remove(databaseFileFromID(connectionID), connectionID);
+}
+
+QVector<GanjoorCat> DatabaseBrowser::subCategories(int CatID, const QString &connectionID)
+{
+    TRACE_SPAN("db", "DatabaseBrowser::subCategories");
+
+    QVector<GanjoorCat> lst;
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        lst = pack->subCategories(CatID);
+
+        if (CatID == 0) {
+            qSort(lst.begin(), lst.end(), compareCategoriesByName);
+        }
+    }
+    else if (isConnected(connectionID)) {
+        QSqlQuery q = preparedQuery("SELECT poet_id, text, url, ID FROM cat WHERE parent_id = ?", connectionID);
+        q.addBindValue(CatID);
+        q.exec();
+
+        GanjoorCat gCat;
+        while (q.next()) {
+            gCat.init(q.value(3).toInt(), q.value(0).toInt(), q.value(1).toString(), CatID, q.value(2).toString());
             lst.append(gCat);
-            if (!q.next()) {
-                break;
-            }
         }
+        q.finish();
+
         if (CatID == 0) {
             qSort(lst.begin(), lst.end(), compareCategoriesByName);
         }
@@ -392,8 +650,19 @@ QList<GanjoorCat*> DatabaseBrowser::getSubCategories(int CatID, const QString &c
     return lst;
 }
 
+QList<GanjoorCat*> DatabaseBrowser::getSubCategories(int CatID, const QString &connectionID)
+{
+    QList<GanjoorCat*> lst;
+    foreach (const GanjoorCat &cat, subCategories(CatID, connectionID)) {
+        lst.append(new GanjoorCat(cat));
+    }
+    return lst;
+}
+
 QList<GanjoorCat> DatabaseBrowser::getParentCategories(GanjoorCat Cat, const QString &connectionID)
 {
+    TRACE_SPAN("db", "DatabaseBrowser::getParentCategories");
+
     QList<GanjoorCat> lst;
     if (isConnected(connectionID)) {
         while (!Cat.isNull() && Cat._ParentID != 0) {
@@ -407,28 +676,45 @@ QList<GanjoorCat> DatabaseBrowser::getParentCategories(GanjoorCat Cat, const QSt
     return lst;
 }
 
-QList<GanjoorPoem*> DatabaseBrowser::getPoems(int CatID, const QString &connectionID)
+QVector<GanjoorPoem> DatabaseBrowser::poems(int CatID, const QString &connectionID)
 {
-    QList<GanjoorPoem*> lst;
+    TRACE_SPAN("db", "DatabaseBrowser::poems");
+
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        return pack->poems(CatID);
+    }
+
+    QVector<GanjoorPoem> lst;
     if (isConnected(connectionID)) {
-        QString selectQuery = QString("SELECT ID, title, url FROM poem WHERE cat_id = %1 ORDER BY ID").arg(CatID);
-        QSqlQuery q(database(connectionID));
-        q.exec(selectQuery);
-        q.first();
-        QSqlRecord qrec;
-        while (q.isValid() && q.isActive()) {
-            qrec = q.record();
-            GanjoorPoem* gPoem = new GanjoorPoem();
-            gPoem->init((qrec.value(0)).toInt(), CatID, (qrec.value(1)).toString(), (qrec.value(2)).toString(), false, "");
+        QSqlQuery q = preparedQuery("SELECT ID, title, url FROM poem WHERE cat_id = ? ORDER BY ID", connectionID);
+        q.addBindValue(CatID);
+        q.exec();
+
+        GanjoorPoem gPoem;
+        while (q.next()) {
+            gPoem.init(q.value(0).toInt(), CatID, q.value(1).toString(), q.value(2).toString(), false, "");
             lst.append(gPoem);
-            if (!q.next()) {
-                break;
-            }
         }
+        q.finish();
+    }
+    return lst;
+}
+
+QList<GanjoorPoem*> DatabaseBrowser::getPoems(int CatID, const QString &connectionID)
+{
+    QList<GanjoorPoem*> lst;
+    foreach (const GanjoorPoem &poem, poems(CatID, connectionID)) {
+        lst.append(new GanjoorPoem(poem));
     }
     return lst;
 }
 
+QVector<GanjoorVerse> DatabaseBrowser::verses(int PoemID, const QString &connectionID)
+{
+    return verses(PoemID, 0, connectionID);
+}
+
 QList<GanjoorVerse*> DatabaseBrowser::getVerses(int PoemID, const QString &connectionID)
 {
     return getVerses(PoemID, 0, connectionID);
@@ -436,52 +722,179 @@ QList<GanjoorVerse*> DatabaseBrowser::getVerses(int PoemID, const QString &conne
 
 QString DatabaseBrowser::getFirstMesra(int PoemID, const QString &connectionID) //just first Mesra
 {
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        const QVector<GanjoorVerse> firstVerse = pack->verses(PoemID, 1);
+        return firstVerse.isEmpty() ? QString() : Tools::snippedText(firstVerse.first()._Text, "", 0, 12, true);
+    }
+
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        QString selectQuery = QString("SELECT vorder, text FROM verse WHERE poem_id = %1 order by vorder LIMIT 1").arg(PoemID);
-        q.exec(selectQuery);
+        QSqlQuery q = preparedQuery("SELECT vorder, text FROM verse WHERE poem_id = ? order by vorder LIMIT 1", connectionID);
+        q.addBindValue(PoemID);
+        q.exec();
         q.first();
-        while (q.isValid() && q.isActive()) {
-            return Tools::snippedText(q.record().value(1).toString(), "", 0, 12, true);
+        if (q.isValid() && q.isActive()) {
+            const QString text = q.record().value(1).toString();
+            q.finish();
+            return Tools::snippedText(text, "", 0, 12, true);
         }
     }
     return QString();
 }
 
-QList<GanjoorVerse*> DatabaseBrowser::getVerses(int PoemID, int Count, const QString &connectionID)
+QVector<GanjoorVerse> DatabaseBrowser::verses(int PoemID, int Count, const QString &connectionID)
 {
-    QList<GanjoorVerse*> lst;
+    TRACE_SPAN("db", "DatabaseBrowser::verses");
+
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        return pack->verses(PoemID, Count);
+    }
+
+    QVector<GanjoorVerse> lst;
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        QString selectQuery = QString("SELECT vorder, position, text FROM verse WHERE poem_id = %1 order by vorder" + (Count > 0 ? " LIMIT " + QString::number(Count) : "")).arg(PoemID);
-        q.exec(selectQuery);
-        q.first();
-        while (q.isValid() && q.isActive()) {
-            QSqlRecord qrec = q.record();
-            GanjoorVerse* gVerse = new GanjoorVerse();
-            gVerse->init(PoemID, (qrec.value(0)).toInt(), (VersePosition)((qrec.value(1)).toInt()), (qrec.value(2)).toString());
+        QSqlQuery q = preparedQuery(Count > 0
+                                    ? "SELECT vorder, position, text FROM verse WHERE poem_id = ? order by vorder LIMIT ?"
+                                    : "SELECT vorder, position, text FROM verse WHERE poem_id = ? order by vorder", connectionID);
+        q.addBindValue(PoemID);
+        if (Count > 0) {
+            q.addBindValue(Count);
+            lst.reserve(Count);
+        }
+        q.exec();
+
+        GanjoorVerse gVerse;
+        while (q.next()) {
+            gVerse.init(PoemID, q.value(0).toInt(), (VersePosition)(q.value(1).toInt()), q.value(2).toString());
             lst.append(gVerse);
-            if (!q.next()) {
-                break;
-            }
         }
+        q.finish();
+    }
+    return lst;
+}
+
+QList<GanjoorVerse*> DatabaseBrowser::getVerses(int PoemID, int Count, const QString &connectionID)
+{
+    QList<GanjoorVerse*> lst;
+    foreach (const GanjoorVerse &verse, verses(PoemID, Count, connectionID)) {
+        lst.append(new GanjoorVerse(verse));
     }
     return lst;
 }
 
+QList<GanjoorPoem> DatabaseBrowser::getPoemsOfSubtree(int CatID, const QString &connectionID)
+{
+    TRACE_SPAN("db", "DatabaseBrowser::getPoemsOfSubtree");
+
+    QList<GanjoorPoem> poems;
+    if (!isConnected(connectionID)) {
+        return poems;
+    }
+
+    QSqlQuery q(database(connectionID));
+    QMultiHash<int, int> childrenOfCat;
+    q.exec("SELECT id, parent_id FROM cat ORDER BY id DESC");
+    while (q.next()) {
+        // QMultiHash::values() returns most recently inserted first, so ids are ascending
+        childrenOfCat.insert(q.value(1).toInt(), q.value(0).toInt());
+    }
+
+    // pre-order traversal of category tree
+    QHash<int, int> catOrder;
+    QList<int> stack;
+    stack << CatID;
+    while (!stack.isEmpty()) {
+        const int catId = stack.takeLast();
+        if (catOrder.contains(catId)) {
+            continue;
+        }
+        catOrder.insert(catId, catOrder.size());
+
+        const QList<int> children = childrenOfCat.values(catId);
+        for (int i = children.size() - 1; i >= 0; --i) {
+            stack << children.at(i);
+        }
+    }
+
+    QMap<int, QList<GanjoorPoem> > poemsByOrder;
+    q.exec("SELECT id, cat_id, title, url FROM poem ORDER BY id");
+    while (q.next()) {
+        const int catId = q.value(1).toInt();
+        if (!catOrder.contains(catId)) {
+            continue;
+        }
+
+        GanjoorPoem gPoem;
+        gPoem.init(q.value(0).toInt(), catId, q.value(2).toString(), q.value(3).toString(), false, "");
+        poemsByOrder[catOrder.value(catId)].append(gPoem);
+    }
+
+    QMap<int, QList<GanjoorPoem> >::const_iterator it = poemsByOrder.constBegin();
+    while (it != poemsByOrder.constEnd()) {
+        poems << it.value();
+        ++it;
+    }
+
+    return poems;
+}
+
+QMap<int, QList<GanjoorVerse> > DatabaseBrowser::getVersesOfPoems(const QList<int> &poemIDs, const QString &connectionID)
+{
+    TRACE_SPAN("db", "DatabaseBrowser::getVersesOfPoems");
+
+    QMap<int, QList<GanjoorVerse> > verses;
+    if (poemIDs.isEmpty() || !isConnected(connectionID)) {
+        return verses;
+    }
+
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        foreach (int id, poemIDs) {
+            const QVector<GanjoorVerse> poemVerses = pack->verses(id);
+            if (!poemVerses.isEmpty()) {
+                verses.insert(id, poemVerses.toList());
+            }
+        }
+        return verses;
+    }
+
+    QStringList ids;
+    foreach (int id, poemIDs) {
+        ids << QString::number(id);
+    }
+
+    QSqlQuery q(database(connectionID));
+    q.exec(QString("SELECT poem_id, vorder, position, text FROM verse WHERE poem_id IN (%1) ORDER BY poem_id, vorder").arg(ids.join(",")));
+    while (q.next()) {
+        GanjoorVerse gVerse;
+        gVerse.init(q.value(0).toInt(), q.value(1).toInt(), (VersePosition)q.value(2).toInt(), q.value(3).toString());
+        verses[gVerse._PoemID].append(gVerse);
+    }
+
+    return verses;
+}
+
 GanjoorPoem DatabaseBrowser::getPoem(int PoemID, const QString &connectionID)
 {
+    TRACE_SPAN("db", "DatabaseBrowser::getPoem");
+
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        return pack->poem(PoemID);
+    }
+
     GanjoorPoem gPoem;
     gPoem.init();
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        q.exec("SELECT cat_id, title, url FROM poem WHERE ID = " + QString::number(PoemID));
+        QSqlQuery q = preparedQuery("SELECT cat_id, title, url FROM poem WHERE ID = ?", connectionID);
+        q.addBindValue(PoemID);
+        q.exec();
         q.first();
         if (q.isValid() && q.isActive()) {
             QSqlRecord qrec = q.record();
             gPoem.init(PoemID, (qrec.value(0)).toInt(), (qrec.value(1)).toString(), (qrec.value(2)).toString(), false, QString(""));
-            return gPoem;
         }
+        q.finish();
     }
     return gPoem;
 }
@@ -490,13 +903,20 @@ GanjoorPoem DatabaseBrowser::getNextPoem(int PoemID, int CatID, const QString &c
 {
     GanjoorPoem gPoem;
     gPoem.init();
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack && PoemID != -1) {
+        return pack->siblingPoem(PoemID, CatID, true);
+    }
     if (isConnected(connectionID) && PoemID != -1) { // PoemID==-1 when getNextPoem(GanjoorPoem poem) pass null poem
-        QSqlQuery q(database(connectionID));
-        q.exec(QString("SELECT ID FROM poem WHERE cat_id = %1 AND id>%2 LIMIT 1").arg(CatID).arg(PoemID));
+        QSqlQuery q = preparedQuery("SELECT ID FROM poem WHERE cat_id = ? AND id>? LIMIT 1", connectionID);
+        q.addBindValue(CatID);
+        q.addBindValue(PoemID);
+        q.exec();
         q.first();
         if (q.isValid() && q.isActive()) {
-            QSqlRecord qrec = q.record();
-            gPoem = getPoem(qrec.value(0).toInt(), connectionID);
+            const int id = q.record().value(0).toInt();
+            q.finish();
+            gPoem = getPoem(id, connectionID);
             return gPoem;
         }
     }
@@ -512,13 +932,20 @@ GanjoorPoem DatabaseBrowser::getPreviousPoem(int PoemID, int CatID, const QStrin
 {
     GanjoorPoem gPoem;
     gPoem.init();
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack && PoemID != -1) {
+        return pack->siblingPoem(PoemID, CatID, false);
+    }
     if (isConnected(connectionID) && PoemID != -1) { // PoemID==-1 when getPreviousPoem(GanjoorPoem poem) pass null poem
-        QSqlQuery q(database(connectionID));
-        q.exec(QString("SELECT ID FROM poem WHERE cat_id = %1 AND id<%2 ORDER BY ID DESC LIMIT 1").arg(CatID).arg(PoemID));
+        QSqlQuery q = preparedQuery("SELECT ID FROM poem WHERE cat_id = ? AND id<? ORDER BY ID DESC LIMIT 1", connectionID);
+        q.addBindValue(CatID);
+        q.addBindValue(PoemID);
+        q.exec();
         q.first();
         if (q.isValid() && q.isActive()) {
-            QSqlRecord qrec = q.record();
-            gPoem = getPoem(qrec.value(0).toInt(), connectionID);
+            const int id = q.record().value(0).toInt();
+            q.finish();
+            gPoem = getPoem(id, connectionID);
             return gPoem;
         }
     }
@@ -549,13 +976,20 @@ GanjoorPoet DatabaseBrowser::getPoetForCat(int CatID, const QString &connectionI
         gPoet.init(0, tr("All"), 0);
         return gPoet;
     }
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        const GanjoorCat gCat = pack->category(CatID);
+        return gCat.isNull() ? gPoet : getPoet(gCat._PoetID, connectionID);
+    }
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        q.exec("SELECT poet_id FROM cat WHERE id = " + QString::number(CatID));
+        QSqlQuery q = preparedQuery("SELECT poet_id FROM cat WHERE id = ?", connectionID);
+        q.addBindValue(CatID);
+        q.exec();
         q.first();
         if (q.isValid() && q.isActive()) {
-            QSqlRecord qrec = q.record();
-            return getPoet(qrec.value(0).toInt(), connectionID);
+            const int poetID = q.record().value(0).toInt();
+            q.finish();
+            return getPoet(poetID, connectionID);
         }
     }
     return gPoet;
@@ -569,15 +1003,22 @@ GanjoorPoet DatabaseBrowser::getPoet(int PoetID, const QString &connectionID)
         gPoet.init(0, tr("All"), 0);
         return gPoet;
     }
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        return pack->poet(PoetID);
+    }
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
+        QSqlQuery q = preparedQuery("SELECT id, name, cat_id, description FROM poet WHERE id = ?", connectionID);
+        q.addBindValue(PoetID);
 
         bool descriptionExists = false;
-        if (q.exec("SELECT id, name, cat_id, description FROM poet WHERE id = " + QString::number(PoetID))) {
+        if (q.exec()) {
             descriptionExists = true;
         }
         else {
-            q.exec("SELECT id, name, cat_id FROM poet WHERE id = " + QString::number(PoetID));
+            q = preparedQuery("SELECT id, name, cat_id FROM poet WHERE id = ?", connectionID);
+            q.addBindValue(PoetID);
+            q.exec();
         }
 
         q.first();
@@ -589,9 +1030,8 @@ GanjoorPoet DatabaseBrowser::getPoet(int PoetID, const QString &connectionID)
             else {
                 gPoet.init((qrec.value(0)).toInt(), (qrec.value(1)).toString(), (qrec.value(2)).toInt(), "");
             }
-
-            return gPoet;
         }
+        q.finish();
     }
     return gPoet;
 }
@@ -601,13 +1041,19 @@ QString DatabaseBrowser::getPoetDescription(int PoetID, const QString &connectio
     if (PoetID <= 0) {
         return "";
     }
+    const PoemPack* pack = poemPack(connectionID);
+    if (pack) {
+        return pack->poet(PoetID)._Description;
+    }
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        q.exec("SELECT description FROM poet WHERE id = " + QString::number(PoetID));
+        QSqlQuery q = preparedQuery("SELECT description FROM poet WHERE id = ?", connectionID);
+        q.addBindValue(PoetID);
+        q.exec();
         q.first();
         if (q.isValid() && q.isActive()) {
-            QSqlRecord qrec = q.record();
-            return (qrec.value(0)).toString();
+            const QString description = q.record().value(0).toString();
+            q.finish();
+            return description;
         }
     }
     return "";
@@ -619,12 +1065,14 @@ QString DatabaseBrowser::getPoemMediaSource(int PoemID, const QString &connectio
         return "";
     }
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        q.exec("SELECT mediasource FROM poem WHERE id = " + QString::number(PoemID));
+        QSqlQuery q = preparedQuery("SELECT mediasource FROM poem WHERE id = ?", connectionID);
+        q.addBindValue(PoemID);
+        q.exec();
         q.first();
         if (q.isValid() && q.isActive()) {
-            QSqlRecord qrec = q.record();
-            return (qrec.value(0)).toString();
+            const QString mediasource = q.record().value(0).toString();
+            q.finish();
+            return mediasource;
         }
     }
     return "";
@@ -641,6 +1089,7 @@ void DatabaseBrowser::setPoemMediaSource(int PoemID, const QString &fileName, co
         if (!database().record("poem").contains("mediasource")) {
             strQuery = QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg("poem").arg("mediasource").arg("NVARCHAR(255)");
             q.exec(strQuery);
+            schemaChanged();
             //q.finish();
         }
 
@@ -666,14 +1115,17 @@ GanjoorPoet DatabaseBrowser::getPoet(QString PoetName, const QString &connection
     GanjoorPoet gPoet;
     gPoet.init();
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
+        QSqlQuery q = preparedQuery("SELECT id, name, cat_id, description FROM poet WHERE name = ?", connectionID);
+        q.addBindValue(PoetName);
 
         bool descriptionExists = false;
-        if (q.exec("SELECT id, name, cat_id, description FROM poet WHERE name = \'" + PoetName + "\'")) {
+        if (q.exec()) {
             descriptionExists = true;
         }
         else {
-            q.exec("SELECT id, name, cat_id FROM poet WHERE name = \'" + PoetName + "\'");
+            q = preparedQuery("SELECT id, name, cat_id FROM poet WHERE name = ?", connectionID);
+            q.addBindValue(PoetName);
+            q.exec();
         }
 
         q.first();
@@ -685,59 +1137,120 @@ GanjoorPoet DatabaseBrowser::getPoet(QString PoetName, const QString &connection
             else {
                 gPoet.init((qrec.value(0)).toInt(), (qrec.value(1)).toString(), (qrec.value(2)).toInt(), "");
             }
-
-            return gPoet;
         }
+        q.finish();
     }
     return gPoet;
 }
 
 int DatabaseBrowser::getRandomPoemID(int* CatID, const QString &connectionID)
 {
-    if (isConnected(connectionID)) {
-        QList<GanjoorCat*> subCats = getSubCategories(*CatID, connectionID);
-        int randIndex = Tools::getRandomNumber(0, subCats.size());
-        if (randIndex >= 0 && randIndex != subCats.size()) { // '==' is when we want to continue with current 'CatID'. notice maybe 'randIndex == subCats.size() == 0'.
-            *CatID = subCats.at(randIndex)->_ID;
-            return getRandomPoemID(CatID, connectionID);
-        }
+    TRACE_SPAN("db", "DatabaseBrowser::getRandomPoemID");
+
+    if (!isConnected(connectionID)) {
+        return -1;
+    }
+
+    const PoemSampler* sampler = poemSampler(connectionID);
+    const QPair<int, int> range = sampler->subtreeRanges.value(*CatID, qMakePair(0, 0));
+    const int count = range.second - range.first;
+    if (count <= 0) {
+        return -1;
+    }
+
+    const int index = range.first + uniformRandomIndex(count);
+    *CatID = sampler->poemCats.at(index);
+
+    return sampler->poemIDs.at(index);
+}
+
+DatabaseBrowser::PoemSampler* DatabaseBrowser::poemSampler(const QString &connectionID)
+{
+    const QString databaseFile = databaseFileFromID(connectionID);
+    PoemSampler* sampler = m_poemSamplers.value(databaseFile);
+    if (sampler) {
+        return sampler;
+    }
+
+    TRACE_SPAN("db", "DatabaseBrowser::poemSampler");
+
+    QSqlQuery q(database(connectionID));
+    QMultiHash<int, int> childrenOfCat;
+    q.exec("SELECT id, parent_id FROM cat ORDER BY id DESC");
+    while (q.next()) {
+        // QMultiHash::values() returns most recently inserted first, so ids are ascending
+        childrenOfCat.insert(q.value(1).toInt(), q.value(0).toInt());
+    }
 
-        QString strQuery = "SELECT MIN(id), MAX(id) FROM poem";
-        if (*CatID != 0) {
-            strQuery += " WHERE cat_id=" + QString::number(*CatID);
+    QHash<int, QVector<int> > poemsOfCat;
+    q.exec("SELECT id, cat_id FROM poem ORDER BY id");
+    while (q.next()) {
+        poemsOfCat[q.value(1).toInt()].append(q.value(0).toInt());
+    }
+    q.finish();
+
+    sampler = new PoemSampler;
+
+    // pre-order traversal of category tree, a category is pushed a second
+    // time (marked by 'true') to close its range after all of its children
+    QList<QPair<int, bool> > stack;
+    stack << qMakePair(0, false);
+    while (!stack.isEmpty()) {
+        const QPair<int, bool> item = stack.takeLast();
+        const int catId = item.first;
+
+        if (item.second) {
+            sampler->subtreeRanges[catId].second = sampler->poemIDs.size();
+            continue;
+        }
+        if (sampler->subtreeRanges.contains(catId)) {
+            continue;
         }
-        QSqlQuery q(database(connectionID));
-        q.exec(strQuery);
-        if (q.next()) {
-            QSqlRecord qrec = q.record();
-            int minID = qrec.value(0).toInt();
-            int maxID = qrec.value(1).toInt();
 
-            if (maxID <= 0 || minID < 0) {
-                QList<GanjoorCat*> subCats = getSubCategories(*CatID, connectionID);
-                *CatID = subCats.at(Tools::getRandomNumber(0, subCats.size() - 1))->_ID;
-                return getRandomPoemID(CatID, connectionID);
-            }
-            return Tools::getRandomNumber(minID, maxID);
+        const int begin = sampler->poemIDs.size();
+        sampler->subtreeRanges.insert(catId, qMakePair(begin, begin));
+
+        const QVector<int> poems = poemsOfCat.value(catId);
+        sampler->poemIDs += poems;
+        sampler->poemCats.insert(sampler->poemCats.size(), poems.size(), catId);
+
+        stack << qMakePair(catId, true);
+        const QList<int> children = childrenOfCat.values(catId);
+        for (int i = children.size() - 1; i >= 0; --i) {
+            stack << qMakePair(children.at(i), false);
         }
     }
-    return -1;
+
+    m_poemSamplers.insert(databaseFile, sampler);
+
+    return sampler;
+}
+
+void DatabaseBrowser::invalidatePoemSampler(const QString &connectionID)
+{
+    delete m_poemSamplers.take(databaseFileFromID(connectionID));
 }
 
-QList<GanjoorPoet*> DatabaseBrowser::getDataBasePoets(const QString fileName)
+void DatabaseBrowser::invalidatePoemPack(const QString &connectionID)
+{
+    PoemPack::invalidate(databaseFileFromID(connectionID));
+}
+
+QVector<GanjoorPoet> DatabaseBrowser::getDataBasePoets(const QString fileName)
 {
     if (!QFile::exists(fileName)) {
-        return QList<GanjoorPoet*>();
+        return QVector<GanjoorPoet>();
     }
 
     QString dataBaseID = getIdForDataBase(fileName);
 
     if (!database(dataBaseID).open()) {
-        QSqlDatabase::removeDatabase(dataBaseID);
-        return QList<GanjoorPoet*>();
+        QMutexLocker locker(&s_connectionsMutex);
+        removeConnection(dataBaseID);
+        return QVector<GanjoorPoet>();
     }
 
-    return getPoets(dataBaseID, false);
+    return poets(dataBaseID, false);
 }
 
 QString DatabaseBrowser::getIdForDataBase(const QString &fileName, QThread* thread)
@@ -746,33 +1259,78 @@ QString DatabaseBrowser::getIdForDataBase(const QString &fileName, QThread* thre
         thread = QThread::currentThread();
     }
 
-    bool clone = false;
-    const QString &longName = Tools::getLongPathName(fileName);
-    const QString &connectionID = longName + QLatin1String("/thread:") + threadToString(thread);
+    const ThreadFileKey key(thread, fileName);
 
-    if (!QSqlDatabase::contains(connectionID)) {
-        const QStringList &allConnections = QSqlDatabase::connectionNames();
+    QMutexLocker locker(&s_connectionsMutex);
 
-        QString id;
-        foreach (id, allConnections) {
-            if (id.startsWith(longName)) {
-                clone = true;
-                break;
-            }
+    QHash<ThreadFileKey, QString>::const_iterator it = s_connectionIds.constFind(key);
+    if (it != s_connectionIds.constEnd()) {
+        return it.value();
+    }
+
+    QString longName = s_canonicalPaths.value(fileName);
+    if (longName.isEmpty()) {
+        longName = Tools::getLongPathName(fileName);
+        // a missing file has no canonical path yet
+        if (QFile::exists(longName)) {
+            s_canonicalPaths.insert(fileName, longName);
         }
+    }
+
+    const QString connectionID = longName + QLatin1String("/thread:") + threadToString(thread);
+
+    s_connectionIds.insert(key, connectionID);
+
+    if (!QSqlDatabase::contains(connectionID)) {
+        const QString id = s_fileConnections.value(longName);
+        const bool clone = !id.isEmpty();
 
         QSqlDatabase db = clone
                           ? QSqlDatabase::cloneDatabase(QSqlDatabase::database(id, false), connectionID)
                           : QSqlDatabase::addDatabase(sqlDriver, connectionID);
 
         db.setDatabaseName(fileName);
-        db.open();
+
+        const bool readOnly = s_accessMode != ReadWrite && longName == Tools::getLongPathName(s_defaultDatabaseFileName);
+        if (readOnly) {
+            // no QSQLITE_ENABLE_SHARED_CACHE, it's a process wide switch and
+            // would change locking of read-write connections to other files too,
+            // mapping the file (see configureConnection()) shares its pages
+            QStringList options;
+            options << QLatin1String("QSQLITE_OPEN_READONLY");
+#if QT_VERSION >= 0x050000
+            if (s_accessMode == Immutable) {
+                // SQLite skips locking and change detection for immutable files
+                options << QLatin1String("QSQLITE_OPEN_URI");
+                db.setDatabaseName(QUrl::fromLocalFile(fileName).toString() + QLatin1String("?immutable=1"));
+            }
+#endif
+            db.setConnectOptions(options.join(QLatin1String(";")));
+        }
+        else {
+            db.setConnectOptions();
+        }
 
         s_threadConnections.insert(thread, connectionID);
+        s_fileConnections.insert(longName, connectionID);
 
         Q_ASSERT(s_instance != 0);
 
-        connect(thread, SIGNAL(destroyed(QObject*)), s_instance, SLOT(removeThreadsConnections(QObject*)));
+        if (thread == QThread::currentThread()) {
+            // the main thread outlives the registry
+            if (thread != s_instance->thread() && !threadConnectionsGuard.hasLocalData()) {
+                threadConnectionsGuard.setLocalData(new ThreadConnectionsGuard);
+            }
+        }
+        else {
+            connect(thread, SIGNAL(destroyed(QObject*)), s_instance, SLOT(removeThreadsConnections(QObject*)));
+        }
+
+        // opening the file may take long, it doesn't need the registry
+        locker.unlock();
+
+        db.open();
+        configureConnection(db, readOnly);
     }
 
     return connectionID;
@@ -784,27 +1342,27 @@ void DatabaseBrowser::removeDatabase(const QString &fileName, QThread* thread)
         thread = QThread::currentThread();
     }
 
-    QString connectionID = Tools::getLongPathName(fileName) + QLatin1String("/") + threadToString(thread);
+    QMutexLocker locker(&s_connectionsMutex);
 
-    if (QSqlDatabase::contains(connectionID)) {
-        QSqlDatabase::removeDatabase(connectionID);
+    const QString connectionID = s_connectionIds.value(ThreadFileKey(thread, fileName));
 
-        s_threadConnections.remove(thread, connectionID);
+    if (!connectionID.isEmpty()) {
+        removeConnection(connectionID);
     }
 }
 
-QList<GanjoorPoet*> DatabaseBrowser::getConflictingPoets(const QString fileName, const QString &toConnectionID)
+QVector<GanjoorPoet> DatabaseBrowser::getConflictingPoets(const QString fileName, const QString &toConnectionID)
 {
-    QList<GanjoorPoet*> conflictList;
+    QVector<GanjoorPoet> conflictList;
     if (isConnected()) {
-        QList<GanjoorPoet*> dataBasePoets = getDataBasePoets(fileName);
-        QList<GanjoorPoet*> installedPoets = getPoets(toConnectionID);
-        foreach (GanjoorPoet* poet, installedPoets) {
-            foreach (GanjoorPoet* dbPoet, dataBasePoets) {
-                if (dbPoet->_ID == poet->_ID) {
-                    conflictList << poet;
-                    break;
-                }
+        QSet<int> dataBasePoetIDs;
+        foreach (const GanjoorPoet &dbPoet, getDataBasePoets(fileName)) {
+            dataBasePoetIDs.insert(dbPoet._ID);
+        }
+
+        foreach (const GanjoorPoet &poet, poets(toConnectionID)) {
+            if (dataBasePoetIDs.contains(poet._ID)) {
+                conflictList << poet;
             }
         }
     }
@@ -812,8 +1370,10 @@ QList<GanjoorPoet*> DatabaseBrowser::getConflictingPoets(const QString fileName,
     return conflictList;
 }
 
-void DatabaseBrowser::removePoetFromDataBase(int PoetID, const QString &connectionID)
+void DatabaseBrowser::removePoetFromDataBase(int PoetID, const QString &connectionID, bool notify)
 {
+    TRACE_SPAN("db", "DatabaseBrowser::removePoetFromDataBase");
+
     if (isConnected(connectionID)) {
         QString strQuery;
         QSqlQuery q(database(connectionID));
@@ -822,6 +1382,10 @@ void DatabaseBrowser::removePoetFromDataBase(int PoetID, const QString &connecti
 
         strQuery = "DELETE FROM poet WHERE id=" + QString::number(PoetID);
         q.exec(strQuery);
+
+        if (notify) {
+            emit databaseUpdated(connectionID);
+        }
     }
 }
 
@@ -830,9 +1394,8 @@ void DatabaseBrowser::removeCatFromDataBase(const GanjoorCat &gCat, const QStrin
     if (gCat.isNull()) {
         return;
     }
-    QList<GanjoorCat*> subCats = getSubCategories(gCat._ID, connectionID);
-    foreach (GanjoorCat* cat, subCats) {
-        removeCatFromDataBase(*cat, connectionID);
+    foreach (const GanjoorCat &cat, subCategories(gCat._ID, connectionID)) {
+        removeCatFromDataBase(cat, connectionID);
     }
     if (isConnected(connectionID)) {
         QString strQuery;
@@ -938,8 +1501,10 @@ int DatabaseBrowser::getNewCatID(const QString &connectionID)
     return newCatID;
 }
 
-bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString &toConnectionID)
+bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString &toConnectionID, bool notify)
 {
+    TRACE_SPAN("import", "DatabaseBrowser::importDataBase");
+
     if (!QFile::exists(fromFileName)) {
         return false;
     }
@@ -947,20 +1512,22 @@ bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString
     QString connectionID = getIdForDataBase(fromFileName);
 
     if (!database(connectionID).open() || !isValid(connectionID)) {
-        QSqlDatabase::removeDatabase(connectionID);
+        QMutexLocker locker(&s_connectionsMutex);
+        removeConnection(connectionID);
         return false;
     }
 
     {
         // start of block
-        QList<GanjoorPoet*> poets = getPoets(connectionID, false);
+        QVector<GanjoorPoet> dataSetPoets = poets(connectionID, false);
 
         QString strQuery;
         QSqlQuery queryObject(database(connectionID));
         QMap<int, int> mapPoets;
         QMap<int, int> mapCats;
 
-        foreach (GanjoorPoet* newPoet, poets) {
+        for (int i = 0; i < dataSetPoets.size(); ++i) {
+            GanjoorPoet* newPoet = &dataSetPoets[i];
             bool insertNewPoet = true;
 
             //skip every null poet(poet without subcat)
@@ -1025,14 +1592,15 @@ bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString
         strQuery = QString("SELECT id, poet_id, text, parent_id, url FROM cat");
         queryObject.exec(strQuery);
 
-        QList<GanjoorCat*> gCatList;
+        QVector<GanjoorCat> gCatList;
         while (queryObject.next()) {
-            GanjoorCat* gCat = new GanjoorCat();
-            gCat->init(queryObject.value(0).toInt(), queryObject.value(1).toInt(), queryObject.value(2).toString(), queryObject.value(3).toInt(), queryObject.value(4).toString());
+            GanjoorCat gCat;
+            gCat.init(queryObject.value(0).toInt(), queryObject.value(1).toInt(), queryObject.value(2).toString(), queryObject.value(3).toInt(), queryObject.value(4).toString());
             gCatList.append(gCat);
         }
 
-        foreach (GanjoorCat* newCat, gCatList) {
+        for (int i = 0; i < gCatList.size(); ++i) {
+            GanjoorCat* newCat = &gCatList[i];
             newCat->_PoetID = mapPoets.value(newCat->_PoetID, newCat->_PoetID);
             newCat->_ParentID = mapCats.value(newCat->_ParentID, newCat->_ParentID);
 
@@ -1083,15 +1651,16 @@ bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString
         QMap<int, int> dicPoemID;
         strQuery = "SELECT id, cat_id, title, url FROM poem";
         queryObject.exec(strQuery);
-        QList<GanjoorPoem*> poemList;
+        QVector<GanjoorPoem> poemList;
 
         while (queryObject.next()) {
-            GanjoorPoem* gPoem = new GanjoorPoem();
-            gPoem->init(queryObject.value(0).toInt(), queryObject.value(1).toInt(), queryObject.value(2).toString(), queryObject.value(3).toString());
+            GanjoorPoem gPoem;
+            gPoem.init(queryObject.value(0).toInt(), queryObject.value(1).toInt(), queryObject.value(2).toString(), queryObject.value(3).toString());
             poemList.append(gPoem);
         }
 
-        foreach (GanjoorPoem* newPoem, poemList) {
+        for (int i = 0; i < poemList.size(); ++i) {
+            GanjoorPoem* newPoem = &poemList[i];
             int tmp = newPoem->_ID;
             if (!getPoem(newPoem->_ID, toConnectionID).isNull()) {
                 newPoem->_ID = getNewPoemID();
@@ -1108,11 +1677,11 @@ bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString
 
         strQuery = "SELECT poem_id, vorder, position, text FROM verse";
         queryObject.exec(strQuery);
-        QList<GanjoorVerse*> verseList;
+        QVector<GanjoorVerse> verseList;
 
         while (queryObject.next()) {
-            GanjoorVerse* gVerse = new GanjoorVerse();
-            gVerse->init(queryObject.value(0).toInt(), queryObject.value(1).toInt(), (VersePosition)queryObject.value(2).toInt(), queryObject.value(3).toString());
+            GanjoorVerse gVerse;
+            gVerse.init(queryObject.value(0).toInt(), queryObject.value(1).toInt(), (VersePosition)queryObject.value(2).toInt(), queryObject.value(3).toString());
             verseList.append(gVerse);
         }
 
@@ -1121,7 +1690,8 @@ bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString
             QSqlQuery q(database(toConnectionID));
             q.prepare(strQuery);
 
-            foreach (GanjoorVerse* newVerse, verseList) {
+            for (int i = 0; i < verseList.size(); ++i) {
+                GanjoorVerse* newVerse = &verseList[i];
                 newVerse->_PoemID = dicPoemID.value(newVerse->_PoemID, newVerse->_PoemID);
                 q.bindValue(":poem_id", newVerse->_PoemID);
                 q.bindValue(":vorder", newVerse->_Order);
@@ -1132,36 +1702,35 @@ bool DatabaseBrowser::importDataBase(const QString &fromFileName, const QString
         }
     } // end of block
 
-    QSqlDatabase::removeDatabase(connectionID);
+    {
+        QMutexLocker locker(&s_connectionsMutex);
+        removeConnection(connectionID);
+    }
 
-    emit databaseUpdated(toConnectionID);
+    if (notify) {
+        emit databaseUpdated(toConnectionID);
+    }
 
     return true;
 }
 
-bool DatabaseBrowser::getPoemIDsByPhrase(ConcurrentTask* searchTask, const QString &currentSelectionPath, const QString &currentSelectionPathTitle, const QStringList &phraseList, const QStringList &excludedList,
-        bool* Canceled, bool slowSearch, const QString &connectionID)
+// LIKE pattern that selects a superset of rows matching 'phrase'
+static QString likePattern(const QString &phrase)
 {
-    if (phraseList.isEmpty()) {
-        return false;
-    }
-
-    QString strQuery;
-    QStringList excludeWhenCleaning;
-    QString searchQueryPhrase;
-//    bool findRhyme = false;
-
-//    if (phraseList.contains("=", Qt::CaseInsensitive)) {
-//        findRhyme = true;
-//    }
+    QString pattern = phrase;
+    QStringList excludeList;
 
-    QString firstPhrase = phraseList.at(0);
+    //rows of a NEAR clause are selected by its first operand then checked by positional index
+    PositionalClause clause;
+    if (SearchPatternManager::positionalClause(pattern, &clause) && clause.operands.size() > 1) {
+        pattern = clause.operands.first().join(" ");
+    }
 
-    if (!firstPhrase.contains("=")) {
-        excludeWhenCleaning << " ";
+    if (!pattern.contains("=")) {
+        excludeList << " ";
     }
     else {
-        firstPhrase.remove("=");
+        pattern.remove("=");
     }
 
     QString joiner;
@@ -1169,48 +1738,105 @@ bool DatabaseBrowser::getPoemIDsByPhrase(ConcurrentTask* searchTask, const QStri
         joiner = QLatin1String("%");
     }
     //replace characters that have some variants with anyWord replaceholder!
-    //we have not to worry about this replacement, because phraseList.at(0) is tested again!
+    //we have not to worry about this replacement, because phrase is tested again!
     bool variantPresent = false;
     if (SearchResultWidget::skipVowelLetters) {
         QRegExp variantEXP("[" + Tools::Ve_Variant.join("") + Tools::AE_Variant.join("") + Tools::He_Variant.join("") + Tools::Ye_Variant.join("") + "]+");
-        if (firstPhrase.contains(variantEXP)) {
-            firstPhrase.replace(variantEXP, "%");
+        if (pattern.contains(variantEXP)) {
+            pattern.replace(variantEXP, "%");
             variantPresent = true;
         }
     }
 
-    QStringList anyWordedList = firstPhrase.split("%%", QString::SkipEmptyParts);
+    QStringList anyWordedList = pattern.split("%%", QString::SkipEmptyParts);
     for (int i = 0; i < anyWordedList.size(); ++i) {
         QString subPhrase = anyWordedList.at(i);
         if (SearchResultWidget::skipVowelSigns) {
             subPhrase.remove("%");
         }
-        //TODO: remove skipNonAlphabet and replace it with NEAR operator
-        //search for firstPhrase then go for other ones
         subPhrase = subPhrase.simplified();
         if (!subPhrase.contains(" ") || variantPresent) {
-            subPhrase = Tools::cleanString(subPhrase, excludeWhenCleaning).split("", QString::SkipEmptyParts).join(joiner);
+            subPhrase = Tools::cleanString(subPhrase, excludeList).split("", QString::SkipEmptyParts).join(joiner);
         }
         subPhrase.replace("% %", "%");
         anyWordedList[i] = subPhrase;
     }
 
-    searchQueryPhrase = anyWordedList.join("%");
+    return anyWordedList.join("%");
+}
 
-    QString taskTitle = currentSelectionPathTitle;
+QString DatabaseBrowser::searchQuery(const QString &currentSelectionPath, const QStringList &phraseList, QStringList* excludeWhenCleaning, const QString &connectionID)
+{
+    if (phraseList.isEmpty()) {
+        return QString();
+    }
+
+    QString strQuery;
+    QStringList excludeList;
+
+    if (!phraseList.at(0).contains("=")) {
+        excludeList << " ";
+    }
+
+    const bool titles = currentSelectionPath == "ALL_TITLES";
+    QString column = QLatin1String("text");
+    if (titles) {
+        column = QLatin1String("title");
+    }
+    else if (currentSelectionPath != "ALL") {
+        column = QLatin1String("verse.text");
+    }
+
+    //the most selective phrases are tested first, SQLite stops at first failed term
+    //variants of an approximate phrase don't have a common pattern, they are not pushed down
+    QStringList conditions;
+    const QList<int> order = SearchPlanner::pushDownOrder(phraseList, connectionID, titles, SearchResultWidget::approximateDistance > 0);
+    foreach (int index, order) {
+        const QString pattern = likePattern(phraseList.at(index));
+        if (!pattern.isEmpty()) {
+            conditions << column + " LIKE \'%" + pattern + "%\'";
+        }
+    }
+    if (conditions.isEmpty()) {
+        conditions << column + " LIKE \'%%\'";
+    }
+    const QString condition = conditions.join(" AND ");
 
     if (currentSelectionPath == "ALL") {
-        strQuery = QString("SELECT poem_id, text, vorder FROM verse WHERE text LIKE \'%" + searchQueryPhrase + "%\' ORDER BY poem_id");
+        strQuery = QString("SELECT poem_id, text, vorder FROM verse WHERE " + condition + " ORDER BY poem_id");
     }
-    else if (currentSelectionPath == "ALL_TITLES") {
-        strQuery = QString("SELECT id, title FROM poem WHERE title LIKE \'%" + searchQueryPhrase + "%\' ORDER BY id");
+    else if (titles) {
+        strQuery = QString("SELECT id, title FROM poem WHERE " + condition + " ORDER BY id");
     }
     else {
-        strQuery = QString("SELECT verse.poem_id,verse.text, verse.vorder FROM verse WHERE verse.text LIKE \'%%1%\' AND verse.poem_id IN (SELECT poem.id FROM poem WHERE poem.cat_id IN (%2) ORDER BY poem.id)").arg(searchQueryPhrase).arg(currentSelectionPath);
+        strQuery = QString("SELECT verse.poem_id,verse.text, verse.vorder FROM verse WHERE " + condition + " AND verse.poem_id IN (SELECT poem.id FROM poem WHERE poem.cat_id IN (%1) ORDER BY poem.id)").arg(currentSelectionPath);
+    }
+
+    if (excludeWhenCleaning) {
+        *excludeWhenCleaning = excludeList;
     }
 
+    return strQuery;
+}
+
+QVariantHash DatabaseBrowser::searchArguments(const QString &currentSelectionPath, const QString &currentSelectionPathTitle, const QStringList &phraseList, const QStringList &excludedList,
+        bool* Canceled, bool slowSearch, const QString &connectionID)
+{
+    QStringList excludeWhenCleaning;
+    const QString strQuery = searchQuery(currentSelectionPath, phraseList, &excludeWhenCleaning, connectionID);
+
+    QString taskTitle = currentSelectionPathTitle;
+
     taskTitle.prepend(tr("Search: "));
 
+    const int approximateDistance = SearchResultWidget::approximateDistance;
+    const QString cacheKey = SearchResultCache::cacheKey(databaseFileFromID(connectionID), currentSelectionPath,
+                             phraseList, excludedList,
+                             SearchResultWidget::skipVowelSigns, SearchResultWidget::skipVowelLetters,
+                             approximateDistance, slowSearch);
+    // results of a task that finishes after a database update are not cached
+    const int cacheGeneration = SearchResultCache::instance()->generation();
+
     QVariantHash arguments;
     // TODO: Add local database support to parallel search
     VAR_ADD(arguments, connectionID);
@@ -1222,13 +1848,27 @@ bool DatabaseBrowser::getPoemIDsByPhrase(ConcurrentTask* searchTask, const QStri
     VAR_ADD(arguments, Canceled);
     VAR_ADD(arguments, slowSearch);
     VAR_ADD(arguments, taskTitle);
+    VAR_ADD(arguments, cacheKey);
+    VAR_ADD(arguments, cacheGeneration);
+    VAR_ADD(arguments, approximateDistance);
+
+    return arguments;
+}
 
-    searchTask->start("SEARCH", arguments, true);
+bool DatabaseBrowser::getPoemIDsByPhrase(ConcurrentTask* searchTask, const QString &currentSelectionPath, const QString &currentSelectionPathTitle, const QStringList &phraseList, const QStringList &excludedList,
+        bool* Canceled, bool slowSearch, const QString &connectionID)
+{
+    if (phraseList.isEmpty()) {
+        return false;
+    }
+
+    searchTask->start(ConcurrentTask::Search, searchArguments(currentSelectionPath, currentSelectionPathTitle, phraseList, excludedList,
+                      Canceled, slowSearch, connectionID), true);
 
     return true;
 }
 
-bool DatabaseBrowser::isRadif(const QList<GanjoorVerse*> &verses, const QString &phrase, int verseOrder)
+bool DatabaseBrowser::isRadif(const QVector<GanjoorVerse> &verses, const QString &phrase, int verseOrder)
 {
     //verseOrder starts from 1 to verses.size()
     if (verseOrder <= 0 || verseOrder > verses.size()) {
@@ -1237,7 +1877,7 @@ bool DatabaseBrowser::isRadif(const QList<GanjoorVerse*> &verses, const QString
 
     //QList<GanjoorVerse *> verses = getVerses(PoemID);
 
-    QString cleanedVerse = Tools::cleanStringFast(verses.at(verseOrder - 1)->_Text, QStringList(""));
+    QString cleanedVerse = Tools::cleanStringFast(verses.at(verseOrder - 1)._Text, QStringList(""));
     //cleanedVerse = " "+cleanedVerse+" ";//just needed for whole word
     QString cleanedPhrase = Tools::cleanStringFast(phrase, QStringList(""));
 
@@ -1251,14 +1891,14 @@ bool DatabaseBrowser::isRadif(const QList<GanjoorVerse*> &verses, const QString
     mesraOrdersForCompare  << -1 << -1 << -1;
     int secondMesraOrder = -1;
 
-    switch (verses.at(verseOrder - 1)->_Position) {
+    switch (verses.at(verseOrder - 1)._Position) {
     case Right:
     case CenteredVerse1:
         if (verseOrder == verses.size()) { //last single beyt! there is no 'CenteredVerse2' or a database error
             //verses.clear();
             return false;
         }
-        if (verses.at(verseOrder)->_Position == Left || verses.at(verseOrder)->_Position == CenteredVerse2) {
+        if (verses.at(verseOrder)._Position == Left || verses.at(verseOrder)._Position == CenteredVerse2) {
             mesraOrdersForCompare[0] = verseOrder;
         }
         else {
@@ -1272,13 +1912,13 @@ bool DatabaseBrowser::isRadif(const QList<GanjoorVerse*> &verses, const QString
             //verses.clear();
             return false;
         }
-        if (verses.at(verseOrder - 2)->_Position == Right || verses.at(verseOrder - 2)->_Position == CenteredVerse1) {
+        if (verses.at(verseOrder - 2)._Position == Right || verses.at(verseOrder - 2)._Position == CenteredVerse1) {
             mesraOrdersForCompare[0] = verseOrder - 2;
         }
-        if (verseOrder - 3 >= 0 && (verses.at(verseOrder - 3)->_Position == Left || verses.at(verseOrder - 3)->_Position == CenteredVerse2)) {
+        if (verseOrder - 3 >= 0 && (verses.at(verseOrder - 3)._Position == Left || verses.at(verseOrder - 3)._Position == CenteredVerse2)) {
             mesraOrdersForCompare[1] = verseOrder - 3;    //mesra above current mesra
         }
-        if (verseOrder + 1 <= verses.size() - 1 && (verses.at(verseOrder + 1)->_Position == Left || verses.at(verseOrder + 1)->_Position == CenteredVerse2)) {
+        if (verseOrder + 1 <= verses.size() - 1 && (verses.at(verseOrder + 1)._Position == Left || verses.at(verseOrder + 1)._Position == CenteredVerse2)) {
             mesraOrdersForCompare[2] = verseOrder + 1;    //mesra above current mesra
         }
         if (mesraOrdersForCompare.at(0) == -1 && mesraOrdersForCompare.at(1) == -1 && mesraOrdersForCompare.at(2) == -1) {
@@ -1296,7 +1936,7 @@ bool DatabaseBrowser::isRadif(const QList<GanjoorVerse*> &verses, const QString
         if (secondMesraOrder == -1) {
             continue;
         }
-        secondMesra = Tools::cleanStringFast(verses.at(secondMesraOrder)->_Text, QStringList(""));
+        secondMesra = Tools::cleanStringFast(verses.at(secondMesraOrder)._Text, QStringList(""));
 
         if (!secondMesra.contains(cleanedPhrase)) {
             //verses.clear();
@@ -1322,14 +1962,14 @@ bool DatabaseBrowser::isRadif(const QList<GanjoorVerse*> &verses, const QString
     return false;
 }
 
-bool DatabaseBrowser::isRhyme(const QList<GanjoorVerse*> &verses, const QString &phrase, int verseOrder)
+bool DatabaseBrowser::isRhyme(const QVector<GanjoorVerse> &verses, const QString &phrase, int verseOrder)
 {
     //verseOrder starts from 1 to verses.size()
     if (verseOrder <= 0 || verseOrder > verses.size()) {
         return false;
     }
 
-    QString cleanedVerse = Tools::cleanStringFast(verses.at(verseOrder - 1)->_Text, QStringList(""));
+    QString cleanedVerse = Tools::cleanStringFast(verses.at(verseOrder - 1)._Text, QStringList(""));
     QString cleanedPhrase = Tools::cleanStringFast(phrase, QStringList(""));
 
     if (!cleanedVerse.contains(cleanedPhrase)) {
@@ -1342,14 +1982,14 @@ bool DatabaseBrowser::isRhyme(const QList<GanjoorVerse*> &verses, const QString
     mesraOrdersForCompare  << -1 << -1 << -1;
     int secondMesraOrder = -1;
 
-    switch (verses.at(verseOrder - 1)->_Position) {
+    switch (verses.at(verseOrder - 1)._Position) {
     case Right:
     case CenteredVerse1:
         if (verseOrder == verses.size()) { //last single beyt! there is no 'CenteredVerse2' or a database error
             //verses.clear();
             return false;
         }
-        if (verses.at(verseOrder)->_Position == Left || verses.at(verseOrder)->_Position == CenteredVerse2) {
+        if (verses.at(verseOrder)._Position == Left || verses.at(verseOrder)._Position == CenteredVerse2) {
             mesraOrdersForCompare[0] = verseOrder;
         }
         else {
@@ -1363,13 +2003,13 @@ bool DatabaseBrowser::isRhyme(const QList<GanjoorVerse*> &verses, const QString
             //verses.clear();
             return false;
         }
-        if (verses.at(verseOrder - 2)->_Position == Right || verses.at(verseOrder - 2)->_Position == CenteredVerse1) {
+        if (verses.at(verseOrder - 2)._Position == Right || verses.at(verseOrder - 2)._Position == CenteredVerse1) {
             mesraOrdersForCompare[0] = verseOrder - 2;
         }
-        if (verseOrder - 3 >= 0 && (verses.at(verseOrder - 3)->_Position == Left || verses.at(verseOrder - 3)->_Position == CenteredVerse2)) {
+        if (verseOrder - 3 >= 0 && (verses.at(verseOrder - 3)._Position == Left || verses.at(verseOrder - 3)._Position == CenteredVerse2)) {
             mesraOrdersForCompare[1] = verseOrder - 3;    //mesra above current mesra
         }
-        if (verseOrder + 1 <= verses.size() - 1 && (verses.at(verseOrder + 1)->_Position == Left || verses.at(verseOrder + 1)->_Position == CenteredVerse2)) {
+        if (verseOrder + 1 <= verses.size() - 1 && (verses.at(verseOrder + 1)._Position == Left || verses.at(verseOrder + 1)._Position == CenteredVerse2)) {
             mesraOrdersForCompare[2] = verseOrder + 1;    //mesra above current mesra
         }
         if (mesraOrdersForCompare.at(0) == -1 && mesraOrdersForCompare.at(1) == -1 && mesraOrdersForCompare.at(2) == -1) {
@@ -1387,7 +2027,7 @@ bool DatabaseBrowser::isRhyme(const QList<GanjoorVerse*> &verses, const QString
         if (secondMesraOrder == -1) {
             continue;
         }
-        secondMesra = Tools::cleanStringFast(verses.at(secondMesraOrder)->_Text, QStringList(""));
+        secondMesra = Tools::cleanStringFast(verses.at(secondMesraOrder)._Text, QStringList(""));
 
         int indexInSecondMesra = secondMesra.lastIndexOf(cleanedPhrase);
         int offset = cleanedPhrase.size();
@@ -1459,11 +2099,14 @@ QVariantList DatabaseBrowser::importGanjoorBookmarks(QString connectionID)
 
 QString DatabaseBrowser::getBeyt(int poemID, int firstMesraID, const QString &separator, QString connectionID)
 {
+    TRACE_SPAN("db", "DatabaseBrowser::getBeyt");
+
     QStringList mesras;
     if (isConnected(connectionID)) {
-        QSqlQuery q(database(connectionID));
-        QString selectQuery = QString("SELECT vorder, position, text FROM verse WHERE poem_id = %1 and vorder >= %2 ORDER BY vorder LIMIT 2").arg(poemID).arg(firstMesraID);
-        q.exec(selectQuery);
+        QSqlQuery q = preparedQuery("SELECT vorder, position, text FROM verse WHERE poem_id = ? and vorder >= ? ORDER BY vorder LIMIT 2", connectionID);
+        q.addBindValue(poemID);
+        q.addBindValue(firstMesraID);
+        q.exec();
         QSqlRecord qrec;
         bool centeredVerse1 = false;
         while (q.next()) {
@@ -1500,6 +2143,7 @@ QString DatabaseBrowser::getBeyt(int poemID, int firstMesraID, const QString &se
                 break;
             }
         }
+        q.finish();
     }
     if (!mesras.isEmpty()) {
         return mesras.join(separator);
@@ -1510,18 +2154,15 @@ QString DatabaseBrowser::getBeyt(int poemID, int firstMesraID, const QString &se
 bool DatabaseBrowser::poetHasSubCats(int poetID, const QString &connectionID)
 {
     if (isConnected(connectionID)) {
-        QSqlDatabase dataBaseObject = database(connectionID);
-
-        QSqlQuery q(dataBaseObject);
-        q.exec("SELECT id, text FROM cat WHERE poet_id = " + QString::number(poetID));
+        QSqlQuery q = preparedQuery("SELECT id, text FROM cat WHERE poet_id = ?", connectionID);
+        q.addBindValue(poetID);
+        q.exec();
 
         q.first();
-        if (q.isValid() && q.isActive()) {
-            return true;
-        }
-        else {
-            return false;
-        }
+        const bool hasSubCats = q.isValid() && q.isActive();
+        q.finish();
+
+        return hasSubCats;
     }
     return false;
 }
@@ -1687,6 +2328,10 @@ bool DatabaseBrowser::poetHasSubCats(int poetID, const QString &connectionID)
 
 void DatabaseBrowser::addDataSets()
 {
+    if (!DataBaseUpdater::canInstall()) {
+        return;
+    }
+
     if (!DatabaseBrowser::dbUpdater) {
         DatabaseBrowser::dbUpdater = new DataBaseUpdater(0, Qt::WindowStaysOnTopHint);
     }
@@ -1726,7 +2371,9 @@ bool DatabaseBrowser::createEmptyDataBase(const QString &connectionID)
         q.exec("CREATE INDEX cat_pid ON cat(parent_id ASC);");
         q.exec("CREATE INDEX poem_cid ON poem(cat_id ASC);");
         q.exec("CREATE INDEX verse_pid ON verse(poem_id ASC);");
-        return dataBaseObject.commit();
+        const bool created = dataBaseObject.commit();
+        schemaChanged();
+        return created;
     }
     return false;
 }
@@ -1810,6 +2457,8 @@ static void debugCatPath(const QList<GanjoorCat> &catPath, const QString &extra)
 
 void DatabaseBrowser::storeAsDataset(const CatContents &importData, const QList<GanjoorCat> &catPath, bool storeAsGDB, const QString &toConnectionID)
 {
+    TRACE_SPAN("import", "DatabaseBrowser::storeAsDataset");
+
     if (!isConnected(toConnectionID) || catPath.isEmpty() || importData.isNull()) {
         return;
     }
@@ -22,8 +22,12 @@
 #ifndef DATABASEBROWSER_H
 #define DATABASEBROWSER_H
 
+#include <QAtomicInt>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
+#include <QPair>
 #include <QWidget>
 #include <QString>
 #include <QSqlDatabase>
@@ -32,6 +36,7 @@
 #include <QSqlRecord>
 #include <QProgressDialog>
 #include <QVariant>
+#include <QVector>
 
 #include "databaseupdater.h"
 #include "databaseelements.h"
@@ -46,6 +51,7 @@
 #endif
 
 class ConcurrentTask;
+class PoemPack;
 
 typedef QMap<int, QString> SearchResults;
 
@@ -54,6 +60,17 @@ class DatabaseBrowser : public QObject
 {
     Q_OBJECT
 public:
+    // how connections to default database are opened
+    enum AccessMode {
+        ReadWrite,
+        // read-only connections that map the whole of database into memory
+        ReadOnly,
+        // same as ReadOnly and file is opened as 'immutable', it's opted in
+        // by 'DatabaseBrowser/ImmutableMode' when database is on read-only media,
+        // it's the same as ReadOnly on Qt 4
+        Immutable
+    };
+
     static DatabaseBrowser* instance();
     ~DatabaseBrowser();
 
@@ -65,24 +82,58 @@ public:
     static QString defaultConnectionId();
     static QString defaultDatabasename();
     static void setDefaultDatabasename(const QString &databaseName);
-
-    bool isConnected(const QString &connectionID = defaultConnectionId());
-    bool isValid(QString connectionID = defaultConnectionId());
-
-    bool isRhyme(const QList<GanjoorVerse*> &verses, const QString &phrase, int verseOrder = -1);
-    bool isRadif(const QList<GanjoorVerse*> &verses, const QString &phrase, int verseOrder = -1);
+    // it has to be set before any connection to default database is opened
+    static void setAccessMode(AccessMode mode);
+    static AccessMode accessMode();
+
+    // Returns a prepared statement from connection's LRU cache, caller binds
+    // values and exec() it, then finish() releases the statement's read lock.
+    // The cached QSqlQuery is shared, a nested call with the same statement
+    // while it's still active (not finished) gets a newly prepared query.
+    // A statement that fails to prepare (e.g. a column missing in an old
+    // database) is returned unprepared without retrying until the schema
+    // changes, its exec() fails with the prepare error.
+    static QSqlQuery preparedQuery(const QString &statement, const QString &connectionID = defaultConnectionId());
+    static QString preparedQueriesReport();
+    // read-only connections are used for searching and browsing in worker threads
+    static void setQueryOnly(const QString &connectionID, bool queryOnly);
+
+    // read-only pack that replaces SQL queries of the default database when it is
+    // opened ReadOnly or Immutable, otherwise 0
+    static PoemPack* poemPack(const QString &connectionID = defaultConnectionId());
+
+    static bool isConnected(const QString &connectionID = defaultConnectionId());
+    static bool isValid(QString connectionID = defaultConnectionId());
+    // creates Ganjoor tables in an empty database
+    static bool createEmptyDataBase(const QString &connectionID = defaultConnectionId());
+
+    bool isRhyme(const QVector<GanjoorVerse> &verses, const QString &phrase, int verseOrder = -1);
+    bool isRadif(const QVector<GanjoorVerse> &verses, const QString &phrase, int verseOrder = -1);
 
     QVariantList importGanjoorBookmarks(QString connectionID = defaultConnectionId());
     QString getBeyt(int poemID, int firstMesraID,  const QString &separator = "       "/*7 spaces*/, QString connectionID = defaultConnectionId());
 
-    QList<GanjoorPoet*> getDataBasePoets(const QString fileName);
-    QList<GanjoorPoet*> getConflictingPoets(const QString fileName, const QString &toConnectionID = defaultConnectionId());
+    QVector<GanjoorPoet> getDataBasePoets(const QString fileName);
+    QVector<GanjoorPoet> getConflictingPoets(const QString fileName, const QString &toConnectionID = defaultConnectionId());
+
+    // value based results, they are stored contiguously and don't need to be deleted
+    QVector<GanjoorPoet> poets(const QString &connectionID = defaultConnectionId(), bool sort = true);
+    QVector<GanjoorCat> subCategories(int CatID, const QString &connectionID = defaultConnectionId());
+    QVector<GanjoorPoem> poems(int CatID, const QString &connectionID = defaultConnectionId());
+    QVector<GanjoorVerse> verses(int PoemID, const QString &connectionID = defaultConnectionId());
+    QVector<GanjoorVerse> verses(int PoemID, int Count, const QString &connectionID = defaultConnectionId());
+
+    // pointer based results, items are owned by caller
     QList<GanjoorPoet*> getPoets(const QString &connectionID = defaultConnectionId(), bool sort = true);
     QList<GanjoorCat*> getSubCategories(int CatID, const QString &connectionID = defaultConnectionId());
     QList<GanjoorCat> getParentCategories(GanjoorCat Cat, const QString &connectionID = defaultConnectionId());
     QList<GanjoorPoem*> getPoems(int CatID, const QString &connectionID = defaultConnectionId());
     QList<GanjoorVerse*> getVerses(int PoemID, const QString &connectionID = defaultConnectionId());
     QList<GanjoorVerse*> getVerses(int PoemID, int Count, const QString &connectionID = defaultConnectionId());
+    // poems of category and all of its descendants, ordered by category tree
+    QList<GanjoorPoem> getPoemsOfSubtree(int CatID, const QString &connectionID = defaultConnectionId());
+    // verses of many poems by just one query, keyed by poem id
+    QMap<int, QList<GanjoorVerse> > getVersesOfPoems(const QList<int> &poemIDs, const QString &connectionID = defaultConnectionId());
 
     QString getFirstMesra(int PoemID, const QString &connectionID = defaultConnectionId());//just first Mesra
     GanjoorCat getCategory(int CatID, const QString &connectionID = defaultConnectionId());
@@ -105,12 +156,18 @@ public:
     //QList<int> getPoemIDsContainingPhrase_NewMethod(const QString &phrase, int PoetID, bool skipNonAlphabet);
     //QStringList getVerseListContainingPhrase(int PoemID, const QString &phrase);
     //another new approch
+    // SQL that selects candidate verses (or titles) for the most selective phrases of 'phraseList'
+    static QString searchQuery(const QString &currentSelectionPath, const QStringList &phraseList, QStringList* excludeWhenCleaning = 0, const QString &connectionID = QString());
+    // arguments of a search task for 'phraseList'
+    static QVariantHash searchArguments(const QString &currentSelectionPath, const QString &currentSelectionPathTitle, const QStringList &phraseList, const QStringList &excludedList = QStringList(), bool* canceled = 0, bool slowSearch = false, const QString &connectionID = defaultConnectionId());
     bool getPoemIDsByPhrase(ConcurrentTask* searchTask, const QString &currentSelectionPath, const QString &currentSelectionPathTitle, const QStringList &phraseList, const QStringList &excludedList = QStringList(), bool* canceled = 0, bool slowSearch = false, const QString &connectionID = defaultConnectionId());
 
     //Faal
     int getRandomPoemID(int* CatID, const QString &connectionID = defaultConnectionId());
-    void removePoetFromDataBase(int PoetID, const QString &connectionID = defaultConnectionId());
-    bool importDataBase(const QString &fromFileName, const QString &toConnectionID = defaultConnectionId());
+    // 'notify' emits databaseUpdated(), a caller that changes database in a transaction
+    // passes false and emits it once after commit
+    void removePoetFromDataBase(int PoetID, const QString &connectionID = defaultConnectionId(), bool notify = true);
+    bool importDataBase(const QString &fromFileName, const QString &toConnectionID = defaultConnectionId(), bool notify = true);
     // Returns database connection for thread, creates new connection if not exists
     QSqlDatabase databaseForThread(QThread* thread, const QString &baseConnectionID = defaultConnectionId());
 
@@ -127,7 +184,6 @@ private:
     Q_DISABLE_COPY(DatabaseBrowser)
     DatabaseBrowser(const QString &sqliteDbCompletePath = "ganjoor.s3db");
 
-    bool createEmptyDataBase(const QString &connectionID = defaultConnectionId());
     bool poetHasSubCats(int poetID, const QString &connectionID = defaultConnectionId());
 
 //    SearchResults startSearch(const QString &strQuery, const QSqlDatabase &db, int PoetID, const QStringList &phraseList,
@@ -142,20 +198,72 @@ private:
     int createCatPathOnNeed(QList<GanjoorCat> &catPath, const QString &description = QString(), const QString &connectionID = defaultConnectionId());
     void removeCatFromDataBase(const GanjoorCat &gCat, const QString &connectionID = defaultConnectionId());
 
-    static bool comparePoetsByName(GanjoorPoet* poet1, GanjoorPoet* poet2);
-    static bool compareCategoriesByName(GanjoorCat* cat1, GanjoorCat* cat2);
+    static bool comparePoetsByName(const GanjoorPoet &poet1, const GanjoorPoet &poet2);
+    static bool compareCategoriesByName(const GanjoorCat &cat1, const GanjoorCat &cat2);
     bool m_addRemoteDataSet;
 
+    // connection registry, all of it is guarded by 's_connectionsMutex'
+    typedef QPair<QThread*, QString> ThreadFileKey;
+    // (thread, requested file name) -> connection id
+    static QHash<ThreadFileKey, QString> s_connectionIds;
+    // requested file name -> canonical path, resolving it needs file system access
+    static QHash<QString, QString> s_canonicalPaths;
+    // canonical path -> connection ids, any of them can be cloned for a new thread
+    static QMultiHash<QString, QString> s_fileConnections;
     static QMultiHash<QThread*, QString> s_threadConnections;
+    static QMutex s_connectionsMutex;
+
+    static void removeConnection(const QString &connectionID);
+    static void removeConnectionsOfThread(QThread* thread);
+    friend class ThreadConnectionsGuard;
+
+    static void configureConnection(QSqlDatabase &db, bool readOnly = false);
+    static void releasePreparedQueries(const QString &connectionID);
+
+    struct PreparedQueries {
+        PreparedQueries() : schemaVersion(0) {}
+
+        QHash<QString, QSqlQuery> queries;
+        // least recently used statement is the first one
+        QStringList usage;
+        // statements that failed to prepare, dropped when 'schemaVersion' is outdated
+        QHash<QString, QSqlQuery> failures;
+        int schemaVersion;
+    };
+
+    // increased when tables or columns are added
+    static void schemaChanged();
+
+    static QHash<QString, PreparedQueries*> s_preparedQueries;
+    static QMutex s_preparedQueriesMutex;
+    static QAtomicInt s_preparesCount;
+    static QAtomicInt s_preparesAvoidedCount;
+    static QAtomicInt s_evictionsCount;
+    static QAtomicInt s_schemaVersion;
+
+    // flattened category tree, used for picking a uniformly random poem of a subtree
+    struct PoemSampler {
+        // poem ids in pre-order of categories, so each subtree is a contiguous range
+        QVector<int> poemIDs;
+        QVector<int> poemCats;
+        // category id -> [begin, end) of its subtree within 'poemIDs'
+        QHash<int, QPair<int, int> > subtreeRanges;
+    };
+
+    PoemSampler* poemSampler(const QString &connectionID);
+    QHash<QString, PoemSampler*> m_poemSamplers;
 
     static QString s_defaultConnectionId;
     static QString s_defaultDatabaseFileName;
     static bool s_isDefaultDatabaseSet;
+    static AccessMode s_accessMode;
 
     static DatabaseBrowser* s_instance;
 
 private slots:
     void removeThreadsConnections(QObject* obj = 0);
+    void invalidatePoemSampler(const QString &connectionID);
+    void invalidatePoemPack(const QString &connectionID);
 
 signals:
     void searchStatusChanged(const QString &);
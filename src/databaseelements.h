@@ -27,6 +27,11 @@
 
 inline QString qStringMacHelper(const QString &str)
 {
+    // most strings don't contain ZWNJ, so they are just shared
+    if (!str.contains(QChar(0x200C))) {
+        return str;
+    }
+
     QString tmp = str;
     tmp = tmp.replace(QChar(0x200C), QString(0x200F) + QString(0x200C) + QString(0x200F), Qt::CaseInsensitive);
     return tmp;
@@ -56,7 +61,7 @@ public:
         _Text = QString();
     }
 
-    inline void init(int PoemID = -1, int Order = -1, VersePosition Position = Single, QString Text = QString()) {
+    inline void init(int PoemID = -1, int Order = -1, VersePosition Position = Single, const QString &Text = QString()) {
         _PoemID = PoemID;
         _Order = Order;
         _Position = Position;
@@ -67,6 +72,7 @@ public:
 #endif
     }
 };
+Q_DECLARE_TYPEINFO(GanjoorVerse, Q_MOVABLE_TYPE);
 
 class GanjoorPoem
 {
@@ -87,7 +93,7 @@ public:
         _HighlightText = QString();
     }
 
-    inline void init(int ID = -1, int CatID = -1, QString Title = QString(), QString Url = QString(), bool Faved = false, QString HighlightText = QString()) {
+    inline void init(int ID = -1, int CatID = -1, const QString &Title = QString(), const QString &Url = QString(), bool Faved = false, const QString &HighlightText = QString()) {
         _ID = ID;
         _CatID = CatID;
 #ifdef Q_OS_MAC
@@ -109,6 +115,7 @@ public:
         _Faved = false;
     }
 };
+Q_DECLARE_TYPEINFO(GanjoorPoem, Q_MOVABLE_TYPE);
 
 class GanjoorPoet
 {
@@ -125,7 +132,7 @@ public:
         _Description = QString();
     }
 
-    inline void init(int ID = -1, QString Name = QString(), int CatID = -1, QString description = QString()) {
+    inline void init(int ID = -1, const QString &Name = QString(), int CatID = -1, const QString &description = QString()) {
         _ID = ID;
         _CatID = CatID;
 #ifdef Q_OS_MAC
@@ -139,6 +146,7 @@ public:
 
     inline bool isNull() const {return _ID == -1;}
 };
+Q_DECLARE_TYPEINFO(GanjoorPoet, Q_MOVABLE_TYPE);
 
 struct GanjoorCat {
     int _ID;
@@ -163,7 +171,7 @@ struct GanjoorCat {
         _ParentID = -1;
         _Url = QString();
     }
-    inline void init(int ID = -1, int PoetID = -1, QString Text = "", int ParentID = -1, QString Url = "") {
+    inline void init(int ID = -1, int PoetID = -1, const QString &Text = "", int ParentID = -1, const QString &Url = "") {
         _ID = ID;
         _PoetID = PoetID;
 #ifdef Q_OS_MAC
@@ -175,6 +183,7 @@ struct GanjoorCat {
         _Url = Url;
     }
 };
+Q_DECLARE_TYPEINFO(GanjoorCat, Q_MOVABLE_TYPE);
 
 #include <QList>
 #include <QMap>
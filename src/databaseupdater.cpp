@@ -183,6 +183,18 @@ void DataBaseUpdater::fillRepositoryList()
     ui->comboBoxRepoList->insertSeparator(ui->comboBoxRepoList->count() - 1);
 }
 
+bool DataBaseUpdater::canInstall(QWidget* parent)
+{
+    if (DatabaseBrowser::accessMode() == DatabaseBrowser::ReadWrite) {
+        return true;
+    }
+
+    QMessageBox::warning(parent ? parent : sApp->activeWindow(), tr("Error!"),
+                         tr("The database is opened read-only, new data sets can not be installed.\nDataBase Path: %1")
+                         .arg(DatabaseBrowser::databaseFileFromID(DatabaseBrowser::defaultConnectionId())));
+    return false;
+}
+
 void DataBaseUpdater::importDataBase(const QString &fileName, bool* ok)
 {
     QSqlDatabase dataBaseObject = DatabaseBrowser::database();
@@ -194,7 +206,7 @@ void DataBaseUpdater::importDataBase(const QString &fileName, bool* ok)
         }
         return;
     }
-    QList<GanjoorPoet*> poetsConflictList = sApp->databaseBrowser()->getConflictingPoets(fileName);
+    const QVector<GanjoorPoet> poetsConflictList = sApp->databaseBrowser()->getConflictingPoets(fileName);
 
     dataBaseObject.transaction();
 
@@ -205,7 +217,7 @@ void DataBaseUpdater::importDataBase(const QString &fileName, bool* ok)
         warnAboutConflict.setText(tr("There are some conflict with your installed database. If you continue, these poets will be removed!"));
         QString details = tr("These poets are present in installed database:\n");
         for (int i = 0; i < poetsConflictList.size(); ++i) {
-            details += poetsConflictList.at(i)->_Name + "\n";
+            details += poetsConflictList.at(i)._Name + "\n";
         }
         warnAboutConflict.setDetailedText(details);
         warnAboutConflict.setStandardButtons(QMessageBox::Ok | QMessageBox::Cancel);
@@ -219,15 +231,17 @@ void DataBaseUpdater::importDataBase(const QString &fileName, bool* ok)
             return;
         }
 
-        foreach (GanjoorPoet* poet, poetsConflictList) {
-            sApp->databaseBrowser()->removePoetFromDataBase(poet->_ID);
+        // databaseUpdated() is emitted once after commit, a rolled back import doesn't change database
+        foreach (const GanjoorPoet &poet, poetsConflictList) {
+            sApp->databaseBrowser()->removePoetFromDataBase(poet._ID, DatabaseBrowser::defaultConnectionId(), false);
         }
     }
 
     //QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-    if (sApp->databaseBrowser()->importDataBase(fileName)) {
+    if (sApp->databaseBrowser()->importDataBase(fileName, DatabaseBrowser::defaultConnectionId(), false)) {
         dataBaseObject.commit();
+        QMetaObject::invokeMethod(sApp->databaseBrowser(), "databaseUpdated", Q_ARG(QString, DatabaseBrowser::defaultConnectionId()));
         if (ok) {
             *ok = true;
         }
@@ -601,6 +615,11 @@ void DataBaseUpdater::installItemToDB(const QString &fullFilePath, const QString
 
 void DataBaseUpdater::installItemToDB(const QString &fileName, const QString &path, const QString &fileType)
 {
+    if (!canInstall(this)) {
+        installCompleted = false;
+        return;
+    }
+
     QString type = fileType;
     if (type == ".gdb" || type == "gdb" || type == ".s3db") {
         type = "s3db";
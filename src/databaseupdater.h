@@ -45,6 +45,8 @@ public:
     DataBaseUpdater(QWidget* parent = 0, Qt::WindowFlags f = 0);
     static QStringList repositories();
     static void setRepositories(const QStringList &urls);
+    // false and warns when the database is opened read-only (see DatabaseBrowser::AccessMode)
+    static bool canInstall(QWidget* parent = 0);
 
     void installItemToDB(const QString &fileName, const QString &filePath, const QString &fileType);
     void installItemToDB(const QString &fullFilePath, const QString &fileType = "");
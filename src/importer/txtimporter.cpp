@@ -20,6 +20,7 @@
  ***************************************************************************/
 #include "txtimporter.h"
 #include "importermanager.h"
+#include "tracer.h"
 
 #include <QObject>
 #include <QDebug>
@@ -51,6 +52,8 @@ QString TxtImporter::suffix() const
 
 void TxtImporter::import(const QString &data)
 {
+    TRACE_SPAN("import", "TxtImporter::import");
+
     m_catContents.clear();
 
     QString rawdata = data;
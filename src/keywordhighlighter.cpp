@@ -0,0 +1,129 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "keywordhighlighter.h"
+#include "tools.h"
+
+#include <QtAlgorithms>
+
+// number of distinct texts (rows, blocks) that their spans are kept
+#define SPAN_CACHE_SIZE 1024
+
+static bool longerKeyword(const QString &keyword1, const QString &keyword2)
+{
+    return keyword1.size() > keyword2.size();
+}
+
+KeywordHighlighter::KeywordHighlighter(const QStringList &keywords)
+    : m_spanCache(SPAN_CACHE_SIZE)
+{
+    setKeywords(keywords);
+}
+
+void KeywordHighlighter::setKeywords(const QStringList &keywords)
+{
+    m_keywords = keywords;
+    m_keywords.removeAll(QString());
+    m_keywords.removeDuplicates();
+    m_spanCache.clear();
+
+    // alternation matches leftmost alternative first, so a keyword that is
+    // a prefix of another one (e.g. gol and golestan) has to come after it
+    QStringList sortedKeywords = m_keywords;
+    qStableSort(sortedKeywords.begin(), sortedKeywords.end(), longerKeyword);
+
+    QStringList patterns;
+    foreach (const QString &keyword, sortedKeywords) {
+        patterns << keywordPattern(keyword);
+    }
+
+    m_regExp = patterns.isEmpty()
+               ? QRegExp()
+               : QRegExp("(" + patterns.join(")|(") + ")", Qt::CaseInsensitive);
+}
+
+KeywordHighlighter::Spans KeywordHighlighter::matches(const QString &text) const
+{
+    if (isEmpty() || text.isEmpty()) {
+        return Spans();
+    }
+
+    if (const Spans* cached = m_spanCache.object(text)) {
+        return *cached;
+    }
+
+    Spans* spans = new Spans;
+    int pos = 0;
+    while ((pos = m_regExp.indexIn(text, pos)) != -1) {
+        const int length = m_regExp.matchedLength();
+        if (length == 0) {
+            ++pos;
+            continue;
+        }
+
+        Span span;
+        span.start = pos;
+        span.length = length;
+        spans->append(span);
+
+        pos += length;
+    }
+
+    const Spans result = *spans;
+    m_spanCache.insert(text, spans);
+
+    return result;
+}
+
+QString KeywordHighlighter::keywordPattern(const QString &keyword)
+{
+    const QString maybeOthers = "[" + Tools::OTHER_GLYPHS + "]*";
+
+    QString pattern;
+    for (int i = 0; i < keyword.size(); ++i) {
+        const QChar ch = keyword.at(i);
+
+        if (ch == QLatin1Char('@')) {
+            //replace wildcard by word chars
+            pattern += "\\S*";
+            continue;
+        }
+
+        if (Tools::AE_Variant.at(0) == QString(ch)) {
+            pattern += "(" + Tools::AE_Variant.join("|") + ")";
+        }
+        else if (Tools::Ye_Variant.at(0) == QString(ch)) {
+            pattern += "(" + Tools::Ye_Variant.join("|") + ")";
+        }
+        else if (Tools::He_Variant.at(0) == QString(ch)) {
+            pattern += "(" + Tools::He_Variant.join("|") + ")";
+        }
+        else if (Tools::Ve_Variant.at(0) == QString(ch)) {
+            pattern += "(" + Tools::Ve_Variant.join("|") + ")";
+        }
+        else {
+            pattern += QRegExp::escape(QString(ch));
+        }
+        pattern += maybeOthers;
+    }
+
+    return pattern;
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KEYWORDHIGHLIGHTER_H
+#define KEYWORDHIGHLIGHTER_H
+
+#include <QCache>
+#include <QRegExp>
+#include <QStringList>
+#include <QVector>
+
+// Compiles a keyword set once into a single case insensitive expression
+// (glyph and letter variant aware) and caches the matched spans per text,
+// so repaints of the same row only apply the precomputed ranges.
+class KeywordHighlighter
+{
+public:
+    struct Span {
+        int start;
+        int length;
+    };
+    typedef QVector<Span> Spans;
+
+    explicit KeywordHighlighter(const QStringList &keywords = QStringList());
+
+    void setKeywords(const QStringList &keywords);
+    QStringList keywords() const { return m_keywords; }
+    bool isEmpty() const { return m_regExp.isEmpty(); }
+
+    Spans matches(const QString &text) const;
+    void clearCache() { m_spanCache.clear(); }
+
+    static QString keywordPattern(const QString &keyword);
+
+private:
+    QStringList m_keywords;
+    mutable QRegExp m_regExp;
+    mutable QCache<QString, Spans> m_spanCache;
+};
+
+#endif // KEYWORDHIGHLIGHTER_H
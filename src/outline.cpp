@@ -49,27 +49,151 @@
 #include <QMenu>
 #include <QHeaderView>
 #include <QSearchLineEdit>
+#include <QThread>
+#include <QtConcurrentRun>
 
 #include "outline.h"
 #include "searchitemdelegate.h"
 #include "tools.h"
 #include "outlinemodel.h"
 #include "saagharapplication.h"
+#include "databasebrowser.h"
 
 #ifdef DEV_TOOLS
 #include <QFileDialog>
 #include <QTextEdit>
-
-#include "databasebrowser.h"
 #endif
 
+// runs on a worker thread
+static OutlineTitleIndex buildTitleIndex(const QString &connectionID)
+{
+    OutlineTitleIndex titleIndex;
+
+    const QString threadConnectionID = DatabaseBrowser::getIdForDataBase(DatabaseBrowser::databaseFileFromID(connectionID), QThread::currentThread());
+
+    QSqlQuery q = DatabaseBrowser::preparedQuery("SELECT id, parent_id, text FROM cat", threadConnectionID);
+    q.exec();
+
+    while (q.next()) {
+        const int id = q.value(0).toInt();
+
+        titleIndex.ids.append(id);
+        titleIndex.titles.append(Tools::cleanString(q.value(2).toString()));
+        titleIndex.parents.insert(id, q.value(1).toInt());
+    }
+    q.finish();
+
+    return titleIndex;
+}
+
+// runs on a worker thread
+static OutlineFilterResult runOutlineFilter(OutlineFilterResult request)
+{
+    OutlineFilterResult result = request;
+    result.matches.clear();
+
+    if (result.index.ids.isEmpty()) {
+        result.index = buildTitleIndex(result.connectionID);
+        request.narrow = false;
+    }
+
+    const OutlineTitleIndex &titleIndex = result.index;
+    const int count = request.narrow ? request.matches.size() : titleIndex.ids.size();
+
+    for (int i = 0; i < count; ++i) {
+        const int pos = request.narrow ? request.matches.at(i) : i;
+
+        if (titleIndex.titles.at(pos).contains(result.query)) {
+            result.matches.append(pos);
+            result.matchedIDs.insert(titleIndex.ids.at(pos));
+        }
+    }
+
+    foreach (int id, result.matchedIDs) {
+        int parentID = titleIndex.parents.value(id, 0);
+
+        while (parentID != 0 && !result.ancestorIDs.contains(parentID)) {
+            result.ancestorIDs.insert(parentID);
+            parentID = titleIndex.parents.value(parentID, 0);
+        }
+    }
+
+    // a matched category is shown collapsed with all of its children
+    result.ancestorIDs.subtract(result.matchedIDs);
+
+    return result;
+}
+
+OutlineFilterModel::OutlineFilterModel(QObject* parent)
+    : QSortFilterProxyModel(parent),
+      m_active(false)
+{
+}
+
+void OutlineFilterModel::setFilterResult(const OutlineFilterResult &result)
+{
+    m_active = true;
+    m_matchedIDs = result.matchedIDs;
+    m_ancestorIDs = result.ancestorIDs;
+    m_parents = result.index.parents;
+
+    invalidateFilter();
+}
+
+void OutlineFilterModel::clearFilterResult()
+{
+    if (!m_active) {
+        return;
+    }
+
+    m_active = false;
+    m_matchedIDs.clear();
+    m_ancestorIDs.clear();
+    m_parents.clear();
+
+    invalidateFilter();
+}
+
+bool OutlineFilterModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+{
+    if (!m_active) {
+        return true;
+    }
+
+    int id = sourceModel()->index(source_row, 0, source_parent).data(OutlineModel::IDRole).toInt();
+
+    if (m_ancestorIDs.contains(id)) {
+        return true;
+    }
+
+    // the category or one of its parents is matched
+    while (id != 0) {
+        if (m_matchedIDs.contains(id)) {
+            return true;
+        }
+        id = m_parents.value(id, 0);
+    }
+
+    return false;
+}
+
 OutlineTree::OutlineTree(QWidget* parent)
     : QWidget(parent)
 {
     pressedMouseButton = Qt::LeftButton;
 
+    m_filterPending = false;
+    m_filterGeneration = 0;
+    m_indexGeneration = 0;
+
+    m_filterModel = new OutlineFilterModel(this);
+    m_filterModel->setSourceModel(sApp->outlineModel());
+
+    m_filterWatcher = new QFutureWatcher<OutlineFilterResult>(this);
+    connect(m_filterWatcher, SIGNAL(finished()), this, SLOT(applyFilterResult()));
+
     m_outlineView = new QTreeView(parent);
-    m_outlineView->setModel(sApp->outlineModel());
+    m_outlineView->setModel(m_filterModel);
     m_outlineView->setObjectName("outlineTreeWidget");
     m_outlineView->setLayoutDirection(Qt::RightToLeft);
     m_outlineView->setTextElideMode(Qt::ElideMiddle);
@@ -123,60 +247,111 @@ void OutlineTree::refreshTree()
 {
     sApp->outlineModel(m_connectionID)->clear();
 
-    m_outlineView->setModel(sApp->outlineModel(m_connectionID));
+    m_filterModel->setSourceModel(sApp->outlineModel(m_connectionID));
+    resetFilterIndex();
+}
+
+void OutlineTree::resetFilterIndex()
+{
+    ++m_indexGeneration;
+    m_titleIndex = OutlineTitleIndex();
+    m_lastFilterResult = OutlineFilterResult();
+    m_filterModel->clearFilterResult();
+
+    const QString filterText = m_filterText;
+    m_filterText.clear();
+    filterItems(filterText);
 }
 
-bool OutlineTree::filterItems(const QString &str, const QModelIndex &parent)
+void OutlineTree::filterItems(const QString &str)
 {
-    int childrenSize = m_outlineView->model()->rowCount(parent);
+    const QString cleanStr = Tools::cleanString(str);
 
-    bool result = true;
+    if (cleanStr == m_filterText) {
+        return;
+    }
 
-    for (int i = 0; i < childrenSize; ++i) {
-        QModelIndex ithChild = m_outlineView->model()->index(i, 0, parent);
-
-        QString text = ithChild.data().toString();
-        text = Tools::cleanString(text);
-        QString cleanStr = Tools::cleanString(str);
-        if (!cleanStr.isEmpty() && !text.contains(cleanStr)) {
-            // if all its children are hidden it should be hidden, too.
-            if (m_outlineView->model()->rowCount(ithChild) > 0) {
-                bool tmp = filterItems(cleanStr, ithChild);
-                if (!tmp) {
-                    m_outlineView->setExpanded(ithChild, true);
-                }
+    m_filterText = cleanStr;
+    ++m_filterGeneration;
 
-                m_outlineView->setRowHidden(i, parent, tmp);
-                result = result && tmp;
-            }
-            else {
-                m_outlineView->setRowHidden(i, parent, true);
-                //return true when all children are hidden
-                result = result && true;
-            }
-        }
-        else {
-            recursivelyUnHide(ithChild);
-            m_outlineView->setExpanded(ithChild, false);
-            //return false when at least one child is visible
-            result = result && false;
-        }
+    if (cleanStr.isEmpty()) {
+        m_filterPending = false;
+        m_filterModel->clearFilterResult();
+        m_outlineView->collapseAll();
+        return;
     }
 
-    return result;
+    // just the last query is matched after the running one
+    if (m_filterWatcher->isRunning()) {
+        m_filterPending = true;
+        return;
+    }
+
+    startFilter(cleanStr);
+}
+
+void OutlineTree::startFilter(const QString &cleanedQuery)
+{
+    OutlineFilterResult request;
+    request.generation = m_filterGeneration;
+    request.indexGeneration = m_indexGeneration;
+    request.connectionID = m_connectionID.isEmpty() ? DatabaseBrowser::defaultConnectionId() : m_connectionID;
+    request.query = cleanedQuery;
+    request.index = m_titleIndex;
+
+    // titles containing the longer query are a subset of previous matches
+    if (!m_lastFilterResult.query.isEmpty() && cleanedQuery.contains(m_lastFilterResult.query)) {
+        request.narrow = true;
+        request.matches = m_lastFilterResult.matches;
+    }
+
+    m_filterWatcher->setFuture(QtConcurrent::run(runOutlineFilter, request));
 }
 
-void OutlineTree::recursivelyUnHide(const QModelIndex &parent)
+void OutlineTree::applyFilterResult()
 {
-    int childrenSize = m_outlineView->model()->rowCount(parent);
-    if (parent.isValid()) {
-        m_outlineView->setRowHidden(parent.row(), parent.parent(), false);
+    const OutlineFilterResult result = m_filterWatcher->result();
+
+    if (result.indexGeneration != m_indexGeneration) {
+        // tree or its connection was changed meanwhile
+        if (m_filterPending) {
+            m_filterPending = false;
+            startFilter(m_filterText);
+        }
+        return;
     }
 
+    m_titleIndex = result.index;
+    m_lastFilterResult = result;
+
+    if (m_filterPending) {
+        m_filterPending = false;
+        startFilter(m_filterText);
+        return;
+    }
+
+    if (result.generation != m_filterGeneration) {
+        return;
+    }
+
+    m_outlineView->setUpdatesEnabled(false);
+    m_filterModel->setFilterResult(result);
+    m_outlineView->collapseAll();
+    expandFilteredParents();
+    m_outlineView->setUpdatesEnabled(true);
+}
+
+void OutlineTree::expandFilteredParents(const QModelIndex &parent)
+{
+    const int childrenSize = m_filterModel->rowCount(parent);
+
     for (int i = 0; i < childrenSize; ++i) {
-        QModelIndex ithChild = m_outlineView->model()->index(i, 0, parent);
+        const QModelIndex ithChild = m_filterModel->index(i, 0, parent);
 
-        recursivelyUnHide(ithChild);
+        if (m_filterModel->isExpandedByFilter(ithChild.data(OutlineModel::IDRole).toInt())) {
+            m_outlineView->setExpanded(ithChild, true);
+            expandFilteredParents(ithChild);
+        }
     }
 }
 
@@ -293,7 +468,8 @@ void OutlineTree::setConnectionID(const QString &connectionID)
 {
     if (!connectionID.isEmpty() && connectionID != m_connectionID) {
         m_connectionID = connectionID;
-        m_outlineView->setModel(sApp->outlineModel(m_connectionID));
+        m_filterModel->setSourceModel(sApp->outlineModel(m_connectionID));
+        resetFilterIndex();
     }
 }
 
@@ -351,10 +527,10 @@ void OutlineTree::createAudioList(int catID, bool askInputMediaList)
                                       "    <audio_artist>%8</audio_artist>\n"
                                       "    <audio_artist_url>%9</audio_artist_url>\n"
                                       "</PoemAudio>");
-    QList<GanjoorPoem*> poems = sApp->databaseBrowser()->getPoems(catID, theConnectionID);
+    const QVector<GanjoorPoem> poems = sApp->databaseBrowser()->poems(catID, theConnectionID);
 
     for(int i = 0; i < poems.size(); ++i) {
-        GanjoorPoem* poem = poems.at(i);
+        const GanjoorPoem &poem = poems.at(i);
         QString hqLink;
         QString lowLink;
         if (hqMediaLinks.size() > i) {
@@ -365,13 +541,13 @@ void OutlineTree::createAudioList(int catID, bool askInputMediaList)
             lowLink = lowMediaLinks.at(i);
         }
 
-        audioList << poemAudio.arg(poem->_ID)
+        audioList << poemAudio.arg(poem._ID)
                      .arg(1)
                      .arg(QString())
                      .arg(QString())
                      .arg(hqLink)
                      .arg(lowLink)
-                     .arg(poem->_Title)
+                     .arg(poem._Title)
                      .arg(QString())
                      .arg(QString());
     }
@@ -45,11 +45,66 @@
 #ifndef OUTLINETREE_H
 #define OUTLINETREE_H
 
+#include <QFutureWatcher>
+#include <QHash>
 #include <QModelIndex>
+#include <QSet>
+#include <QSortFilterProxyModel>
+#include <QVector>
 #include <QWidget>
 
 class QTreeView;
 
+// cleaned titles of all categories, filtering uses it without populating the outline model
+struct OutlineTitleIndex {
+    QVector<int> ids;
+    QVector<QString> titles;
+    // category id -> parent id
+    QHash<int, int> parents;
+};
+
+struct OutlineFilterResult {
+    OutlineFilterResult() : generation(-1), indexGeneration(-1), narrow(false) {}
+
+    int generation;
+    // the title index is rebuilt when the tree or its connection changes
+    int indexGeneration;
+    QString connectionID;
+    QString query;
+    OutlineTitleIndex index;
+    // when 'narrow' is set, just these positions are matched again
+    bool narrow;
+    // positions of matched titles within 'index'
+    QVector<int> matches;
+    QSet<int> matchedIDs;
+    // categories that are shown and expanded because of a matched descendant
+    QSet<int> ancestorIDs;
+};
+
+class OutlineFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    OutlineFilterModel(QObject* parent = 0);
+
+    void setFilterResult(const OutlineFilterResult &result);
+    void clearFilterResult();
+
+    inline bool isExpandedByFilter(int catID) const {
+        return m_ancestorIDs.contains(catID);
+    }
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const;
+
+private:
+    bool m_active;
+    QSet<int> m_matchedIDs;
+    QSet<int> m_ancestorIDs;
+    QHash<int, int> m_parents;
+};
+
 class OutlineTree : public QWidget
 {
     Q_OBJECT
@@ -62,8 +117,8 @@ public:
     void setConnectionID(const QString &connectionID);
 
 private slots:
-    bool filterItems(const QString &str = QString(), const QModelIndex &parent = QModelIndex());
-    void recursivelyUnHide(const QModelIndex &parent = QModelIndex());
+    void filterItems(const QString &str = QString());
+    void applyFilterResult();
     void doubleClicked(const QModelIndex &index);
     void clicked(const QModelIndex &index);
     void pressed();
@@ -71,8 +126,20 @@ private slots:
 
 private:
     void createAudioList(int catID, bool askInputMediaList);
+    void startFilter(const QString &cleanedQuery);
+    void resetFilterIndex();
+    void expandFilteredParents(const QModelIndex &parent = QModelIndex());
 
     QTreeView* m_outlineView;
+    OutlineFilterModel* m_filterModel;
+    QFutureWatcher<OutlineFilterResult>* m_filterWatcher;
+    OutlineTitleIndex m_titleIndex;
+    // last applied result, a longer query just narrows its matches
+    OutlineFilterResult m_lastFilterResult;
+    QString m_filterText;
+    bool m_filterPending;
+    int m_filterGeneration;
+    int m_indexGeneration;
     Qt::MouseButtons pressedMouseButton;
 
     QString m_connectionID;
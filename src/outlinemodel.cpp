@@ -26,7 +26,7 @@
 #include "saagharwidget.h"
 
 struct OutlineNode {
-    OutlineNode() : parent(0), cat(0), populated(false) {}
+    OutlineNode() : parent(0), cat(0), row(-1), populated(false) {}
     ~OutlineNode() {
         qDeleteAll(children);
         children.clear();
@@ -34,11 +34,33 @@ struct OutlineNode {
     }
     OutlineNode* parent;
     GanjoorCat* cat;
+    // row within parent's children
+    int row;
 
     mutable QVector<OutlineNode*> children;
+    // category id/normalized title -> row of child
+    mutable QHash<int, int> childRowsByID;
+    mutable QHash<QString, int> childRowsByTitle;
     mutable bool populated;
 };
 
+// path sections may carry bidi marks and extra spaces around titles
+static QString normalizedTitle(const QString &title)
+{
+    QString normalized;
+    normalized.reserve(title.size());
+
+    for (int i = 0; i < title.size(); ++i) {
+        const ushort ch = title.at(i).unicode();
+        if (ch == 0x200E || ch == 0x200F || (ch >= 0x202A && ch <= 0x202E)) {
+            continue;
+        }
+        normalized.append(title.at(i));
+    }
+
+    return normalized.trimmed();
+}
+
 namespace
 {
 static QHash<QString, OutlineNode*> RootNodes;
@@ -93,6 +115,8 @@ void OutlineModel::clear(OutlineNode* parent) const
 
     qDeleteAll(parent->children);
     parent->children.clear();
+    parent->childRowsByID.clear();
+    parent->childRowsByTitle.clear();
     parent->populated = false;
 
     delete parent->cat;
@@ -109,18 +133,30 @@ QVector<OutlineNode*> OutlineModel::children(OutlineNode* parent, bool useCache)
 
     int parentId = (!parent->cat || parent->cat->_ID == -1) ? 0 : parent->cat->_ID;
 
-    QList<GanjoorCat*> cats = sApp->databaseBrowser()->getSubCategories(parentId, m_connectionID);
+    const QVector<GanjoorCat> cats = sApp->databaseBrowser()->subCategories(parentId, m_connectionID);
 
     QVector<OutlineNode*> nodeList;
     nodeList.reserve(cats.size());
+    parent->childRowsByID.clear();
+    parent->childRowsByID.reserve(cats.size());
+    parent->childRowsByTitle.clear();
+    parent->childRowsByTitle.reserve(cats.size());
 
     for (int i = 0; i < cats.size(); ++i) {
         OutlineNode* n = new OutlineNode();
-        n->cat = cats.at(i);
+        n->cat = new GanjoorCat(cats.at(i));
         n->parent = parent;
+        n->row = i;
         n->populated = false;
 
         nodeList.append(n);
+
+        parent->childRowsByID.insert(n->cat->_ID, i);
+        // for siblings with the same title the first one wins
+        const QString title = normalizedTitle(n->cat->_Text);
+        if (!parent->childRowsByTitle.contains(title)) {
+            parent->childRowsByTitle.insert(title, i);
+        }
     }
 
     parent->populated = true;
@@ -133,34 +169,20 @@ QModelIndex OutlineModel::find(const QString &key, const QModelIndex &parent) co
 {
     OutlineNode* n = node(parent);
 
-    QVector<OutlineNode*> parentChildren = children(n, true);
-
-    for (int i = 0; i < parentChildren.size(); ++i) {
-        OutlineNode* child = parentChildren.at(i);
+    const QVector<OutlineNode*> parentChildren = children(n, true);
+    const int row = n->childRowsByTitle.value(normalizedTitle(key), -1);
 
-        if (child && child->cat && child->cat->_Text == key) {
-            return index(i, 0, parent);
-        }
-    }
-
-    return QModelIndex();
+    return row < 0 ? QModelIndex() : createIndex(row, 0, parentChildren.at(row));
 }
 
 QModelIndex OutlineModel::find(int id, const QModelIndex &parent) const
 {
     OutlineNode* n = node(parent);
 
-    QVector<OutlineNode*> parentChildren = children(n, true);
+    const QVector<OutlineNode*> parentChildren = children(n, true);
+    const int row = n->childRowsByID.value(id, -1);
 
-    for (int i = 0; i < parentChildren.size(); ++i) {
-        OutlineNode* child = parentChildren.at(i);
-
-        if (child && child->cat && child->cat->_ID == id) {
-            return index(i, 0, parent);
-        }
-    }
-
-    return QModelIndex();
+    return row < 0 ? QModelIndex() : createIndex(row, 0, parentChildren.at(row));
 }
 
 OutlineModel::~OutlineModel()
@@ -186,17 +208,9 @@ QModelIndex OutlineModel::parent(const QModelIndex &child) const
         return QModelIndex();
     }
 
-    const QVector<OutlineNode*> grandParentChildren = par->parent
-            ? children(par->parent, true)
-            : children(RootNodes.value(m_connectionID), true);
-
-    Q_ASSERT(grandParentChildren.count() > 0);
-
-    int row = grandParentChildren.indexOf(par);
-
-    Q_ASSERT(row >= 0 && row < grandParentChildren.size());
+    Q_ASSERT(par->row >= 0);
 
-    return createIndex(row, 0, par);
+    return createIndex(par->row, 0, par);
 }
 
 int OutlineModel::rowCount(const QModelIndex &parent) const
@@ -0,0 +1,775 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "poempack.h"
+#include "databasebrowser.h"
+#include "searchresultwidget.h"
+#include "tools.h"
+#include "tracer.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSqlQuery>
+#include <QtAlgorithms>
+
+#include <string.h>
+
+const quint32 packVersion = 1;
+const quint32 byteOrderMark = 0x01020304;
+
+// opened packs by database file and database files that have no valid pack,
+// packs are never closed so forgotten ones are kept in 'retiredPacks'
+static QMutex packsMutex;
+static QHash<QString, PoemPack*> packs;
+static QSet<QString> missingPacks;
+static QList<PoemPack*> retiredPacks;
+
+// pack files of 'databaseFile', the newest one is the first
+static QStringList packFiles(const QString &databaseFile)
+{
+    const QFileInfo info(databaseFile);
+    const QDir dir(info.path());
+    const QStringList nameFilters = QStringList() << info.completeBaseName() + QLatin1String(".pack")
+                                    << info.completeBaseName() + QLatin1String(".*.pack");
+
+    QStringList files;
+    foreach (const QString &name, dir.entryList(nameFilters, QDir::Files, QDir::Time)) {
+        files << dir.filePath(name);
+    }
+
+    return files;
+}
+
+template <typename Record>
+static int indexOfID(const Record* records, int count, int id)
+{
+    int begin = 0;
+    int end = count;
+    while (begin < end) {
+        const int middle = (begin + end) / 2;
+        if (records[middle].id < id) {
+            begin = middle + 1;
+        }
+        else {
+            end = middle;
+        }
+    }
+
+    return (begin < count && records[begin].id == id) ? begin : -1;
+}
+
+// 'order' is sorted by parent of records
+template <typename Record>
+static void childRange(const quint32* order, int count, const Record* records, qint32 Record::*parent,
+                       int parentID, int* begin, int* end)
+{
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (records[order[middle]].*parent < parentID) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    *begin = low;
+
+    high = count;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (records[order[middle]].*parent <= parentID) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    *end = low;
+}
+
+template <typename Record>
+static bool isSortedByID(const Record* records, quint64 count)
+{
+    for (quint64 i = 1; i < count; ++i) {
+        if (records[i - 1].id >= records[i].id) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// 'order' has valid indexes of 'records' and it's sorted by their parent
+template <typename Record>
+static bool isValidOrder(const quint32* order, const Record* records, quint64 count, qint32 Record::*parent)
+{
+    for (quint64 i = 0; i < count; ++i) {
+        if (order[i] >= count || (i > 0 && records[order[i - 1]].*parent > records[order[i]].*parent)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool isValidSection(quint64 offset, quint64 count, quint64 recordSize, quint64 fileSize)
+{
+    return offset % 8 == 0 && offset <= fileSize && count <= (fileSize - offset) / recordSize;
+}
+
+static void padTo(QFile* file, qint64 offset)
+{
+    if (file->pos() < offset) {
+        file->write(QByteArray(int(offset - file->pos()), '\0'));
+    }
+}
+
+template <typename Record>
+static bool writeSection(QFile* file, quint64 offset, const QVector<Record> &records)
+{
+    padTo(file, qint64(offset));
+    const qint64 size = qint64(records.size()) * qint64(sizeof(Record));
+
+    return file->write(reinterpret_cast<const char*>(records.constData()), size) == size;
+}
+
+PoemPack::PoemPack(const QString &fileName)
+    : m_file(fileName),
+      m_header(0),
+      m_poets(0),
+      m_cats(0),
+      m_catsByParent(0),
+      m_poems(0),
+      m_poemsByCat(0),
+      m_verses(0),
+      m_texts(0)
+{
+}
+
+PoemPack* PoemPack::forDatabase(const QString &databaseFile)
+{
+    QMutexLocker locker(&packsMutex);
+
+    PoemPack* pack = packs.value(databaseFile, 0);
+    if (pack || missingPacks.contains(databaseFile)) {
+        return pack;
+    }
+
+    foreach (const QString &fileName, packFiles(databaseFile)) {
+        TRACE_SPAN("db", "PoemPack::open");
+
+        pack = new PoemPack(fileName);
+        if (pack->open(databaseFile)) {
+            break;
+        }
+
+        qWarning() << "PoemPack: ignoring invalid or outdated pack:" << fileName;
+        delete pack;
+        pack = 0;
+    }
+
+    // a missing pack is remembered until it's invalidated
+    if (pack) {
+        packs.insert(databaseFile, pack);
+    }
+    else {
+        missingPacks.insert(databaseFile);
+    }
+
+    return pack;
+}
+
+QString PoemPack::newPackFileName(const QString &databaseFile)
+{
+    QMutexLocker locker(&packsMutex);
+
+    QSet<QString> mappedFiles;
+    foreach (PoemPack* pack, packs.values() + retiredPacks) {
+        mappedFiles.insert(pack->m_file.fileName());
+    }
+
+    const QString fileName = packFileName(databaseFile);
+    if (!mappedFiles.contains(fileName)) {
+        return fileName;
+    }
+
+    const QFileInfo info(databaseFile);
+
+    return info.path() + QLatin1String("/") + info.completeBaseName() + QLatin1String(".") +
+           QDateTime::currentDateTime().toString("yyyyMMddhhmmsszzz") + QLatin1String(".pack");
+}
+
+void PoemPack::invalidate(const QString &databaseFile)
+{
+    QMutexLocker locker(&packsMutex);
+
+    missingPacks.remove(databaseFile);
+
+    PoemPack* pack = packs.take(databaseFile);
+    if (pack) {
+        retiredPacks << pack;
+    }
+}
+
+void PoemPack::removeOtherPacks(const QString &databaseFile, const QString &fileName)
+{
+    foreach (const QString &file, packFiles(databaseFile)) {
+        if (QFileInfo(file) != QFileInfo(fileName)) {
+            QFile::remove(file);
+        }
+    }
+}
+
+QString PoemPack::packFileName(const QString &databaseFile)
+{
+    const QFileInfo info(databaseFile);
+
+    return info.path() + QLatin1String("/") + info.completeBaseName() + QLatin1String(".pack");
+}
+
+bool PoemPack::open(const QString &databaseFile)
+{
+    if (!m_file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(Header))) {
+        return false;
+    }
+
+    const uchar* data = m_file.map(0, fileSize);
+    if (!data) {
+        return false;
+    }
+
+    m_header = reinterpret_cast<const Header*>(data);
+    if (qstrncmp(m_header->magic, "SGPK", 4) != 0 || m_header->version != packVersion ||
+            m_header->byteOrderMark != byteOrderMark) {
+        return false;
+    }
+
+    // a pack is not updated with its database
+    const QFileInfo source(databaseFile);
+    if (m_header->sourceSize != source.size() || m_header->sourceModified != qint64(source.lastModified().toTime_t())) {
+        return false;
+    }
+
+    const quint64 size = quint64(fileSize);
+    if (!isValidSection(m_header->poets.offset, m_header->poets.count, sizeof(PoetRecord), size) ||
+            !isValidSection(m_header->cats.offset, m_header->cats.count, sizeof(CatRecord), size) ||
+            !isValidSection(m_header->catsByParent.offset, m_header->catsByParent.count, sizeof(quint32), size) ||
+            !isValidSection(m_header->poems.offset, m_header->poems.count, sizeof(PoemRecord), size) ||
+            !isValidSection(m_header->poemsByCat.offset, m_header->poemsByCat.count, sizeof(quint32), size) ||
+            !isValidSection(m_header->verses.offset, m_header->verses.count, sizeof(VerseRecord), size) ||
+            !isValidSection(m_header->texts.offset, m_header->texts.count, sizeof(QChar), size) ||
+            m_header->catsByParent.count != m_header->cats.count ||
+            m_header->poemsByCat.count != m_header->poems.count) {
+        return false;
+    }
+
+    m_poets = reinterpret_cast<const PoetRecord*>(data + m_header->poets.offset);
+    m_cats = reinterpret_cast<const CatRecord*>(data + m_header->cats.offset);
+    m_catsByParent = reinterpret_cast<const quint32*>(data + m_header->catsByParent.offset);
+    m_poems = reinterpret_cast<const PoemRecord*>(data + m_header->poems.offset);
+    m_poemsByCat = reinterpret_cast<const quint32*>(data + m_header->poemsByCat.offset);
+    m_verses = reinterpret_cast<const VerseRecord*>(data + m_header->verses.offset);
+    m_texts = reinterpret_cast<const QChar*>(data + m_header->texts.offset);
+
+    return isConsistent();
+}
+
+bool PoemPack::isConsistent() const
+{
+    TRACE_SPAN("db", "PoemPack::isConsistent");
+
+    // lookups are binary searches over ids and index arrays
+    if (!isSortedByID(m_poets, m_header->poets.count) ||
+            !isSortedByID(m_cats, m_header->cats.count) ||
+            !isSortedByID(m_poems, m_header->poems.count) ||
+            !isValidOrder(m_catsByParent, m_cats, m_header->cats.count, &CatRecord::parentID) ||
+            !isValidOrder(m_poemsByCat, m_poems, m_header->poems.count, &PoemRecord::catID)) {
+        return false;
+    }
+
+    for (quint64 i = 0; i < m_header->verses.count; ++i) {
+        const qint32 position = m_verses[i].position;
+        if (position < Paragraph || position > Single) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+PoemPack::TextRef PoemPack::appendText(QString* texts, const QString &text)
+{
+    TextRef ref;
+    ref.offset = quint32(texts->size());
+    ref.length = quint32(text.size());
+    texts->append(text);
+
+    return ref;
+}
+
+bool PoemPack::write(const QString &connectionID, const QString &fileName, QString* error)
+{
+    TRACE_SPAN("db", "PoemPack::write");
+
+    QSqlDatabase db = DatabaseBrowser::database(connectionID);
+    if (!db.isOpen()) {
+        if (error) {
+            *error = QLatin1String("database is not open");
+        }
+        return false;
+    }
+
+    QString texts;
+    const QStringList excludeList = QStringList() << " ";
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+
+    QVector<PoetRecord> poets;
+    bool descriptionExists = q.exec("SELECT id, cat_id, name, description FROM poet ORDER BY id");
+    if (!descriptionExists) {
+        q.exec("SELECT id, cat_id, name FROM poet ORDER BY id");
+    }
+    while (q.next()) {
+        PoetRecord poet;
+        poet.id = q.value(0).toInt();
+        poet.catID = q.value(1).toInt();
+        poet.name = appendText(&texts, q.value(2).toString());
+        poet.description = appendText(&texts, descriptionExists ? q.value(3).toString() : QString());
+        poets << poet;
+    }
+
+    QVector<CatRecord> cats;
+    QVector<QPair<int, quint32> > catParents;
+    q.exec("SELECT id, poet_id, parent_id, text, url FROM cat ORDER BY id");
+    while (q.next()) {
+        CatRecord cat;
+        cat.id = q.value(0).toInt();
+        cat.poetID = q.value(1).toInt();
+        cat.parentID = q.value(2).toInt();
+        cat.text = appendText(&texts, q.value(3).toString());
+        cat.url = appendText(&texts, q.value(4).toString());
+        catParents << qMakePair(int(cat.parentID), quint32(cats.size()));
+        cats << cat;
+    }
+
+    QVector<PoemRecord> poems;
+    QVector<QPair<int, quint32> > poemCats;
+    QHash<int, int> poemIndexes;
+    q.exec("SELECT id, cat_id, title, url FROM poem ORDER BY id");
+    while (q.next()) {
+        const QString title = q.value(2).toString();
+
+        PoemRecord poem;
+        poem.id = q.value(0).toInt();
+        poem.catID = q.value(1).toInt();
+        poem.title = appendText(&texts, title);
+        poem.url = appendText(&texts, q.value(3).toString());
+        poem.normalizedTitle = appendText(&texts, " " + Tools::cleanStringFast(title, excludeList) + " ");
+        poem.firstVerse = 0;
+        poem.verseCount = 0;
+        poemIndexes.insert(poem.id, poems.size());
+        poemCats << qMakePair(int(poem.catID), quint32(poems.size()));
+        poems << poem;
+    }
+
+    // verses of a poem are contiguous and are in the order of poems
+    QVector<VerseRecord> verses;
+    q.exec("SELECT poem_id, vorder, position, text FROM verse ORDER BY poem_id, vorder");
+    while (q.next()) {
+        const int poemIndex = poemIndexes.value(q.value(0).toInt(), -1);
+        if (poemIndex == -1) {
+            continue;
+        }
+
+        PoemRecord &poem = poems[poemIndex];
+        if (poem.verseCount == 0) {
+            poem.firstVerse = quint32(verses.size());
+        }
+        ++poem.verseCount;
+
+        const QString text = q.value(3).toString();
+
+        VerseRecord verse;
+        verse.order = q.value(1).toInt();
+        verse.position = q.value(2).toInt();
+        verse.text = appendText(&texts, text);
+        verse.normalizedText = appendText(&texts, " " + Tools::cleanStringFast(text, excludeList) + " ");
+        verses << verse;
+    }
+
+    // pairs are sorted by parent and then by index, that is the order of ids
+    qSort(catParents);
+    qSort(poemCats);
+
+    QVector<quint32> catsByParent;
+    catsByParent.reserve(catParents.size());
+    for (int i = 0; i < catParents.size(); ++i) {
+        catsByParent << catParents.at(i).second;
+    }
+
+    QVector<quint32> poemsByCat;
+    poemsByCat.reserve(poemCats.size());
+    for (int i = 0; i < poemCats.size(); ++i) {
+        poemsByCat << poemCats.at(i).second;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, "SGPK", 4);
+    header.version = packVersion;
+    header.byteOrderMark = byteOrderMark;
+    header.flags = (SearchResultWidget::skipVowelSigns ? SkipVowelSigns : 0) |
+                   (SearchResultWidget::skipVowelLetters ? SkipVowelLetters : 0);
+
+    const QFileInfo source(DatabaseBrowser::databaseFileFromID(connectionID));
+    header.sourceSize = source.size();
+    header.sourceModified = qint64(source.lastModified().toTime_t());
+
+    // each section starts at an 8 bytes boundary
+    quint64 offset = sizeof(Header);
+    Section* sections[] = {&header.poets, &header.cats, &header.catsByParent, &header.poems,
+                           &header.poemsByCat, &header.verses, &header.texts
+                          };
+    const quint64 counts[] = {quint64(poets.size()), quint64(cats.size()), quint64(catsByParent.size()), quint64(poems.size()),
+                              quint64(poemsByCat.size()), quint64(verses.size()), quint64(texts.size())
+                             };
+    const quint64 recordSizes[] = {sizeof(PoetRecord), sizeof(CatRecord), sizeof(quint32), sizeof(PoemRecord),
+                                   sizeof(quint32), sizeof(VerseRecord), sizeof(QChar)
+                                  };
+    for (int i = 0; i < 7; ++i) {
+        offset = (offset + 7) & ~quint64(7);
+        sections[i]->offset = offset;
+        sections[i]->count = counts[i];
+        offset += counts[i] * recordSizes[i];
+    }
+
+    // the pack is replaced when it's written completely
+    const QString tempFileName = fileName + QLatin1String(".tmp");
+    QFile file(tempFileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    const qint64 textsSize = qint64(texts.size()) * qint64(sizeof(QChar));
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == qint64(sizeof(Header)) &&
+              writeSection(&file, header.poets.offset, poets) &&
+              writeSection(&file, header.cats.offset, cats) &&
+              writeSection(&file, header.catsByParent.offset, catsByParent) &&
+              writeSection(&file, header.poems.offset, poems) &&
+              writeSection(&file, header.poemsByCat.offset, poemsByCat) &&
+              writeSection(&file, header.verses.offset, verses);
+    if (ok) {
+        padTo(&file, qint64(header.texts.offset));
+        ok = file.write(reinterpret_cast<const char*>(texts.constData()), textsSize) == textsSize;
+    }
+
+    if (!ok) {
+        if (error) {
+            *error = file.errorString();
+        }
+        file.remove();
+        return false;
+    }
+    file.close();
+
+    QFile::remove(fileName);
+    if (!QFile::rename(tempFileName, fileName)) {
+        if (error) {
+            *error = QString("can not rename %1 to %2").arg(tempFileName).arg(fileName);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+QString PoemPack::text(const TextRef &ref) const
+{
+    if (quint64(ref.offset) + ref.length > m_header->texts.count) {
+        return QString();
+    }
+
+    // no copy, it refers to the mapped file
+    return QString::fromRawData(m_texts + ref.offset, int(ref.length));
+}
+
+int PoemPack::poetIndex(int poetID) const
+{
+    return indexOfID(m_poets, int(m_header->poets.count), poetID);
+}
+
+int PoemPack::catIndex(int catID) const
+{
+    return indexOfID(m_cats, int(m_header->cats.count), catID);
+}
+
+int PoemPack::poemIndex(int poemID) const
+{
+    return indexOfID(m_poems, int(m_header->poems.count), poemID);
+}
+
+void PoemPack::childPoems(int catID, int* begin, int* end) const
+{
+    childRange(m_poemsByCat, int(m_header->poemsByCat.count), m_poems, &PoemRecord::catID, catID, begin, end);
+}
+
+void PoemPack::childCats(int catID, int* begin, int* end) const
+{
+    childRange(m_catsByParent, int(m_header->catsByParent.count), m_cats, &CatRecord::parentID, catID, begin, end);
+}
+
+GanjoorCat PoemPack::toCat(const CatRecord &record) const
+{
+    GanjoorCat gCat;
+    gCat.init(record.id, record.poetID, text(record.text), record.parentID, text(record.url));
+
+    return gCat;
+}
+
+GanjoorPoem PoemPack::toPoem(const PoemRecord &record) const
+{
+    GanjoorPoem gPoem;
+    gPoem.init(record.id, record.catID, text(record.title), text(record.url), false, QString());
+
+    return gPoem;
+}
+
+QVector<GanjoorPoet> PoemPack::poets() const
+{
+    const int count = int(m_header->poets.count);
+
+    QVector<GanjoorPoet> poets;
+    poets.reserve(count);
+
+    GanjoorPoet gPoet;
+    for (int i = 0; i < count; ++i) {
+        const PoetRecord &poet = m_poets[i];
+        gPoet.init(poet.id, text(poet.name), poet.catID, text(poet.description));
+        poets.append(gPoet);
+    }
+
+    return poets;
+}
+
+GanjoorPoet PoemPack::poet(int poetID) const
+{
+    GanjoorPoet gPoet;
+    const int index = poetIndex(poetID);
+    if (index != -1) {
+        const PoetRecord &poet = m_poets[index];
+        gPoet.init(poet.id, text(poet.name), poet.catID, text(poet.description));
+    }
+
+    return gPoet;
+}
+
+GanjoorCat PoemPack::category(int catID) const
+{
+    const int index = catIndex(catID);
+    if (index == -1) {
+        return GanjoorCat();
+    }
+
+    return toCat(m_cats[index]);
+}
+
+QVector<GanjoorCat> PoemPack::subCategories(int catID) const
+{
+    int begin;
+    int end;
+    childCats(catID, &begin, &end);
+
+    QVector<GanjoorCat> cats;
+    cats.reserve(end - begin);
+    for (int i = begin; i < end; ++i) {
+        cats.append(toCat(m_cats[m_catsByParent[i]]));
+    }
+
+    return cats;
+}
+
+QVector<GanjoorPoem> PoemPack::poems(int catID) const
+{
+    int begin;
+    int end;
+    childPoems(catID, &begin, &end);
+
+    QVector<GanjoorPoem> poems;
+    poems.reserve(end - begin);
+    for (int i = begin; i < end; ++i) {
+        poems.append(toPoem(m_poems[m_poemsByCat[i]]));
+    }
+
+    return poems;
+}
+
+GanjoorPoem PoemPack::poem(int poemID) const
+{
+    const int index = poemIndex(poemID);
+    if (index == -1) {
+        return GanjoorPoem();
+    }
+
+    return toPoem(m_poems[index]);
+}
+
+GanjoorPoem PoemPack::siblingPoem(int poemID, int catID, bool next) const
+{
+    int begin;
+    int end;
+    childPoems(catID, &begin, &end);
+
+    // poems of a category are in order of id
+    if (next) {
+        for (int i = begin; i < end; ++i) {
+            if (m_poems[m_poemsByCat[i]].id > poemID) {
+                return toPoem(m_poems[m_poemsByCat[i]]);
+            }
+        }
+    }
+    else {
+        for (int i = end - 1; i >= begin; --i) {
+            if (m_poems[m_poemsByCat[i]].id < poemID) {
+                return toPoem(m_poems[m_poemsByCat[i]]);
+            }
+        }
+    }
+
+    return GanjoorPoem();
+}
+
+QVector<GanjoorVerse> PoemPack::verses(int poemID, int count) const
+{
+    QVector<GanjoorVerse> verses;
+
+    const int index = poemIndex(poemID);
+    if (index == -1) {
+        return verses;
+    }
+
+    const PoemRecord &poem = m_poems[index];
+    if (quint64(poem.firstVerse) + poem.verseCount > m_header->verses.count) {
+        return verses;
+    }
+
+    int verseCount = int(poem.verseCount);
+    if (count > 0) {
+        verseCount = qMin(verseCount, count);
+    }
+    verses.reserve(verseCount);
+
+    GanjoorVerse gVerse;
+    for (int i = 0; i < verseCount; ++i) {
+        const VerseRecord &verse = m_verses[poem.firstVerse + i];
+        gVerse.init(poemID, verse.order, (VersePosition)verse.position, text(verse.text));
+        verses.append(gVerse);
+    }
+
+    return verses;
+}
+
+bool PoemPack::hasNormalizedText() const
+{
+    return ((m_header->flags & SkipVowelSigns) != 0) == SearchResultWidget::skipVowelSigns &&
+           ((m_header->flags & SkipVowelLetters) != 0) == SearchResultWidget::skipVowelLetters;
+}
+
+PoemPack::Scanner::Scanner(const PoemPack* pack, bool titles, const QSet<int> &catIDs, const QSet<int> &poemIDs)
+    : m_pack(pack),
+      m_titles(titles),
+      m_catIDs(catIDs),
+      m_poemIDs(poemIDs),
+      m_poem(-1),
+      m_verse(0),
+      m_verseEnd(0)
+{
+}
+
+bool PoemPack::Scanner::acceptPoem(int poemIndex) const
+{
+    const PoemRecord &poem = m_pack->m_poems[poemIndex];
+
+    return (m_catIDs.isEmpty() || m_catIDs.contains(poem.catID)) &&
+           (m_poemIDs.isEmpty() || m_poemIDs.contains(poem.id));
+}
+
+bool PoemPack::Scanner::next()
+{
+    if (!m_titles && m_verse + 1 < m_verseEnd) {
+        ++m_verse;
+        return true;
+    }
+
+    const int poemCount = int(m_pack->m_header->poems.count);
+    while (++m_poem < poemCount) {
+        if (!acceptPoem(m_poem)) {
+            continue;
+        }
+
+        if (m_titles) {
+            return true;
+        }
+
+        const PoemRecord &poem = m_pack->m_poems[m_poem];
+        if (poem.verseCount > 0 && quint64(poem.firstVerse) + poem.verseCount <= m_pack->m_header->verses.count) {
+            m_verse = int(poem.firstVerse);
+            m_verseEnd = m_verse + int(poem.verseCount);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int PoemPack::Scanner::poemID() const
+{
+    return m_pack->m_poems[m_poem].id;
+}
+
+int PoemPack::Scanner::verseOrder() const
+{
+    return m_titles ? 0 : m_pack->m_verses[m_verse].order;
+}
+
+QString PoemPack::Scanner::text() const
+{
+    return m_titles ? m_pack->text(m_pack->m_poems[m_poem].title) : m_pack->text(m_pack->m_verses[m_verse].text);
+}
+
+QString PoemPack::Scanner::normalizedText() const
+{
+    return m_titles ? m_pack->text(m_pack->m_poems[m_poem].normalizedTitle)
+           : m_pack->text(m_pack->m_verses[m_verse].normalizedText);
+}
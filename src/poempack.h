@@ -0,0 +1,197 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef POEMPACK_H
+#define POEMPACK_H
+
+#include "databaseelements.h"
+
+#include <QFile>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+// Read-only columnar image of a Ganjoor database for kiosks and libraries.
+// A pack is one memory mapped file: fixed size records of poets, categories,
+// poems and verses sorted by id, two index arrays for children of categories
+// and one UTF-16 blob for all texts, verses and titles have a normalized copy
+// for searching. Texts are returned by QString::fromRawData(), so a pack is
+// never unmapped and a rebuilt pack is written to a new file name.
+// A pack is written by Tools menu's 'Create Read-only Pack' (or by 'saaghar-bench pack')
+// next to its source database and it's used instead of SQL queries when the database
+// is opened read-only.
+class PoemPack
+{
+public:
+    // the newest valid pack of 'databaseFile' that is not older than it, or 0
+    static PoemPack* forDatabase(const QString &databaseFile);
+    static QString packFileName(const QString &databaseFile);
+    // a pack file name of 'databaseFile' that is not mapped by this process
+    static QString newPackFileName(const QString &databaseFile);
+    // forgets the pack (or missing pack) of 'databaseFile', next forDatabase() looks
+    // it up again. the forgotten pack remains mapped, its texts may be in use
+    static void invalidate(const QString &databaseFile);
+    // removes pack files of 'databaseFile' except 'fileName', a file that is mapped
+    // (e.g. on Windows) is left and the newer pack is preferred to it
+    static void removeOtherPacks(const QString &databaseFile, const QString &fileName);
+    // normalized texts are cleaned by current search options
+    static bool write(const QString &connectionID, const QString &fileName, QString* error = 0);
+
+    QVector<GanjoorPoet> poets() const;
+    GanjoorPoet poet(int poetID) const;
+    GanjoorCat category(int catID) const;
+    QVector<GanjoorCat> subCategories(int catID) const;
+    QVector<GanjoorPoem> poems(int catID) const;
+    GanjoorPoem poem(int poemID) const;
+    // next or previous poem of the same category
+    GanjoorPoem siblingPoem(int poemID, int catID, bool next) const;
+    QVector<GanjoorVerse> verses(int poemID, int count = 0) const;
+
+    // normalized texts are cleaned by the same options that search uses now
+    bool hasNormalizedText() const;
+
+    // iterates verses (or titles) of poems in order of id, it's used by search tasks
+    class Scanner
+    {
+    public:
+        // empty 'catIDs' or 'poemIDs' doesn't limit scanned poems
+        Scanner(const PoemPack* pack, bool titles, const QSet<int> &catIDs = QSet<int>(), const QSet<int> &poemIDs = QSet<int>());
+
+        bool next();
+
+        int poemID() const;
+        int verseOrder() const;
+        QString text() const;
+        // text that is cleaned and padded by spaces
+        QString normalizedText() const;
+
+    private:
+        bool acceptPoem(int poemIndex) const;
+
+        const PoemPack* m_pack;
+        bool m_titles;
+        QSet<int> m_catIDs;
+        QSet<int> m_poemIDs;
+        int m_poem;
+        int m_verse;
+        int m_verseEnd;
+    };
+
+private:
+    struct TextRef {
+        quint32 offset;
+        quint32 length;
+    };
+
+    struct PoetRecord {
+        qint32 id;
+        qint32 catID;
+        TextRef name;
+        TextRef description;
+    };
+
+    struct CatRecord {
+        qint32 id;
+        qint32 poetID;
+        qint32 parentID;
+        TextRef text;
+        TextRef url;
+    };
+
+    struct PoemRecord {
+        qint32 id;
+        qint32 catID;
+        TextRef title;
+        TextRef url;
+        TextRef normalizedTitle;
+        quint32 firstVerse;
+        quint32 verseCount;
+    };
+
+    struct VerseRecord {
+        qint32 order;
+        qint32 position;
+        TextRef text;
+        TextRef normalizedText;
+    };
+
+    struct Section {
+        quint64 offset;
+        quint64 count;
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        // it's checked for byte order of the pack
+        quint32 byteOrderMark;
+        quint32 flags;
+        qint64 sourceSize;
+        qint64 sourceModified;
+        Section poets;
+        Section cats;
+        // indexes of 'cats' sorted by parent id
+        Section catsByParent;
+        Section poems;
+        // indexes of 'poems' sorted by category id
+        Section poemsByCat;
+        Section verses;
+        // QChar units
+        Section texts;
+    };
+
+    enum Flag {
+        SkipVowelSigns = 0x1,
+        SkipVowelLetters = 0x2
+    };
+
+    PoemPack(const QString &fileName);
+    Q_DISABLE_COPY(PoemPack)
+
+    bool open(const QString &databaseFile);
+    // ids are sorted, index arrays refer to records in order of parents and
+    // verse positions are valid, text and verse ranges are checked when they're read
+    bool isConsistent() const;
+    static TextRef appendText(QString* texts, const QString &text);
+
+    QString text(const TextRef &ref) const;
+    int poetIndex(int poetID) const;
+    int catIndex(int catID) const;
+    int poemIndex(int poemID) const;
+    // [begin, end) of 'poemsByCat' or 'catsByParent' for children of 'catID'
+    void childPoems(int catID, int* begin, int* end) const;
+    void childCats(int catID, int* begin, int* end) const;
+
+    GanjoorCat toCat(const CatRecord &record) const;
+    GanjoorPoem toPoem(const PoemRecord &record) const;
+
+    QFile m_file;
+    const Header* m_header;
+    const PoetRecord* m_poets;
+    const CatRecord* m_cats;
+    const quint32* m_catsByParent;
+    const PoemRecord* m_poems;
+    const quint32* m_poemsByCat;
+    const VerseRecord* m_verses;
+    const QChar* m_texts;
+};
+
+#endif // POEMPACK_H
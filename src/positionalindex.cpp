@@ -0,0 +1,410 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "positionalindex.h"
+#include "databasebrowser.h"
+#include "searchresultcache.h"
+#include "tools.h"
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QSqlQuery>
+#include <QtAlgorithms>
+
+// shorter terms have too many variants, they are matched exactly
+const int minApproximateTermLength = 3;
+
+// about 64 MB of postings
+const int PositionalIndex::maxPostings = 8 * 1024 * 1024;
+
+// start positions of 'phrase' in 'tokens'
+static QList<int> phrasePositions(const QStringList &tokens, const QStringList &phrase, int maxDistance)
+{
+    QList<int> positions;
+    if (phrase.isEmpty()) {
+        return positions;
+    }
+
+    for (int i = 0; i + phrase.size() <= tokens.size(); ++i) {
+        int j = 0;
+        while (j < phrase.size() && PositionalIndex::termMatches(tokens.at(i + j), phrase.at(j), maxDistance)) {
+            ++j;
+        }
+
+        if (j == phrase.size()) {
+            positions << i;
+        }
+    }
+
+    return positions;
+}
+
+// spans of 'leftLength' and 'rightLength' tokens don't overlap and there are at most
+// 'distance' tokens from end of one of them to start of the other one
+static bool spansNear(int leftStart, int leftLength, int rightStart, int rightLength, int distance)
+{
+    const int leftEnd = leftStart + leftLength - 1;
+    const int rightEnd = rightStart + rightLength - 1;
+
+    if (rightStart > leftEnd) {
+        return rightStart - leftEnd <= distance;
+    }
+    if (leftStart > rightEnd) {
+        return leftStart - rightEnd <= distance;
+    }
+
+    return false;
+}
+
+PositionalIndex* PositionalIndex::s_instance = 0;
+static QMutex instanceMutex;
+
+PositionalIndex* PositionalIndex::instance()
+{
+    QMutexLocker locker(&instanceMutex);
+
+    if (!s_instance) {
+        // first caller may be a search task's thread, so the index has no parent,
+        // it's moved to application's thread and it's deleted on application exit
+        s_instance = new PositionalIndex;
+        s_instance->moveToThread(QCoreApplication::instance()->thread());
+        qAddPostRoutine(destroy);
+    }
+
+    return s_instance;
+}
+
+void PositionalIndex::destroy()
+{
+    delete s_instance;
+}
+
+PositionalIndex::PositionalIndex(QObject* parent)
+    : QObject(parent)
+{
+}
+
+PositionalIndex::~PositionalIndex()
+{
+    s_instance = 0;
+}
+
+bool PositionalIndex::prepare(const QString &connectionID, const CancelToken &cancelToken)
+{
+    // the index is dropped when any database is updated
+    const QString stamp = SearchResultCache::instance()->indexStamp(DatabaseBrowser::databaseFileFromID(connectionID));
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_stamp == stamp) {
+        return true;
+    }
+    if (m_skippedStamp == stamp) {
+        return false;
+    }
+
+    TRACE_SPAN("search", "build positional index");
+
+    m_stamp.clear();
+    m_skippedStamp.clear();
+    m_docs.clear();
+    m_postings.clear();
+    m_dictionary.clear();
+
+    QSqlQuery q(DatabaseBrowser::database(connectionID));
+    q.setForwardOnly(true);
+    q.exec("SELECT poem_id, vorder, text FROM verse");
+
+    int postingCount = 0;
+    while (q.next()) {
+        if (m_docs.size() % 4096 == 0 && cancelToken.isCanceled()) {
+            m_docs.clear();
+            m_postings.clear();
+            return false;
+        }
+
+        Posting posting;
+        posting.doc = m_docs.size();
+        m_docs.append(verseKey(q.value(0).toInt(), q.value(1).toInt()));
+
+        const QStringList tokens = tokenize(q.value(2).toString());
+        postingCount += tokens.size();
+        if (postingCount > maxPostings) {
+            m_docs.clear();
+            m_postings.clear();
+            m_skippedStamp = stamp;
+            return false;
+        }
+
+        for (int i = 0; i < tokens.size(); ++i) {
+            posting.pos = i;
+            // docs are appended in order, so posting lists remain sorted
+            m_postings[tokens.at(i)].append(posting);
+        }
+    }
+
+    m_stamp = stamp;
+
+    return true;
+}
+
+void PositionalIndex::release()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_stamp.clear();
+    m_skippedStamp.clear();
+    m_docs.clear();
+    m_docs.squeeze();
+    m_postings.clear();
+    m_dictionary.clear();
+}
+
+QSet<qint64> PositionalIndex::find(const PositionalClause &clause, int maxDistance)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QSet<qint64> verses;
+    if (clause.operands.isEmpty()) {
+        return verses;
+    }
+
+    if (maxDistance > 0 && m_dictionary.isEmpty()) {
+        TRACE_SPAN("search", "build term dictionary");
+
+        QHash<QString, PostingList>::const_iterator it = m_postings.constBegin();
+        while (it != m_postings.constEnd()) {
+            m_dictionary.insert(it.key());
+            ++it;
+        }
+    }
+
+    QSet<int> docs;
+    if (clause.operands.size() == 1) {
+        const PostingList postings = phrasePostings(clause.operands.at(0), maxDistance);
+        for (int i = 0; i < postings.size(); ++i) {
+            docs.insert(postings.at(i).doc);
+        }
+    }
+    else {
+        // only the positions of each operand that are near to the previous one
+        // continue the chain, so all operands of a match are in one place
+        PostingList previous = phrasePostings(clause.operands.at(0), maxDistance);
+        for (int i = 1; i < clause.operands.size() && !previous.isEmpty(); ++i) {
+            previous = nearPostings(previous, clause.operands.at(i - 1).size(),
+                                    phrasePostings(clause.operands.at(i), maxDistance), clause.operands.at(i).size(),
+                                    clause.distances.at(i - 1));
+        }
+
+        for (int i = 0; i < previous.size(); ++i) {
+            docs.insert(previous.at(i).doc);
+        }
+    }
+
+    verses.reserve(docs.size());
+    foreach (int doc, docs) {
+        verses.insert(m_docs.at(doc));
+    }
+
+    return verses;
+}
+
+int PositionalIndex::estimatedMatches(const QString &connectionID, const PositionalClause &clause)
+{
+    const QString stamp = SearchResultCache::instance()->indexStamp(DatabaseBrowser::databaseFileFromID(connectionID));
+
+    // planner should not wait for building of the index
+    if (!m_mutex.tryLock()) {
+        return -1;
+    }
+
+    int estimate = -1;
+    if (m_stamp == stamp) {
+        estimate = m_docs.size();
+        foreach (const QStringList &operand, clause.operands) {
+            foreach (const QString &term, operand) {
+                estimate = qMin(estimate, m_postings.value(term).size());
+            }
+        }
+    }
+
+    m_mutex.unlock();
+
+    return estimate;
+}
+
+qint64 PositionalIndex::verseKey(int poemID, int verseOrder)
+{
+    return (qint64(poemID) << 32) | quint32(verseOrder);
+}
+
+QStringList PositionalIndex::tokenize(const QString &text)
+{
+    return Tools::cleanStringFast(text, QStringList() << " ").split(QLatin1Char(' '), QString::SkipEmptyParts);
+}
+
+bool PositionalIndex::matches(const QStringList &tokens, const PositionalClause &clause, int maxDistance)
+{
+    if (clause.operands.isEmpty()) {
+        return false;
+    }
+
+    QList<int> previous = phrasePositions(tokens, clause.operands.at(0), maxDistance);
+    if (clause.operands.size() == 1) {
+        return !previous.isEmpty();
+    }
+
+    for (int i = 1; i < clause.operands.size() && !previous.isEmpty(); ++i) {
+        const QList<int> current = phrasePositions(tokens, clause.operands.at(i), maxDistance);
+        const int previousLength = clause.operands.at(i - 1).size();
+        const int currentLength = clause.operands.at(i).size();
+        const int distance = clause.distances.at(i - 1);
+
+        QList<int> nearPositions;
+        foreach (int b, current) {
+            foreach (int a, previous) {
+                if (spansNear(a, previousLength, b, currentLength, distance)) {
+                    nearPositions << b;
+                    break;
+                }
+            }
+        }
+        previous = nearPositions;
+    }
+
+    return !previous.isEmpty();
+}
+
+bool PositionalIndex::termMatches(const QString &token, const QString &term, int maxDistance)
+{
+    if (token == term) {
+        return true;
+    }
+
+    return maxDistance > 0 && term.size() >= minApproximateTermLength &&
+           qAbs(token.size() - term.size()) <= maxDistance &&
+           TermDictionary::distance(token, term) <= maxDistance;
+}
+
+PositionalIndex::PostingList PositionalIndex::termPostings(const QString &term, int maxDistance) const
+{
+    if (maxDistance <= 0 || term.size() < minApproximateTermLength) {
+        return m_postings.value(term);
+    }
+
+    const QStringList variants = m_dictionary.similarTerms(term, maxDistance);
+    if (variants.size() == 1) {
+        return m_postings.value(variants.at(0));
+    }
+
+    PostingList postings;
+    foreach (const QString &variant, variants) {
+        postings += m_postings.value(variant);
+    }
+    qSort(postings);
+
+    return postings;
+}
+
+PositionalIndex::PostingList PositionalIndex::phrasePostings(const QStringList &phrase, int maxDistance) const
+{
+    if (phrase.isEmpty()) {
+        return PostingList();
+    }
+
+    PostingList postings = termPostings(phrase.at(0), maxDistance);
+    for (int i = 1; i < phrase.size() && !postings.isEmpty(); ++i) {
+        postings = followedBy(postings, termPostings(phrase.at(i), maxDistance), i);
+    }
+
+    return postings;
+}
+
+// keeps postings of 'first' that 'next' has a posting 'offset' tokens after them
+PositionalIndex::PostingList PositionalIndex::followedBy(const PostingList &first, const PostingList &next, int offset)
+{
+    PostingList postings;
+    int i = 0;
+    int j = 0;
+    while (i < first.size() && j < next.size()) {
+        const Posting &a = first.at(i);
+        const Posting &b = next.at(j);
+
+        if (a.doc < b.doc || (a.doc == b.doc && a.pos + offset < b.pos)) {
+            ++i;
+        }
+        else if (a.doc > b.doc || a.pos + offset > b.pos) {
+            ++j;
+        }
+        else {
+            postings.append(a);
+            ++i;
+            ++j;
+        }
+    }
+
+    return postings;
+}
+
+// postings of 'second' that a posting of 'first' is within 'distance' tokens of them,
+// postings are starts of spans of 'firstLength' and 'secondLength' tokens
+PositionalIndex::PostingList PositionalIndex::nearPostings(const PostingList &first, int firstLength,
+        const PostingList &second, int secondLength, int distance)
+{
+    PostingList postings;
+    int i = 0;
+    int j = 0;
+    while (i < first.size() && j < second.size()) {
+        const int doc = first.at(i).doc;
+        if (doc < second.at(j).doc) {
+            ++i;
+            continue;
+        }
+        if (doc > second.at(j).doc) {
+            ++j;
+            continue;
+        }
+
+        int iEnd = i;
+        while (iEnd < first.size() && first.at(iEnd).doc == doc) {
+            ++iEnd;
+        }
+        int jEnd = j;
+        while (jEnd < second.size() && second.at(jEnd).doc == doc) {
+            ++jEnd;
+        }
+
+        // a verse has a few tokens, so positions of one doc are compared pairwise
+        for (int b = j; b < jEnd; ++b) {
+            for (int a = i; a < iEnd; ++a) {
+                if (spansNear(first.at(a).pos, firstLength, second.at(b).pos, secondLength, distance)) {
+                    postings.append(second.at(b));
+                    break;
+                }
+            }
+        }
+
+        i = iEnd;
+        j = jEnd;
+    }
+
+    return postings;
+}
@@ -0,0 +1,107 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef POSITIONALINDEX_H
+#define POSITIONALINDEX_H
+
+#include "concurrenttasks.h"
+#include "searchpatternmanager.h"
+#include "termdictionary.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// Token positions of normalized verse texts of one database, it's used for
+// evaluating NEAR clauses and approximate phrases by intersecting posting lists.
+// The index is built lazily from search tasks' threads, a database that has more
+// than 'maxPostings' tokens is not indexed and it's searched row by row.
+class PositionalIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static PositionalIndex* instance();
+    ~PositionalIndex();
+
+    static const int maxPostings;
+
+    // builds the index of the database of 'connectionID' if it's not built yet
+    // or it's built for another database, normalization options or database generation.
+    // returns false if building is canceled or the database is too large.
+    bool prepare(const QString &connectionID, const CancelToken &cancelToken);
+
+    // keys of verses that match 'clause', prepare() must be called before.
+    // a positive 'maxDistance' matches terms within that edit distance of clause terms
+    QSet<qint64> find(const PositionalClause &clause, int maxDistance = 0);
+
+    // upper bound of verses that match 'clause', -1 if the index is not built
+    // for the database of 'connectionID' (or it's being built)
+    int estimatedMatches(const QString &connectionID, const PositionalClause &clause);
+
+    static qint64 verseKey(int poemID, int verseOrder);
+    static QStringList tokenize(const QString &text);
+    // evaluates 'clause' against tokens of one text, used when there is no index for the text
+    static bool matches(const QStringList &tokens, const PositionalClause &clause, int maxDistance = 0);
+    static bool termMatches(const QString &token, const QString &term, int maxDistance);
+
+public slots:
+    // frees the index, it's rebuilt by next prepare()
+    void release();
+
+private:
+    Q_DISABLE_COPY(PositionalIndex)
+    PositionalIndex(QObject* parent = 0);
+    static PositionalIndex* s_instance;
+    static void destroy();
+
+    struct Posting {
+        int doc;
+        int pos;
+
+        bool operator<(const Posting &other) const {
+            return doc < other.doc || (doc == other.doc && pos < other.pos);
+        }
+    };
+    typedef QVector<Posting> PostingList;
+
+    // postings of 'term' and its close variants
+    PostingList termPostings(const QString &term, int maxDistance) const;
+    // positions where all tokens of 'phrase' follow each other
+    PostingList phrasePostings(const QStringList &phrase, int maxDistance) const;
+    static PostingList followedBy(const PostingList &first, const PostingList &next, int offset);
+    static PostingList nearPostings(const PostingList &first, int firstLength,
+                                    const PostingList &second, int secondLength, int distance);
+
+    QMutex m_mutex;
+    QString m_stamp;
+    // stamp of the database that was too large to index
+    QString m_skippedStamp;
+    QVector<qint64> m_docs;
+    QHash<QString, PostingList> m_postings;
+    // built on first approximate search
+    TermDictionary m_dictionary;
+};
+
+#endif // POSITIONALINDEX_H
@@ -32,15 +32,23 @@
 #include "settingsmanager.h"
 #include "outlinemodel.h"
 #include "selectionmanager.h"
+#include "startupscheduler.h"
+#include "searchresultcache.h"
+#include "positionalindex.h"
+#include "trigramindex.h"
+#include "tracer.h"
 
 #include <QExtendedSplashScreen>
 
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
 #include <QFontDatabase>
 #include<QMessageBox>
 #include <QPointer>
 #include <QSettings>
+#include <QTextStream>
 #include <QThreadPool>
 #include <QTranslator>
 
@@ -80,6 +88,7 @@ SaagharApplication::SaagharApplication(int &argc, char** argv)
       m_tasksThreadPool(0),
       m_databaseBrowser(0),
       m_settingsManager(0),
+      m_startupScheduler(new StartupScheduler(this)),
       m_tasksThreads(NORMAL_TASKS_THREADS),
       m_displayFullNotification(true),
       m_notificationPosition(ProgressManager::DesktopBottomRight),
@@ -89,11 +98,18 @@ SaagharApplication::SaagharApplication(int &argc, char** argv)
     setApplicationName(APPLICATION_NAME);
     setOrganizationDomain(ORGANIZATION_DOMAIN);
 
+    Tracer::initFromEnvironment();
+
     init();
 }
 
 SaagharApplication::~SaagharApplication()
 {
+    const QString traceFile = Tracer::environmentTraceFile();
+    if (!traceFile.isEmpty() && Tracer::isEnabled()) {
+        Tracer::exportChromeTrace(traceFile);
+    }
+
     delete m_progressManager;
     delete m_mainWindow;
     delete m_databaseBrowser;
@@ -153,6 +169,11 @@ DatabaseBrowser* SaagharApplication::databaseBrowser()
         }
 
         m_databaseBrowser = DatabaseBrowser::instance();
+
+        connect(m_databaseBrowser, SIGNAL(databaseUpdated(QString)), SearchResultCache::instance(), SLOT(invalidate()));
+        // a stale index is not used anymore, its memory is freed instead of waiting for next search
+        connect(m_databaseBrowser, SIGNAL(databaseUpdated(QString)), PositionalIndex::instance(), SLOT(release()));
+        connect(m_databaseBrowser, SIGNAL(databaseUpdated(QString)), TrigramIndex::instance(), SLOT(release()));
     }
 
     return m_databaseBrowser;
@@ -300,6 +321,24 @@ void SaagharApplication::setupDatabasePaths()
 
     // Set database browser default path
     DatabaseBrowser::setDefaultDatabasename(m_paths.value(DatabaseFile));
+
+    // Browsing and searching don't need write access, read-only connections
+    // map the whole of database into memory.
+    // An unwritable file (e.g. a system wide install) is just opened read-only,
+    // a package upgrade may replace it while Saaghar is running. 'immutable' is
+    // only safe on read-only media so it's an explicit option, Qt 4 silently
+    // ignores it and opens the database read-only.
+    const QFileInfo databaseInfo(m_paths.value(DatabaseFile));
+    const bool unwritable = !databaseInfo.isWritable() || !QFileInfo(databaseInfo.absolutePath()).isWritable();
+    if (databaseInfo.exists() && VARB("DatabaseBrowser/ImmutableMode")) {
+        DatabaseBrowser::setAccessMode(DatabaseBrowser::Immutable);
+    }
+    else if (databaseInfo.exists() && (unwritable || VARB("DatabaseBrowser/ReadOnlyMode"))) {
+        DatabaseBrowser::setAccessMode(DatabaseBrowser::ReadOnly);
+    }
+    else {
+        DatabaseBrowser::setAccessMode(DatabaseBrowser::ReadWrite);
+    }
 }
 
 void SaagharApplication::setupTranslators()
@@ -331,6 +370,8 @@ void SaagharApplication::setupInitialValues()
     VAR_INIT("DatabaseBrowser/KeepDownloadedFile", false);
     VAR_INIT("DatabaseBrowser/DownloadLocation", QVariant());
     VAR_INIT("DatabaseBrowser/DataBasePath", QVariant());
+    VAR_INIT("DatabaseBrowser/ReadOnlyMode", false);
+    VAR_INIT("DatabaseBrowser/ImmutableMode", false);
 
     VAR_INIT("SaagharWidget/ShowBeytNumbers", true);
     VAR_INIT("SaagharWidget/MaxPoetsPerGroup", 12);
@@ -404,6 +445,7 @@ void SaagharApplication::setupInitialValues()
 
     VAR_INIT("SaagharWindow/MainToolBarItems", defaultToolbarActions);
     VAR_INIT("SaagharWindow/LastSessionTabs", QVariant());
+    VAR_INIT("SaagharWindow/LastSessionTabsState", QVariant());
     VAR_INIT("SaagharWindow/State0", QVariant());
     VAR_INIT("SaagharWindow/Geometry", QVariant());
     VAR_INIT("SaagharWindow/LockToolBars", true);
@@ -416,7 +458,10 @@ void SaagharApplication::setupInitialValues()
 
     VAR_INIT("Search/SkipVowelLetters", false);
     VAR_INIT("Search/SkipVowelSigns", false);
+    VAR_INIT("Search/ApproximateDistance", 0);
     VAR_INIT("Search/NonPagedResults", false);
+    VAR_INIT("Search/ResultCacheSize", 32);
+    VAR_INIT("Search/DiskResultCache", false);
     VAR_INIT("Search/SelectedRange", (QStringList() << LS("0") << LS("ALL_TITLES")));
     VAR_INIT("Search/MaxResultsPerPage", 100);
     VAR_INIT("Search/Range/All", true);
@@ -477,6 +522,11 @@ void SaagharApplication::applySettings()
     SearchResultWidget::nonPagedSearch = VARB("Search/NonPagedResults");
     SearchResultWidget::skipVowelSigns = VARB("Search/SkipVowelSigns");
     SearchResultWidget::skipVowelLetters = VARB("Search/SkipVowelLetters");
+    SearchResultWidget::approximateDistance = VARI("Search/ApproximateDistance");
+
+    SearchResultCache::instance()->setMaxEntries(VARI("Search/ResultCacheSize"));
+    SearchResultCache::instance()->setDiskCachePath(VARB("Search/DiskResultCache")
+            ? defaultPath(UserDataDir) + LS("/search-cache") : QString());
 
     SaagharWidget::backgroundImageState = VARB("SaagharWidget/BackgroundState");
     SaagharWidget::backgroundImagePath = VARS("SaagharWidget/BackgroundPath");
@@ -595,8 +645,24 @@ void SaagharApplication::aboutToShowMainWindow()
     }
 }
 
+void SaagharApplication::dumpStartupProfile()
+{
+    const QString profile = m_startupScheduler->report() + "\n" + DatabaseBrowser::preparedQueriesReport();
+    qWarning("Startup profile:\n%s", qPrintable(profile));
+
+    QFile file(defaultPath(UserDataDir) + "/startup-profile.log");
+    if (file.open(QFile::WriteOnly | QFile::Text)) {
+        QTextStream out(&file);
+        out.setCodec("UTF-8");
+        out << profile << "\n";
+    }
+}
+
 void SaagharApplication::init()
 {
+    QElapsedTimer phaseTimer;
+    phaseTimer.start();
+
     // loadSettings() setups paths and loads settings and then
     // setups initial values and finally setups database path
     loadSettings();
@@ -607,6 +673,8 @@ void SaagharApplication::init()
     // install translators
     setupTranslators();
 
+    m_startupScheduler->recordPhase("settings", phaseTimer.restart());
+
     ////////////////////
     // Initialize GUI //
     ////////////////////
@@ -625,6 +693,15 @@ void SaagharApplication::init()
     m_mainWindow = new SaagharWindow;
     m_mainWindow->show();
 
+    m_startupScheduler->recordPhase("main window", phaseTimer.elapsed());
+
+    if (arguments().contains("--startup-profile", Qt::CaseInsensitive)) {
+        connect(m_startupScheduler, SIGNAL(finished()), this, SLOT(dumpStartupProfile()));
+    }
+
+    // runs deferred phases when main window is painted
+    m_startupScheduler->start(m_mainWindow);
+
     if (m_splash) {
         QTimer::singleShot(200, this, SLOT(aboutToShowMainWindow()));
     }
@@ -34,6 +34,7 @@ class DatabaseBrowser;
 class OutlineModel;
 class SaagharWindow;
 class SettingsManager;
+class StartupScheduler;
 class QExtendedSplashScreen;
 
 class QAction;
@@ -68,6 +69,7 @@ public:
     QThreadPool* tasksThreadPool();
     DatabaseBrowser* databaseBrowser();
     SettingsManager* settingsManager();
+    StartupScheduler* startupScheduler() { return m_startupScheduler; }
 
     // empty means DatabaseBrowser::defaultConnectionId()
     OutlineModel* outlineModel(const QString &connectionID = QString());
@@ -93,6 +95,7 @@ public:
 private slots:
     void customizeQuickAccessBookmarks();
     void aboutToShowMainWindow();
+    void dumpStartupProfile();
 
 private:
     void init();
@@ -111,6 +114,7 @@ private:
     QThreadPool* m_tasksThreadPool;
     DatabaseBrowser* m_databaseBrowser;
     SettingsManager* m_settingsManager;
+    StartupScheduler* m_startupScheduler;
     QHash<QString, OutlineModel*> m_outlineModels;
 
     int m_tasksThreads;
@@ -28,6 +28,7 @@
 #include "tools.h"
 #include "saagharapplication.h"
 #include "settingsmanager.h"
+#include "tracer.h"
 
 #include <QSearchLineEdit>
 #include <QApplication>
@@ -40,6 +41,7 @@
 #include <QFile>
 #include <QTextEdit>
 #include <QSplitter>
+#include <QTimer>
 #include <QVariant>
 
 //STATIC Variables
@@ -87,6 +89,9 @@ SaagharWidget::SaagharWidget(QWidget* parent, QToolBar* catsToolBar, QTableWidge
     , currentCat(0)
     , m_vPosition(-1)
     , m_connectionID(connectionID)
+    , m_deferredVPosition(-1)
+    , m_loadingInBackground(false)
+    , m_pageTextIndexValid(false)
 {
     pageMetaInfo.id = 0;
     pageMetaInfo.type = SaagharWidget::CategoryViewerPage;
@@ -214,6 +219,65 @@ void SaagharWidget::processClickedItem(QString type, int id, bool noError, bool
     }
 }
 
+void SaagharWidget::setDeferredPage(const QString &type, int id, int vPosition)
+{
+    m_deferredType = type;
+    m_deferredVPosition = vPosition;
+
+    // identifier and page info are valid before loading the page, caption is
+    // a cheap placeholder until the page is shown
+    if (type == "PoemID") {
+        currentPoem = id;
+        currentCaption = sApp->databaseBrowser()->getPoem(id, m_connectionID)._Title;
+        pageMetaInfo.type = SaagharWidget::PoemViewerPage;
+    }
+    else {
+        currentPoem = 0;
+        currentCat = id;
+        currentCaption = (id == 0) ? SaagharWidget::rootTitle() : sApp->databaseBrowser()->getCategory(id, m_connectionID)._Text;
+        pageMetaInfo.type = SaagharWidget::CategoryViewerPage;
+    }
+    pageMetaInfo.id = id;
+}
+
+void SaagharWidget::loadDeferredPage(bool inBackground)
+{
+    if (!isDeferred()) {
+        return;
+    }
+
+    const QString type = m_deferredType;
+    const int id = (type == "PoemID") ? currentPoem : currentCat;
+    m_deferredType.clear();
+
+    // a page that is loaded in background must not update shared
+    // widgets e.g. window caption, navigation actions and music player
+    m_loadingInBackground = inBackground;
+    const bool wasBlocked = blockSignals(inBackground);
+
+    processClickedItem(type, id, true, false);
+
+    blockSignals(wasBlocked);
+    m_loadingInBackground = false;
+
+    // scroll position is applied when the tab is shown
+    setMVPosition(m_deferredVPosition);
+    m_deferredVPosition = -1;
+    if (!inBackground) {
+        QTimer::singleShot(0, this, SLOT(setFromMVPosition()));
+    }
+}
+
+int SaagharWidget::sessionVerticalPosition()
+{
+    if (isDeferred()) {
+        return m_deferredVPosition;
+    }
+
+    // loaded in background and not shown yet
+    return m_vPosition > 0 ? m_vPosition : currentVerticalPosition();
+}
+
 void SaagharWidget::navigateToPage(QString type, int id, bool noError)
 {
     if (type == "PoemID" || type == "CatID") {
@@ -237,7 +301,7 @@ void SaagharWidget::navigateToPage(QString type, int id, bool noError)
     }
 
 #ifdef MEDIA_PLAYER
-    if (SaagharWidget::musicPlayer) {
+    if (SaagharWidget::musicPlayer && !m_loadingInBackground) {
         bool isEnabled = (pageMetaInfo.type == SaagharWidget::PoemViewerPage);
         SaagharWidget::musicPlayer->setEnabled(isEnabled);
         if (!isEnabled) {
@@ -383,7 +447,7 @@ bool SaagharWidget::initializeCustomizedHome()
         return false;
     }
 
-    QList<GanjoorPoet*> poets = sApp->databaseBrowser()->getPoets(m_connectionID);
+    const QVector<GanjoorPoet> poets = sApp->databaseBrowser()->poets(m_connectionID);
 
     //tableViewWidget->clearContents();
 
@@ -424,10 +488,10 @@ bool SaagharWidget::initializeCustomizedHome()
         for (int row = 0; row < SaagharWidget::maxPoetsPerGroup; ++row) {
             if (startIndex == 1) {
                 if (row == 0) {
-                    groupLabel = poets.at(poetIndex)->_Name;    //.at(0);
+                    groupLabel = poets.at(poetIndex)._Name;    //.at(0);
                 }
                 if (row == SaagharWidget::maxPoetsPerGroup - 1 || poetIndex == numOfPoets - 1) {
-                    QString tmp = poets.at(poetIndex)->_Name;
+                    QString tmp = poets.at(poetIndex)._Name;
 
                     if (groupLabel != tmp) {
                         int index = 0;
@@ -456,13 +520,13 @@ bool SaagharWidget::initializeCustomizedHome()
                     }
                 }
             }
-            QTableWidgetItem* catItem = new QTableWidgetItem(poets.at(poetIndex)->_Name + "       ");
+            QTableWidgetItem* catItem = new QTableWidgetItem(poets.at(poetIndex)._Name + "       ");
             catItem->setFont(sectionFont);
             catItem->setForeground(sectionColor);
             catItem->setFlags(catsItemFlag);
-            catItem->setData(Qt::UserRole, "CatID=" + QString::number(poets.at(poetIndex)->_CatID));
+            catItem->setData(Qt::UserRole, "CatID=" + QString::number(poets.at(poetIndex)._CatID));
             //poets.at(poetIndex)->_ID
-            QString poetPhotoFileName = poetsImagesDir + "/" + QString::number(poets.at(poetIndex)->_ID) + ".png";;
+            QString poetPhotoFileName = poetsImagesDir + "/" + QString::number(poets.at(poetIndex)._ID) + ".png";;
             if (!QFile::exists(poetPhotoFileName)) {
                 poetPhotoFileName = ICON_FILE("no-photo");
             }
@@ -495,6 +559,7 @@ bool SaagharWidget::initializeCustomizedHome()
     tableViewWidget->resizeColumnsToContents();
     //tableViewWidget->resizeRowsToContents();
     dirty = false;//page is showed or refreshed
+    m_pageTextIndexValid = false;
 
     return true;
 }
@@ -535,6 +600,8 @@ void SaagharWidget::homeResizeColsRows()
 
 void SaagharWidget::showCategory(GanjoorCat category)
 {
+    TRACE_SPAN("layout", "SaagharWidget::showCategory");
+
     if (category.isNull()) {
         //showHome();
         GanjoorCat homeCat;
@@ -560,7 +627,7 @@ void SaagharWidget::showCategory(GanjoorCat category)
     }
 
     emit captionChanged();
-    QList<GanjoorCat*> subcats = sApp->databaseBrowser()->getSubCategories(category._ID, m_connectionID);
+    const QVector<GanjoorCat> subcats = sApp->databaseBrowser()->subCategories(category._ID, m_connectionID);
 
     int subcatsSize = subcats.size();
 
@@ -569,11 +636,10 @@ void SaagharWidget::showCategory(GanjoorCat category)
         poetForCathasDescription = !sApp->databaseBrowser()->getPoetForCat(category._ID, m_connectionID)._Description.isEmpty();
     }
 
-    QList<GanjoorPoem*> poems = sApp->databaseBrowser()->getPoems(category._ID, m_connectionID);
+    const QVector<GanjoorPoem> poems = sApp->databaseBrowser()->poems(category._ID, m_connectionID);
 
     if (subcatsSize == 1 && poems.isEmpty() && (category._ParentID != 0 || (category._ParentID == 0 && !poetForCathasDescription))) {
-        GanjoorCat firstCat;
-        firstCat.init(subcats.at(0)->_ID, subcats.at(0)->_PoetID, subcats.at(0)->_Text, subcats.at(0)->_ParentID,  subcats.at(0)->_Url);
+        const GanjoorCat firstCat = subcats.at(0);
         clearSaagharWidget();
         showCategory(firstCat);
         QApplication::restoreOverrideCursor();
@@ -581,8 +647,7 @@ void SaagharWidget::showCategory(GanjoorCat category)
     }
 
     if (poems.size() == 1 && subcatsSize == 0 && (category._ParentID != 0 || (category._ParentID == 0 && !poetForCathasDescription))) {
-        GanjoorPoem firstPoem;
-        firstPoem.init(poems.at(0)->_ID, poems.at(0)->_CatID, poems.at(0)->_Title, poems.at(0)->_Url,  poems.at(0)->_Faved,  poems.at(0)->_HighlightText);
+        const GanjoorPoem firstPoem = poems.at(0);
         clearSaagharWidget();
         showPoem(firstPoem);
         QApplication::restoreOverrideCursor();
@@ -705,7 +770,7 @@ void SaagharWidget::showCategory(GanjoorCat category)
 
     const QString RLM = QChar(0x200F);
     for (int i = 0; i < subcatsSize; ++i) {
-        QString catText = Tools::simpleCleanString(subcats.at(i)->_Text);
+        QString catText = Tools::simpleCleanString(subcats.at(i)._Text);
 
         // default empty or strings containing just weak direction characters to RTL
         if (QString("%1%2").arg(catText).arg(RLM).isRightToLeft()) {
@@ -719,10 +784,10 @@ void SaagharWidget::showCategory(GanjoorCat category)
         catItem->setFont(sectionFont);
         catItem->setForeground(sectionColor);
         catItem->setFlags(catsItemFlag);
-        catItem->setData(Qt::UserRole, "CatID=" + QString::number(subcats.at(i)->_ID));
+        catItem->setData(Qt::UserRole, "CatID=" + QString::number(subcats.at(i)._ID));
 
         if (currentCat == 0) {
-            GanjoorPoet gPoet = sApp->databaseBrowser()->getPoetForCat(subcats.at(i)->_ID, m_connectionID);
+            GanjoorPoet gPoet = sApp->databaseBrowser()->getPoetForCat(subcats.at(i)._ID, m_connectionID);
             QString poetPhotoFileName = poetsImagesDir + "/" + QString::number(gPoet._ID) + ".png";
             if (!QFile::exists(poetPhotoFileName)) {
                 poetPhotoFileName = ICON_FILE("no-photo");
@@ -737,10 +802,6 @@ void SaagharWidget::showCategory(GanjoorCat category)
         tableViewWidget->setItem(i + startRow, 0, catItem);
         tableViewWidget->setRowHeight(i + startRow, SaagharWidget::computeRowHeight(QFontMetrics(sectionFont), -1, -1));
 
-        //freeing resuorce
-        delete subcats[i];
-        subcats[i] = 0;
-
         if (i >= step) {
             emit loadingStatusText(tr("<i><b>Loading the \"%1\"...</b></i>").arg(currentCaption));
             step = step + 100;
@@ -748,11 +809,11 @@ void SaagharWidget::showCategory(GanjoorCat category)
     }
 
     for (int i = 0; i < poems.size(); i++) {
-        QString itemText = Tools::snippedText(Tools::simpleCleanString(poems.at(i)->_Title), "", 0, 15, true);
+        QString itemText = Tools::snippedText(Tools::simpleCleanString(poems.at(i)._Title), "", 0, 15, true);
         if (subcatsSize > 0) {
             itemText.prepend("       ");    //7 spaces
         }
-        itemText += " : " + Tools::simpleCleanString(sApp->databaseBrowser()->getFirstMesra(poems.at(i)->_ID, m_connectionID));
+        itemText += " : " + Tools::simpleCleanString(sApp->databaseBrowser()->getFirstMesra(poems.at(i)._ID, m_connectionID));
 
         // default empty or strings containing just weak direction characters to RTL
         if (QString("%1%2").arg(itemText).arg(RLM).isRightToLeft()) {
@@ -766,11 +827,7 @@ void SaagharWidget::showCategory(GanjoorCat category)
         poemItem->setFont(sectionFont);
         poemItem->setForeground(sectionColor);
         poemItem->setFlags(poemsItemFlag);
-        poemItem->setData(Qt::UserRole, "PoemID=" + QString::number(poems.at(i)->_ID));
-
-        //we need delete all
-        delete poems[i];
-        poems[i] = 0;
+        poemItem->setData(Qt::UserRole, "PoemID=" + QString::number(poems.at(i)._ID));
 
         tableViewWidget->setItem(subcatsSize + i + startRow, 0, poemItem);
         tableViewWidget->setRowHeight(subcatsSize + i + startRow, SaagharWidget::computeRowHeight(QFontMetrics(sectionFont), -1, -1));
@@ -800,6 +857,7 @@ void SaagharWidget::showCategory(GanjoorCat category)
     emit navNextActionState(!sApp->databaseBrowser()->getNextPoem(currentPoem, currentCat, m_connectionID).isNull());
 
     dirty = false;//page is showed or refreshed
+    m_pageTextIndexValid = false;
 }
 
 void SaagharWidget::showParentCategory(GanjoorCat category)
@@ -907,9 +965,11 @@ void SaagharWidget::showParentCategory(GanjoorCat category)
 
     emit currentLocationChanged(currentLocationList, m_connectionID);
 }
-#include<QTime>
+
 void SaagharWidget::showPoem(GanjoorPoem poem)
 {
+    TRACE_SPAN("layout", "SaagharWidget::showPoem");
+
     if (poem.isNull()) {
         return;
     }
@@ -922,7 +982,7 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
 
     showParentCategory(sApp->databaseBrowser()->getCategory(poem._CatID, m_connectionID));
 
-    QList<GanjoorVerse*> verses = sApp->databaseBrowser()->getVerses(poem._ID, m_connectionID);
+    const QVector<GanjoorVerse> verses = sApp->databaseBrowser()->verses(poem._ID, m_connectionID);
 
     QFont poemFont(resolvedFont(LS("SaagharWidget/Fonts/PoemText")));
     QFontMetrics poemFontMetric(poemFont);
@@ -984,16 +1044,15 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
         maxWidth = poemFontMetric.width(longestHemistiches.value(poem._ID));
     }
     int numberOfVerses = verses.size();
-#ifdef SAAGHAR_DEBUG
-    QTime start = QTime::currentTime();
-#endif
     if (justified) {
         if (maxWidth <= 0) {
+            TRACE_SPAN("layout", "longest hemistich");
+
             QString longest = "";
             for (int i = 0; i < numberOfVerses; i++) {
-                QString verseText = verses.at(i)->_Text;
+                QString verseText = verses.at(i)._Text;
 
-                if (verses.at(i)->_Position == Single || verses.at(i)->_Position == Paragraph) {
+                if (verses.at(i)._Position == Single || verses.at(i)._Position == Paragraph) {
                     continue;
                 }
 
@@ -1006,10 +1065,6 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
             }
             longestHemistiches.insert(poem._ID, longest);
         }
-#ifdef SAAGHAR_DEBUG
-        qDebug() << "JustificationTime=" << -QTime::currentTime().msecsTo(start);
-        start = QTime::currentTime();
-#endif
     }
 //#endif
 
@@ -1018,23 +1073,18 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
     int step = 99;
     emit loadingStatusText(tr("<i><b>Loading the \"%1\"...</b></i>").arg(Tools::snippedText(poem._Title, "", 0, 6, false, Qt::ElideRight)), numberOfVerses / (step + 1));
 
-    QStringList bookmarkedVerses("");
-    if (SaagharWidget::bookmarks) {
-        bookmarkedVerses = SaagharWidget::bookmarks->bookmarkList("Verses");
-    }
-
     m_hasPoem = false;
     int betterRightToLeft = 0, betterLeftToRight = 0;
     const QString RLM = QChar(0x200F);
     //very Big For loop
     for (int i = 0; i < numberOfVerses; i++) {
-        QString currentVerseText = verses.at(i)->_Text;
+        QString currentVerseText = verses.at(i)._Text;
 
-        if (verses.at(i)->_Position != Paragraph) {
+        if (verses.at(i)._Position != Paragraph) {
             m_hasPoem = true;
         }
 
-        if (verses.at(i)->_Position != Single && verses.at(i)->_Position != Paragraph) {
+        if (verses.at(i)._Position != Single && verses.at(i)._Position != Paragraph) {
             currentVerseText = currentVerseText.simplified();
         }
 
@@ -1049,17 +1099,17 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
 //#endif
 
         if (currentVerseText.isEmpty()) {
-            if (verses.at(i)->_Position == Paragraph
-                    || verses.at(i)->_Position == CenteredVerse1
-                    || verses.at(i)->_Position == CenteredVerse2
-                    || verses.at(i)->_Position == Single) {
+            if (verses.at(i)._Position == Paragraph
+                    || verses.at(i)._Position == CenteredVerse1
+                    || verses.at(i)._Position == CenteredVerse2
+                    || verses.at(i)._Position == Single) {
                 if (i == verses.size() - 1) {
                     tableViewWidget->removeRow(row);
                 }
                 continue;
             }
 
-            if (verses.at(i)->_Position == Left) {
+            if (verses.at(i)._Position == Left) {
                 bool empty = true;
                 for (int k = 0; k < tableViewWidget->columnCount(); ++k) {
                     QTableWidgetItem* temp = tableViewWidget->item(row, k);
@@ -1088,10 +1138,10 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
         QTableWidgetItem* mesraItem = new QTableWidgetItem(currentVerseText);
         mesraItem->setFlags(versesItemFlag);
         //set data for mesraItem
-        QString verseData = QString::number(verses.at(i)->_PoemID) + "|" + QString::number(verses.at(i)->_Order) + "|" + QString::number((int)verses.at(i)->_Position);
+        QString verseData = QString::number(verses.at(i)._PoemID) + "|" + QString::number(verses.at(i)._Order) + "|" + QString::number((int)verses.at(i)._Position);
         mesraItem->setData(Qt::UserRole, "VerseData=|" + verseData);
 
-        VersePosition versePosition = verses.at(i)->_Position;
+        VersePosition versePosition = verses.at(i)._Position;
         //temp and tricky way for some database problems!!(second Mesra when there is no a defined first Mesra)
         if (!rightVerseFlag && versePosition == Left) {
             versePosition = Paragraph;
@@ -1113,18 +1163,15 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
         simplifiedText.remove("\t");
         simplifiedText.remove("\n");
 
-        QString currentVerseData = QString::number(verses.at(i)->_PoemID) + "|" + QString::number(verses.at(i)->_Order);
-        bool verseIsBookmarked = false;
-        if (bookmarkedVerses.contains(currentVerseData)) {
-            verseIsBookmarked = true;
-        }
+        const bool verseIsBookmarked = SaagharWidget::bookmarks &&
+                                       SaagharWidget::bookmarks->isBookmarked(verses.at(i)._PoemID, verses.at(i)._Order);
 
-        if (!simplifiedText.isEmpty() && ((verses.at(i)->_Position == Single && !currentVerseText.isEmpty()) ||
-                                          verses.at(i)->_Position == Right ||
-                                          verses.at(i)->_Position == CenteredVerse1)
+        if (!simplifiedText.isEmpty() && ((verses.at(i)._Position == Single && !currentVerseText.isEmpty()) ||
+                                          verses.at(i)._Position == Right ||
+                                          verses.at(i)._Position == CenteredVerse1)
            ) {
             WholeBeytNum++;
-            bool isBand = (verses.at(i)->_Position == CenteredVerse1);
+            bool isBand = (verses.at(i)._Position == CenteredVerse1);
             if (isBand) {
                 BeytNum = 0;
                 BandNum++;
@@ -1136,7 +1183,7 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
 
             if (!currentVerseText.isEmpty()) {
                 //empty verse strings have been seen sometimes, it seems that we have some errors in our database
-                //QString verseData = QString::number(verses.at(i)->_PoemID)+"."+QString::number(verses.at(i)->_Order)+"."+QString::number((int)verses.at(i)->_Position);
+                //QString verseData = QString::number(verses.at(i)._PoemID)+"."+QString::number(verses.at(i)._Order)+"."+QString::number((int)verses.at(i)._Position);
                 QTableWidgetItem* numItem = new QTableWidgetItem("");
 
                 if (SaagharWidget::showBeytNumbers && m_hasPoem) {
@@ -1176,16 +1223,16 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
             }
         }
 
-        if (verses.at(i)->_Position == Paragraph ||
-                verses.at(i)->_Position == Left ||
-                verses.at(i)->_Position == CenteredVerse1 ||
-                verses.at(i)->_Position == CenteredVerse2 ||
-                verses.at(i)->_Position == Single) {
+        if (verses.at(i)._Position == Paragraph ||
+                verses.at(i)._Position == Left ||
+                verses.at(i)._Position == CenteredVerse1 ||
+                verses.at(i)._Position == CenteredVerse2 ||
+                verses.at(i)._Position == Single) {
             QTableWidgetItem* numItem = tableViewWidget->item(row, 0);
             if (!numItem) {
                 numItem = new QTableWidgetItem("");
                 numItem->setFlags(numItemFlags);
-                if (SaagharWidget::bookmarks && verses.at(i)->_Position == Paragraph && !isLocalDataset()) {
+                if (SaagharWidget::bookmarks && verses.at(i)._Position == Paragraph && !isLocalDataset()) {
                     QPixmap star(ICON_FILE("bookmark-on"));
                     QPixmap starOff(ICON_FILE("bookmark-off"));
                     star = star.scaledToHeight(qMin(tableViewWidget->rowHeight(row) - 1, 22), Qt::SmoothTransformation);
@@ -1207,7 +1254,7 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
             rightVerseFlag = false; //temp and tricky way for some database problems!!(second Mesra when there is no a defined first Mesra)
             ++row;
 
-//          if (verses.at(i)->_Position == Left && !currentVerseText.isEmpty())
+//          if (verses.at(i)._Position == Left && !currentVerseText.isEmpty())
 //              groupedBeytAlignment = (groupedBeytAlignment == Qt::AlignRight ? Qt::AlignLeft : Qt::AlignRight);
 //          else
 //              groupedBeytAlignment = Qt::AlignLeft;
@@ -1216,10 +1263,6 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
                 tableViewWidget->insertRow(row);
             }
         }
-
-        //delete Verses
-        delete verses[i];
-        verses[i] = 0;
     }// end of big for
 
     //support LTR contents
@@ -1229,9 +1272,6 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
     else {
         tableViewWidget->setLayoutDirection(Qt::LeftToRight);
     }
-#ifdef SAAGHAR_DEBUG
-    qDebug() << "end of poem layouting=" << -QTime::currentTime().msecsTo(start);
-#endif
 
     //a trick for removing last empty row withoout QTextEdit widget
     if (!tableViewWidget->cellWidget(tableViewWidget->rowCount() - 1, 1)) {
@@ -1267,7 +1307,10 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
     if (SaagharWidget::musicPlayer) {
         pageMetaInfo.id = currentPoem;
         pageMetaInfo.type = SaagharWidget::PoemViewerPage;
+    }
 
+    // a tab that is loaded in background doesn't own the player
+    if (SaagharWidget::musicPlayer && !m_loadingInBackground) {
         if (SaagharWidget::musicPlayer->albumContains(currentPoem, 0)) {
             QString path;
             QString title;
@@ -1287,11 +1330,14 @@ void SaagharWidget::showPoem(GanjoorPoem poem)
     emit navNextActionState(!sApp->databaseBrowser()->getNextPoem(currentPoem, currentCat, m_connectionID).isNull());
 
     dirty = false;//page is showed or refreshed
+    m_pageTextIndexValid = false;
 }
 
 void SaagharWidget::clearSaagharWidget()
 {
     lastOveredItem = 0;
+    m_pageTextIndexValid = false;
+    m_pageTextIndex.clear();
     tableViewWidget->setRowCount(0);
     tableViewWidget->setColumnCount(0);
 }
@@ -1473,6 +1519,48 @@ void SaagharWidget::resizeTable(QTableWidget* table)
     }
 }
 
+const QVector<SaagharWidget::PageTextEntry> &SaagharWidget::pageTextIndex()
+{
+    if (m_pageTextIndexValid) {
+        return m_pageTextIndex;
+    }
+
+    m_pageTextIndex.clear();
+
+    for (int row = 1; row < tableViewWidget->rowCount(); ++row) {
+        //start from second row, we need to skip poem's title.
+        for (int col = 0; col < tableViewWidget->columnCount(); ++col) {
+            QTableWidgetItem* tmp = tableViewWidget->item(row, col);
+            if (tmp) {
+                QString text = tmp->text();
+                if (text.isEmpty()) {
+                    QTextEdit* textEdit = qobject_cast<QTextEdit*>(tableViewWidget->cellWidget(row, col));
+                    if (textEdit) {
+                        text = textEdit->toPlainText();
+                    }
+                }
+                text =  Tools::cleanString(text);
+                text.remove(".");//remove because of elided text
+                text.replace(QChar(0x0640), "", Qt::CaseInsensitive);//replace TATWEEL by ""
+                text = text.simplified();
+                if (text.isEmpty()) {
+                    continue;
+                }
+
+                PageTextEntry entry;
+                entry.row = row;
+                entry.column = col;
+                entry.text = text;
+                m_pageTextIndex.append(entry);
+            }
+        }
+    }
+
+    m_pageTextIndexValid = true;
+
+    return m_pageTextIndex;
+}
+
 QTableWidgetItem* SaagharWidget::scrollToFirstItemContains(const QString &phrase, bool pharseIsList, bool scroll)
 {
     QString keyword = phrase;
@@ -1495,56 +1583,50 @@ QTableWidgetItem* SaagharWidget::scrollToFirstItemContains(const QString &phrase
     if (list.isEmpty()) {
         return 0;
     }
-    int listSize = list.size();
 
-    for (int row = 1; row < tableViewWidget->rowCount(); ++row) {
-        //start from second row, we need to skip poem's title.
-        for (int col = 0; col < tableViewWidget->columnCount(); ++col) {
-            QTableWidgetItem* tmp = tableViewWidget->item(row, col);
-            if (tmp) {
-                QString text = tmp->text();
-                if (text.isEmpty()) {
-                    QTextEdit* textEdit = qobject_cast<QTextEdit*>(tableViewWidget->cellWidget(row, col));
-                    if (textEdit) {
-                        text = textEdit->toPlainText();
-                    }
-                }
-                text =  Tools::cleanString(text);
-                text.remove(".");//remove because of elided text
-                text.replace(QChar(0x0640), "", Qt::CaseInsensitive);//replace TATWEEL by ""
-                text = text.simplified();
-                if (text.isEmpty()) {
+    // prepare keywords once, start from last, probably it's the new one!
+    QStringList keywords;
+    QList<QRegExp> wildcards;
+    for (int i = list.size() - 1; i >= 0; --i) {
+        keyword = list.at(i);
+        keyword.remove(".");//remove because of elided text
+
+        if (keyword.contains("@")) {
+            keyword.replace("@", "\\S*", Qt::CaseInsensitive);//replace wildcard by word chars
+            wildcards << QRegExp(keyword, Qt::CaseInsensitive);
+            keywords << QString();
+        }
+        else {
+            wildcards << QRegExp();
+            keywords << keyword.simplified();
+        }
+    }
+    const int listSize = keywords.size();
+
+    const QVector<PageTextEntry> &index = pageTextIndex();
+
+    for (int e = 0; e < index.size(); ++e) {
+        const QString &text = index.at(e).text;
+
+        for (int i = 0; i < listSize; ++i) {
+            keyword = keywords.at(i);
+
+            if (!wildcards.at(i).pattern().isEmpty()) {
+                QRegExp &regExp = wildcards[i];
+                regExp.indexIn(text);
+                keyword = regExp.cap(0).simplified();
+                if (keyword.isEmpty()) {
                     continue;
                 }
+            }
 
-                for (int i = 0; i < listSize; ++i) {
-                    keyword = list.at(listSize - 1 - i); //start from last, probably it's the new one!
-                    keyword.remove(".");//remove because of elided text
-
-                    if (keyword.contains("@")) {
-                        keyword.replace("@", "\\S*", Qt::CaseInsensitive);//replace wildcard by word chars
-                        QRegExp regExp(keyword, Qt::CaseInsensitive);
-                        regExp.indexIn(text);
-                        keyword = regExp.cap(0);
-                        if (keyword.isEmpty()) {
-                            continue;
-                        }
-                    }
-                    keyword = keyword.simplified();
-
-                    if (text.contains(keyword)) {
-                        if (scroll) {
-                            //TODO: there is a BUG! (search:دختر Sadi, حکایت 42 or 43!)
-//                            tableViewWidget->setCurrentItem(tmp, QItemSelectionModel::NoUpdate);
-                            //tableViewWidget->scrollToItem(tmp, QAbstractItemView::PositionAtCenter);
-                            Tools::scrollToItem(tableViewWidget, tmp, 200);
-                        }
-                        //row = tableViewWidget->rowCount()+1;
-                        //col = tableViewWidget->columnCount()+1;
-                        //break;
-                        return tmp;
-                    }
+            if (text.contains(keyword)) {
+                QTableWidgetItem* tmp = tableViewWidget->item(index.at(e).row, index.at(e).column);
+                if (scroll) {
+                    //TODO: there is a BUG! (search:دختر Sadi, حکایت 42 or 43!)
+                    Tools::scrollToItem(tableViewWidget, tmp, 200);
                 }
+                return tmp;
             }
         }
     }
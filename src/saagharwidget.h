@@ -33,6 +33,7 @@
 #include <QPushButton>
 #include <QToolBar>
 #include <QUndoStack>
+#include <QVector>
 
 #include "databaseelements.h"
 #include "bookmarks.h"
@@ -151,6 +152,13 @@ public:
     QStringList identifier();
     void refresh();
 
+    // restored tabs are placeholders until they are shown for the first time
+    void setDeferredPage(const QString &type, int id, int vPosition);
+    inline bool isDeferred() const
+    {return !m_deferredType.isEmpty();}
+    void loadDeferredPage(bool inBackground = false);
+    int sessionVerticalPosition();
+
     inline void setMVPosition(int value) { m_vPosition = value; }
 
     //Undo FrameWork
@@ -170,6 +178,20 @@ private:
 
     QString m_connectionID;
 
+    QString m_deferredType;
+    int m_deferredVPosition;
+    bool m_loadingInBackground;
+
+    // normalized texts of page's cells, it's built once per shown page for in-page find
+    struct PageTextEntry {
+        int row;
+        int column;
+        QString text;
+    };
+    const QVector<PageTextEntry> &pageTextIndex();
+    QVector<PageTextEntry> m_pageTextIndex;
+    bool m_pageTextIndexValid;
+
 private slots:
     void createCustomContextMenu(const QPoint &pos);
     void parentCatClicked();
@@ -33,12 +33,17 @@
 #include "settings.h"
 #include "tools.h"
 #include "concurrenttasks.h"
+#include "poempack.h"
 #include "saagharapplication.h"
 #include "settingsmanager.h"
 #include "outlinemodel.h"
 #include "importer/importermanager.h"
 #include "importer/importer_interface.h"
 #include "aboutdialog.h"
+#include "corpusexporter.h"
+#include "corpusstatisticswidget.h"
+#include "startupscheduler.h"
+#include "tracer.h"
 
 #include <QTextBrowserDialog>
 #include <QSearchLineEdit>
@@ -89,6 +94,8 @@ SaagharWindow::SaagharWindow(QWidget* parent)
     , m_settingsDialog(0)
     , m_updateTaskScheduled(false)
     , m_searchOptions(0)
+    , m_bookmarksLoaded(false)
+    , m_sessionTabsRestored(false)
 {
     setObjectName("SaagharMainWindow");
     setWindowIcon(QIcon(":/resources/images/saaghar.png"));
@@ -114,7 +121,7 @@ SaagharWindow::SaagharWindow(QWidget* parent)
             QMusicPlayer::albumsPathList.insert("default", defaultFile);
         }
     }
-    SaagharWidget::musicPlayer->loadAllAlbums();
+    // albums are loaded by loadAlbums() after main window is shown
 
     connect(SaagharWidget::musicPlayer, SIGNAL(showTextRequested(int,int)), this, SLOT(highlightTextOnPoem(int,int)));
     connect(this, SIGNAL(highlightedTextChanged(QString)), SaagharWidget::musicPlayer, SIGNAL(highlightedTextChange(QString)));
@@ -219,40 +226,15 @@ SaagharWindow::SaagharWindow(QWidget* parent)
 
     loadTabWidgetSettings();
 
-    outlineTree->refreshTree();
     connect(outlineTree, SIGNAL(openParentRequested(int)), this, SLOT(openParentPage(int)));
     connect(outlineTree, SIGNAL(newParentRequested(int)), this, SLOT(newTabForItem(int)));
     connect(outlineTree, SIGNAL(openRandomRequested(int,bool)), this, SLOT(openRandomPoem(int,bool)));
 
-    if (!fresh) {
-        QStringList openedTabs = VAR("SaagharWindow/LastSessionTabs").toStringList();
-        showStatusText(tr("<i><b>Saaghar is starting...</b></i>"), openedTabs.size());
-        for (int i = 0; i < openedTabs.size(); ++i) {
-            QStringList tabViewData = openedTabs.at(i).split("=", QString::SkipEmptyParts);
-            if (tabViewData.size() == 2 && (tabViewData.at(0) == "PoemID" || tabViewData.at(0) == "CatID")) {
-                bool Ok = false;
-                int id = tabViewData.at(1).toInt(&Ok);
-                if (Ok) {
-                    newTabForItem(id, tabViewData.at(0), true, false);
-                }
-            }
-        }
-    }
-
-    if (mainTabWidget->count() < 1) {
-        insertNewTab();
-    }
-
-    connect(mainTabWidget, SIGNAL(currentChanged(int)), this, SLOT(currentTabChanged(int)));
-    connect(mainTabWidget, SIGNAL(tabCloseRequested(int)), this, SLOT(tabCloser(int)));
-
     connect(ui->mainToolBar, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(toolBarContextMenu(QPoint)));
     //connect(ui->searchToolBar, SIGNAL(orientationChanged(Qt::Orientation)), this, SLOT(searchToolBarView()));
     //ui->searchToolBar->installEventFilter(this);
 
     createConnections();
-    previousTabIndex = mainTabWidget->currentIndex();
-    currentTabChanged(mainTabWidget->currentIndex());
 
 //    multiSelectInsertItems(selectSearchRange);
 
@@ -295,11 +277,34 @@ SaagharWindow::SaagharWindow(QWidget* parent)
         QTimer::singleShot(10000, this, SLOT(checkForUpdates()));
     }
 
-    if (VARI("General/LastShownPrefaceID") < Tools::prefaceIDFromVersion(SAAGHAR_VERSION)) {
-        showPreface(Tools::prefaceIDFromVersion(SAAGHAR_VERSION));
+    updateSearchOptionButtonToolTip();
+
+    if (DatabaseBrowser::accessMode() != DatabaseBrowser::ReadWrite) {
+        // database is opened read-only and can not be modified
+        const QStringList writerActions = QStringList() << "actionImportNewSet" << "actionRemovePoet"
+                                          << "actionImport" << "actionDevDatabaseCleanups"
+                                          << "DownloadRepositories";
+        foreach (const QString &actionName, writerActions) {
+            if (allActionMap.value(actionName)) {
+                allActionMap.value(actionName)->setEnabled(false);
+            }
+        }
     }
 
-    updateSearchOptionButtonToolTip();
+    // Just the window's shell is created synchronously, database and disk
+    // heavy initializations are run after the first paint by priority.
+    // Until tabs are restored the window is not interactive.
+    ui->menuBar->setEnabled(false);
+    ui->mainToolBar->setEnabled(false);
+    ui->searchToolBar->setEnabled(false);
+
+    StartupScheduler* scheduler = sApp->startupScheduler();
+    scheduler->addPhase("bookmarks", this, "loadBookmarks", 0);
+    scheduler->addPhase("restored tabs", this, "restoreSessionTabs", 1);
+    scheduler->addPhase("catalog", this, "loadCatalog", 2);
+#ifdef MEDIA_PLAYER
+    scheduler->addPhase("albums", this, "loadAlbums", 3);
+#endif
 }
 
 SaagharWindow::~SaagharWindow()
@@ -307,8 +312,155 @@ SaagharWindow::~SaagharWindow()
     delete ui;
 }
 
+// number of restored tabs that are loaded in background
+const int maxPrefetchedTabs = 3;
+// delay between loading of two restored tabs in background (ms)
+const int tabPrefetchInterval = 500;
+
+void SaagharWindow::restoreSessionTabs()
+{
+    // restored tabs are just placeholders, they are loaded on their first
+    // activation or in background by MRU order
+    QMultiMap<int, SaagharWidget*> tabsByRecency;
+
+    if (!QCoreApplication::arguments().contains("-fresh", Qt::CaseInsensitive)) {
+        QStringList openedTabs = VAR("SaagharWindow/LastSessionTabs").toStringList();
+        // "vertical position,recency" of each tab, recency 0 is the most recently used one
+        const QStringList tabsState = VAR("SaagharWindow/LastSessionTabsState").toStringList();
+        showStatusText(tr("<i><b>Saaghar is starting...</b></i>"));
+        for (int i = 0; i < openedTabs.size(); ++i) {
+            QStringList tabViewData = openedTabs.at(i).split("=", QString::SkipEmptyParts);
+            if (tabViewData.size() == 2 && (tabViewData.at(0) == "PoemID" || tabViewData.at(0) == "CatID")) {
+                bool Ok = false;
+                int id = tabViewData.at(1).toInt(&Ok);
+                if (Ok) {
+                    // without saved state the last tab is the most recent one
+                    int vPosition = -1;
+                    int recency = openedTabs.size() - i - 1;
+                    const QStringList state = tabsState.value(i).split(",", QString::SkipEmptyParts);
+                    if (state.size() == 2) {
+                        vPosition = state.at(0).toInt();
+                        recency = state.at(1).toInt();
+                    }
+
+                    insertNewTab(SaagharWindow::SaagharViewerTab, QString(), -1, tabViewData.at(0), true, false);
+                    saagharWidget->setDeferredPage(tabViewData.at(0), id, vPosition);
+                    mainTabWidget->setTabText(mainTabWidget->currentIndex(), saagharWidget->currentCaption);
+                    mainTabWidget->setTabToolTip(mainTabWidget->currentIndex(), "<p>" + saagharWidget->currentCaption + "</p>");
+
+                    tabsByRecency.insert(recency, saagharWidget);
+                }
+            }
+        }
+    }
+
+    if (!tabsByRecency.isEmpty()) {
+        const QList<SaagharWidget*> recentTabs = tabsByRecency.values();
+        for (int i = 0; i < recentTabs.size(); ++i) {
+            m_recentTabs << recentTabs.at(i);
+            // the first one is activated below
+            if (i > 0 && i <= maxPrefetchedTabs) {
+                m_tabsToPrefetch << recentTabs.at(i);
+            }
+        }
+
+        mainTabWidget->setCurrentIndex(mainTabWidget->indexOf(recentTabs.first()->parentWidget()));
+    }
+
+    if (mainTabWidget->count() < 1) {
+        insertNewTab();
+    }
+
+    connect(mainTabWidget, SIGNAL(currentChanged(int)), this, SLOT(currentTabChanged(int)));
+    connect(mainTabWidget, SIGNAL(tabCloseRequested(int)), this, SLOT(tabCloser(int)));
+
+    previousTabIndex = mainTabWidget->currentIndex();
+    currentTabChanged(mainTabWidget->currentIndex());
+
+    m_sessionTabsRestored = true;
+
+    if (!m_tabsToPrefetch.isEmpty()) {
+        QTimer::singleShot(tabPrefetchInterval, this, SLOT(prefetchRestoredTab()));
+    }
+
+    ui->menuBar->setEnabled(true);
+    ui->mainToolBar->setEnabled(true);
+    ui->searchToolBar->setEnabled(true);
+
+    if (VARI("General/LastShownPrefaceID") < Tools::prefaceIDFromVersion(SAAGHAR_VERSION)) {
+        showPreface(Tools::prefaceIDFromVersion(SAAGHAR_VERSION));
+    }
+}
+
+void SaagharWindow::prefetchRestoredTab()
+{
+    // wait while user is interacting with window
+    if (QApplication::mouseButtons() != Qt::NoButton || QApplication::activePopupWidget() || QApplication::activeModalWidget()) {
+        QTimer::singleShot(tabPrefetchInterval, this, SLOT(prefetchRestoredTab()));
+        return;
+    }
+
+    while (!m_tabsToPrefetch.isEmpty()) {
+        QPointer<SaagharWidget> widget = m_tabsToPrefetch.takeFirst();
+        // it may be closed or activated meanwhile
+        if (widget && widget->isDeferred()) {
+            loadDeferredTab(widget);
+            break;
+        }
+    }
+
+    if (!m_tabsToPrefetch.isEmpty()) {
+        QTimer::singleShot(tabPrefetchInterval, this, SLOT(prefetchRestoredTab()));
+    }
+}
+
+void SaagharWindow::loadDeferredTab(SaagharWidget* widget)
+{
+    if (!widget || !widget->isDeferred()) {
+        return;
+    }
+
+    widget->loadDeferredPage(true);
+
+    const int index = mainTabWidget->indexOf(widget->parentWidget());
+    if (index >= 0) {
+        mainTabWidget->setTabText(index, widget->currentCaption);
+        mainTabWidget->setTabToolTip(index, "<p>" + widget->currentCaption + "</p>");
+    }
+
+    // parent categories toolbar is shared between tabs
+    if (saagharWidget && saagharWidget != widget) {
+        saagharWidget->showParentCategory(sApp->databaseBrowser()->getCategory(saagharWidget->currentCat, saagharWidget->connectionID()));
+    }
+
+    updateTabsSubMenus();
+}
+
+void SaagharWindow::loadCatalog()
+{
+    outlineTree->refreshTree();
+}
+
+void SaagharWindow::loadAlbums()
+{
+#ifdef MEDIA_PLAYER
+    if (!SaagharWidget::musicPlayer) {
+        return;
+    }
+
+    SaagharWidget::musicPlayer->loadAllAlbums();
+
+    // restored tabs were shown before albums were loaded
+    if (saagharWidget) {
+        loadAudioForCurrentTab();
+    }
+#endif
+}
+
 void SaagharWindow::searchStart()
 {
+    TRACE_SPAN("search", "SaagharWindow::searchStart");
+
     bool byPressEnter = sender() == SaagharWidget::lineEditSearchText;
     if (byPressEnter) {
         SaagharWidget::lineEditSearchText->resetNotFound();
@@ -358,6 +510,7 @@ void SaagharWindow::searchStart()
         for (int j = 0; j < mainTabWidget->count(); ++j) {
             SaagharWidget* tmp = getSaagharWidget(j);
             if (tmp) {
+                loadDeferredTab(tmp);
                 tmp->scrollToFirstItemContains(phrase);
             }
         }
@@ -415,20 +568,8 @@ void SaagharWindow::searchStart()
 
                 QStringList phrases = phraseVectorList.at(j);
                 QStringList excluded = excludedVectorList.at(j);
-#ifdef SAAGHAR_DEBUG
-                int start = QDateTime::currentDateTime().toTime_t() * 1000 + QDateTime::currentDateTime().time().msec();
-#endif
-
                 success |= sApp->databaseBrowser()->getPoemIDsByPhrase(searchTask, currentSelectionPath, currentSelectionPathTitle, phrases, excluded, &searchCanceled, slowSearch);
 
-#ifdef SAAGHAR_DEBUG
-                int end = QDateTime::currentDateTime().toTime_t() * 1000 + QDateTime::currentDateTime().time().msec();
-                int miliSec = end - start;
-                qDebug() << "\n------------------------------------------------\n"
-                         << phrases << "\tsearch-duration=" << miliSec
-                         << "\n------------------------------------------------\n";
-#endif
-
                 if (searchCanceled) {
                     break;
                 }
@@ -487,11 +628,11 @@ void SaagharWindow::searchStart()
 void SaagharWindow::multiSelectObjectInitialize(QMultiSelectWidget* multiSelectWidget, const QStringList &selectedData, int insertIndex)
 {
     QListWidgetItem* rootItem = multiSelectWidget->insertRow(insertIndex, tr("All"), true, "0", Qt::UserRole);
-    QList<GanjoorPoet*> poets = sApp->databaseBrowser()->getPoets();
+    const QVector<GanjoorPoet> poets = sApp->databaseBrowser()->poets();
 
     for (int i = 0; i < poets.size(); ++i) {
-        multiSelectWidget->insertRow(i + 1 + insertIndex, poets.at(i)->_Name, true,
-                                     QString::number(poets.at(i)->_ID), Qt::UserRole, false, rootItem)->setCheckState(selectedData.contains(QString::number(poets.at(i)->_ID)) ? Qt::Checked : Qt::Unchecked);
+        multiSelectWidget->insertRow(i + 1 + insertIndex, poets.at(i)._Name, true,
+                                     QString::number(poets.at(i)._ID), Qt::UserRole, false, rootItem)->setCheckState(selectedData.contains(QString::number(poets.at(i)._ID)) ? Qt::Checked : Qt::Unchecked);
     }
 
     if (selectedData.contains("0")) {
@@ -518,9 +659,9 @@ void SaagharWindow::actionRemovePoet()
     bool ok = false;
     QStringList items;
     items << tr("Select a name...");
-    QList<GanjoorPoet*> poets = sApp->databaseBrowser()->getPoets();
+    const QVector<GanjoorPoet> poets = sApp->databaseBrowser()->poets();
     for (int i = 0; i < poets.size(); ++i) {
-        items << poets.at(i)->_Name + "(" + tr("poet's code=") + QString::number(poets.at(i)->_ID) + ")";
+        items << poets.at(i)._Name + "(" + tr("poet's code=") + QString::number(poets.at(i)._ID) + ")";
     }
     QString item = QInputDialog::getItem(this, tr("Remove Poet"), tr("Select a poet name and click on 'OK' button, for remove it from database."), items, 0, false, &ok);
     if (ok && !item.isEmpty() && item != tr("Select a name...")) {
@@ -540,13 +681,8 @@ void SaagharWindow::actionRemovePoet()
             }
 
             QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+            // outline and home page are refreshed by onDatabaseUpdate()
             sApp->databaseBrowser()->removePoetFromDataBase(poetID);
-            outlineTree->refreshTree();
-
-//            selectSearchRange->clear();
-//            multiSelectInsertItems(selectSearchRange);
-
-            setHomeAsDirty();
             QApplication::restoreOverrideCursor();
             qDebug() << "end of" << Q_FUNC_INFO;
         }
@@ -559,6 +695,13 @@ void SaagharWindow::currentTabChanged(int tabIndex)
 {
     SaagharWidget* tmpSaagharWidget = getSaagharWidget(tabIndex);
     if (tmpSaagharWidget) {
+        // restored tabs are loaded on their first activation
+        tmpSaagharWidget->loadDeferredPage();
+        QTimer::singleShot(0, tmpSaagharWidget, SLOT(setFromMVPosition()));
+
+        m_recentTabs.removeAll(tmpSaagharWidget);
+        m_recentTabs.prepend(tmpSaagharWidget);
+
         SaagharWidget* old_saagharWidget = saagharWidget;
         saagharWidget = tmpSaagharWidget;
 
@@ -572,6 +715,7 @@ void SaagharWindow::currentTabChanged(int tabIndex)
 //        outlineTree->refreshTree();
         saagharWidget->showParentCategory(sApp->databaseBrowser()->getCategory(saagharWidget->currentCat, saagharWidget->connectionID()));//just update parentCatsToolbar
         saagharWidget->resizeTable(saagharWidget->tableViewWidget);
+        m_statisticsWidget->setConnectionID(saagharWidget->connectionID());
 
         connect(SaagharWidget::lineEditSearchText, SIGNAL(textChanged(QString)), saagharWidget, SLOT(scrollToFirstItemContains(QString)));
 
@@ -618,7 +762,7 @@ void SaagharWindow::currentTabChanged(int tabIndex)
         }
         else if (SaagharWidget::maxPoetsPerGroup != 0 &&
                  saagharWidget->currentCat == 0 && saagharWidget->currentPoem == 0) {
-            QList<GanjoorPoet*> poets = sApp->databaseBrowser()->getPoets();
+            const QVector<GanjoorPoet> poets = sApp->databaseBrowser()->poets();
             int numOfPoets = poets.size();
             if (numOfPoets > SaagharWidget::maxPoetsPerGroup) {
                 if (SaagharWidget::maxPoetsPerGroup != 1) {
@@ -704,7 +848,7 @@ void SaagharWindow::checkForUpdates()
     VAR_ADD(arguments, taskTitle);
     VAR_ADD(arguments, checkByUser);
 
-    updateTask->start("UPDATE", arguments);
+    updateTask->start(ConcurrentTask::Update, arguments);
 }
 
 void SaagharWindow::processUpdateData(const QString &type, const QVariant &results)
@@ -1088,6 +1232,140 @@ void SaagharWindow::actionExportClicked()
     }
 }
 
+void SaagharWindow::actionBatchExportClicked()
+{
+    const int catID = saagharWidget ? saagharWidget->currentCat : 0;
+    const QString connectionID = saagharWidget ? saagharWidget->connectionID() : DatabaseBrowser::defaultConnectionId();
+    const GanjoorCat category = sApp->databaseBrowser()->getCategory(catID, connectionID);
+    const QString documentTitle = catID == 0 ? tr("Home") : category._Text;
+
+    QStringList formats;
+    formats << tr("HTML Document") << tr("TeX - XePersian") << tr("UTF-8 Text");
+
+    bool ok = false;
+    const QString formatItem = QInputDialog::getItem(this, tr("Batch Export"), tr("Export \"%1\" and all of its subsections as:").arg(documentTitle), formats, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    const int format = formats.indexOf(formatItem);
+    const QString suffix = CorpusExporter::suffix((CorpusExporter::Format)format);
+
+    QStringList layouts;
+    layouts << tr("One file per poem") << tr("Single file");
+    const QString layoutItem = QInputDialog::getItem(this, tr("Batch Export"), tr("Layout:"), layouts, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    const bool singleFile = layouts.indexOf(layoutItem) == 1;
+
+    QString outputPath;
+    if (singleFile) {
+        outputPath = QFileDialog::getSaveFileName(this, tr("Batch Export"), QDir::homePath() + "/" + documentTitle + "." + suffix, QString("%1 (*.%2)").arg(formatItem).arg(suffix));
+    }
+    else {
+        outputPath = QFileDialog::getExistingDirectory(this, tr("Batch Export"), QDir::homePath());
+    }
+
+    if (outputPath.isEmpty()) {
+        return;
+    }
+
+    // fonts and colors are resolved here, they are not accessible from worker threads
+    const QFont font = SaagharWidget::resolvedFont(LS("SaagharWidget/Fonts/PoemText"));
+    const QString fontFamily = font.family();
+    const int fontSize = font.pointSize();
+    const bool fontBold = font.bold();
+    const QString fontColor = SaagharWidget::resolvedColor(LS("SaagharWidget/Colors/PoemText")).name();
+    const QString taskTitle = tr("Export: %1").arg(documentTitle);
+
+    QVariantHash arguments;
+    VAR_ADD(arguments, connectionID);
+    VAR_ADD(arguments, catID);
+    VAR_ADD(arguments, format);
+    VAR_ADD(arguments, singleFile);
+    VAR_ADD(arguments, outputPath);
+    VAR_ADD(arguments, documentTitle);
+    VAR_ADD(arguments, fontFamily);
+    VAR_ADD(arguments, fontSize);
+    VAR_ADD(arguments, fontBold);
+    VAR_ADD(arguments, fontColor);
+    VAR_ADD(arguments, taskTitle);
+
+    ConcurrentTask* exportTask = new ConcurrentTask(this);
+    connect(exportTask, SIGNAL(concurrentResultReady(QString,QVariant)), this, SLOT(processExportResult(QString,QVariant)));
+    exportTask->start(ConcurrentTask::Export, arguments);
+}
+
+void SaagharWindow::processExportResult(const QString &type, const QVariant &results)
+{
+    Q_UNUSED(type)
+
+    if (sender()) {
+        sender()->deleteLater();
+    }
+
+    // a canceled task has no result
+    if (!results.isValid()) {
+        return;
+    }
+
+    const QString error = results.toString();
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, tr("Error"), tr("Batch export failed:\n%1").arg(error));
+    }
+}
+
+void SaagharWindow::actionCreatePoemPack()
+{
+    // a pack that is in use is not overwritten
+    const QString packFile = PoemPack::newPackFileName(DatabaseBrowser::databaseFileFromID(DatabaseBrowser::defaultConnectionId()));
+
+    QMessageBox createPack(QMessageBox::Information, tr("Create Read-only Pack"),
+                           tr("A read-only pack of the database will be written to:\n%1\n"
+                              "It's used instead of the database when the database is opened read-only, "
+                              "its search text is normalized by current search options.").arg(packFile),
+                           QMessageBox::Ok | QMessageBox::Cancel, this);
+    createPack.setDefaultButton(QMessageBox::Ok);
+    if (createPack.exec() != QMessageBox::Ok) {
+        return;
+    }
+
+    QVariantHash arguments;
+    const QString connectionID = DatabaseBrowser::defaultConnectionId();
+    const QString taskTitle = tr("Create Read-only Pack");
+    VAR_ADD(arguments, connectionID);
+    VAR_ADD(arguments, packFile);
+    VAR_ADD(arguments, taskTitle);
+
+    ConcurrentTask* packTask = new ConcurrentTask(this);
+    connect(packTask, SIGNAL(concurrentResultReady(QString,QVariant)), this, SLOT(processPackResult(QString,QVariant)));
+    packTask->start(ConcurrentTask::Pack, arguments);
+}
+
+void SaagharWindow::processPackResult(const QString &type, const QVariant &results)
+{
+    Q_UNUSED(type)
+
+    if (sender()) {
+        sender()->deleteLater();
+    }
+
+    // a canceled task has no result
+    if (!results.isValid()) {
+        return;
+    }
+
+    const QString error = results.toString();
+    if (error.isEmpty()) {
+        QMessageBox::information(this, tr("Create Read-only Pack"), tr("The read-only pack was created."));
+    }
+    else {
+        QMessageBox::warning(this, tr("Error"), tr("The read-only pack could not be created:\n%1").arg(error));
+    }
+}
+
 void SaagharWindow::writeToFile(QString fileName, QString textToWrite)
 {
     QFile exportFile(fileName);
@@ -1427,17 +1705,16 @@ void SaagharWindow::openRandomPoem(int parentID, bool newPage, const QString &co
     int actionData = parentID;
 
     int PoemID = sApp->databaseBrowser()->getRandomPoemID(&actionData, theConnectionID);
-    GanjoorPoem poem = sApp->databaseBrowser()->getPoem(PoemID, theConnectionID);
-    if (!poem.isNull() && poem._CatID == actionData)
-        if (newPage || !saagharWidget) {
-            newTabForItem(poem._ID, "PoemID", true, true, theConnectionID);
-        }
-        else {
-            saagharWidget->processClickedItem("PoemID", poem._ID, true, true, theConnectionID);
-        }
+    // an empty subtree has no poem to pick
+    if (PoemID < 0) {
+        return;
+    }
+
+    if (newPage || !saagharWidget) {
+        newTabForItem(PoemID, "PoemID", true, true, theConnectionID);
+    }
     else {
-        //not any random id exists, so repeat until finding a valid id
-        openRandomPoem(parentID, newPage, theConnectionID);
+        saagharWidget->processClickedItem("PoemID", PoemID, true, true, theConnectionID);
     }
 }
 
@@ -1467,6 +1744,10 @@ void SaagharWindow::closeCurrentTab()
 
 void SaagharWindow::actionImportNewSet()
 {
+    if (!DataBaseUpdater::canInstall(this)) {
+        return;
+    }
+
     QStringList fileList = QFileDialog::getOpenFileNames(this, tr("Browse for a new set"), QDir::homePath(), "Supported Files (*.gdb *.s3db *.zip);;Ganjoor DataBase (*.gdb *.s3db);;Compressed Data Sets (*.zip);;All Files (*.*)");
     if (!fileList.isEmpty()) {
         if (!DatabaseBrowser::dbUpdater) {
@@ -1607,6 +1888,7 @@ void SaagharWindow::setupUi()
     actionInstance("actionExport", ICON_FILE("export"), tr("&Export As..."))->setShortcuts(QKeySequence::SaveAs);
 
     actionInstance("actionExportAsPDF", ICON_FILE("export-pdf"), tr("Exp&ort As PDF..."));
+    actionInstance("actionBatchExport", ICON_FILE("export"), tr("&Batch Export..."));
 
     actionInstance("actionHelpContents", ICON_FILE("help-contents"), tr("&Help Contents..."))->setShortcuts(QKeySequence::HelpContents);
 
@@ -1619,6 +1901,8 @@ void SaagharWindow::setupUi()
 
     actionInstance("actionRemovePoet", ICON_FILE("remove-poet"), tr("&Remove Poet..."));
 
+    actionInstance("actionCreatePoemPack", QString(), tr("Create Read-only &Pack"));
+
     actionInstance("actionFullScreen", ICON_FILE("fullscreen"), tr("&Full Screen"))->setCheckable(true);
 #ifndef Q_OS_MAC
     actionInstance("actionFullScreen")->setShortcut(Qt::Key_F11);
@@ -1705,6 +1989,18 @@ void SaagharWindow::setupUi()
     actionInstance("outlineDockAction")->setIcon(QIcon(ICON_FILE("outline")));
     actionInstance("outlineDockAction")->setObjectName(QString::fromUtf8("outlineDockAction"));
 
+    m_statisticsWidget = new CorpusStatisticsWidget;
+    m_statisticsDock = new QDockWidget(tr("Statistics"), this);
+    m_statisticsDock->setObjectName("statisticsDock");
+    m_statisticsDock->setWidget(m_statisticsWidget);
+    m_statisticsDock->setStyleSheet("QDockWidget::title { background: transparent; text-align: left; padding: 0 10 0 10;}"
+                                    "QDockWidget::close-button, QDockWidget::float-button { background: transparent;}");
+    m_statisticsDock->hide();
+    addDockWidget(Qt::RightDockWidgetArea, m_statisticsDock);
+    allActionMap.insert("statisticsDockAction", m_statisticsDock->toggleViewAction());
+    actionInstance("statisticsDockAction")->setObjectName(QString::fromUtf8("statisticsDockAction"));
+    connect(m_statisticsWidget, SIGNAL(verseRequested(int,int,QString)), this, SLOT(openVerse(int,int,QString)));
+
     switch (SaagharWidget::CurrentViewStyle) {
     case SaagharWidget::TwoHemistichLine:
         actionInstance("TwoHemistichPoemViewStyle")->setChecked(true);
@@ -1783,6 +2079,7 @@ void SaagharWindow::setupUi()
     }
     menuFile->addAction(actionInstance("actionExportAsPDF"));
     menuFile->addAction(actionInstance("actionExport"));
+    menuFile->addAction(actionInstance("actionBatchExport"));
     menuFile->addSeparator();
     menuFile->addAction(actionInstance("actionPrintPreview"));
     menuFile->addAction(actionInstance("actionPrint"));
@@ -1825,6 +2122,7 @@ void SaagharWindow::setupUi()
     panelsView->addAction(actionInstance("albumDockAction"));
 #endif
     panelsView->addAction(actionInstance("bookmarkManagerDockAction"));
+    panelsView->addAction(actionInstance("statisticsDockAction"));
     menuView->addMenu(panelsView);
 
     menuView->addSeparator();
@@ -1848,6 +2146,7 @@ void SaagharWindow::setupUi()
     menuTools->addSeparator();
     menuTools->addAction(actionInstance("actionImportNewSet"));
     menuTools->addAction(actionInstance("actionRemovePoet"));
+    menuTools->addAction(actionInstance("actionCreatePoemPack"));
     menuTools->addSeparator();
     menuTools->addAction(actionInstance("DownloadRepositories"));
 #ifdef MEDIA_PLAYER
@@ -2147,6 +2446,7 @@ void SaagharWindow::createConnections()
     connect(actionInstance("actionCloseTab")            ,   SIGNAL(triggered())     ,   this, SLOT(closeCurrentTab()));
     connect(actionInstance("actionExportAsPDF")         ,   SIGNAL(triggered())     ,   this, SLOT(actionExportAsPDFClicked()));
     connect(actionInstance("actionExport")              ,   SIGNAL(triggered())     ,   this, SLOT(actionExportClicked()));
+    connect(actionInstance("actionBatchExport")         ,   SIGNAL(triggered())     ,   this, SLOT(actionBatchExportClicked()));
     connect(actionInstance("actionPrintPreview")        ,   SIGNAL(triggered())     ,   this, SLOT(actionPrintPreviewClicked()));
     connect(actionInstance("actionPrint")               ,   SIGNAL(triggered())     ,   this, SLOT(actionPrintClicked()));
     connect(actionInstance("actionExit")                ,   SIGNAL(triggered())     ,   this, SLOT(close()));
@@ -2167,6 +2467,7 @@ void SaagharWindow::createConnections()
     connect(actionInstance("actionSettings")            ,   SIGNAL(triggered())     ,   this, SLOT(showSettingsDialog()));
     connect(actionInstance("actionRemovePoet")          ,   SIGNAL(triggered())     ,   this, SLOT(actionRemovePoet()));
     connect(actionInstance("actionImportNewSet")        ,   SIGNAL(triggered())     ,   this, SLOT(actionImportNewSet()));
+    connect(actionInstance("actionCreatePoemPack")      ,   SIGNAL(triggered())     ,   this, SLOT(actionCreatePoemPack()));
 
     //Help
     connect(actionInstance("actionHelpContents")        ,   SIGNAL(triggered())     ,   this, SLOT(helpContents()));
@@ -2398,7 +2699,9 @@ void SaagharWindow::showPreface(int prefaceID, bool silent)
 
 void SaagharWindow::saveSettings()
 {
-    if (SaagharWidget::bookmarks) {
+    // don't overwrite bookmarks file when it's not loaded yet, usually
+    // changes are already persisted by the bookmarks journal
+    if (SaagharWidget::bookmarks && m_bookmarksLoaded && SaagharWidget::bookmarks->needsCompaction()) {
         QFile bookmarkFile(sApp->defaultPath(SaagharApplication::BookmarksFile));
         if (!bookmarkFile.open(QFile::WriteOnly | QFile::Text)) {
             QMessageBox::warning(this, tr("Bookmarks"), tr("Can not write the bookmark file %1:\n%2.")
@@ -2407,6 +2710,7 @@ void SaagharWindow::saveSettings()
         }
         else {
             SaagharWidget::bookmarks->write(&bookmarkFile);
+            SaagharWidget::bookmarks->clearJournal();
         }
     }
 
@@ -2436,22 +2740,33 @@ void SaagharWindow::saveSettings()
     VAR_DECL("SaagharWindow/State0", saveState(0));
     VAR_DECL("SaagharWindow/Geometry", saveGeometry());
 
-    QStringList openedTabs;
-    for (int i = 0; i < mainTabWidget->count(); ++i) {
-        SaagharWidget* tmp = getSaagharWidget(i);
-        if (tmp && !tmp->isLocalDataset()) {
-            QString tabViewType;
-            if (tmp->currentPoem > 0) {
-                tabViewType = "PoemID=" + QString::number(tmp->currentPoem);
-            }
-            else {
-                tabViewType = "CatID=" + QString::number(tmp->currentCat);
-            }
+    // last session is kept when window is closed before restoring it
+    if (m_sessionTabsRestored) {
+        QStringList openedTabs;
+        QStringList tabsState;
+        for (int i = 0; i < mainTabWidget->count(); ++i) {
+            SaagharWidget* tmp = getSaagharWidget(i);
+            if (tmp && !tmp->isLocalDataset()) {
+                QString tabViewType;
+                if (tmp->currentPoem > 0) {
+                    tabViewType = "PoemID=" + QString::number(tmp->currentPoem);
+                }
+                else {
+                    tabViewType = "CatID=" + QString::number(tmp->currentCat);
+                }
+
+                openedTabs << tabViewType;
 
-            openedTabs << tabViewType;
+                int recency = m_recentTabs.indexOf(tmp);
+                if (recency < 0) {
+                    recency = m_recentTabs.size() + i;
+                }
+                tabsState << QString("%1,%2").arg(tmp->sessionVerticalPosition()).arg(recency);
+            }
         }
+        VAR_DECL("SaagharWindow/LastSessionTabs", openedTabs);
+        VAR_DECL("SaagharWindow/LastSessionTabsState", tabsState);
     }
-    VAR_DECL("SaagharWindow/LastSessionTabs", openedTabs);
 
     //database path
     VAR_DECL("DatabaseBrowser/DataBasePath", QDir::toNativeSeparators(sApp->defaultPath(SaagharApplication::DatabaseDirs)));
@@ -2461,6 +2776,7 @@ void SaagharWindow::saveSettings()
     VAR_DECL("Search/NonPagedResults", SearchResultWidget::nonPagedSearch);
     VAR_DECL("Search/SkipVowelSigns", SearchResultWidget::skipVowelSigns);
     VAR_DECL("Search/SkipVowelLetters", SearchResultWidget::skipVowelLetters);
+    VAR_DECL("Search/ApproximateDistance", SearchResultWidget::approximateDistance);
 
 //    QList<QListWidgetItem*> selectedItems = selectSearchRange->getSelectedItemList();
 
@@ -2792,6 +3108,12 @@ void SaagharWindow::highlightTextOnPoem(int poemId, int vorder)
     emit highlightedTextChanged(highlightedText);
 }
 
+void SaagharWindow::openVerse(int poemId, int vorder, const QString &connectionID)
+{
+    newTabForItem(poemId, "PoemID", true, true, connectionID);
+    highlightTextOnPoem(poemId, vorder);
+}
+
 void SaagharWindow::openPath(const QString &path)
 {
     QString SEPARATOR = QLatin1String("/");
@@ -3152,6 +3474,10 @@ void SaagharWindow::namedActionTriggered(bool checked)
         ImporterManager::instance()->initializeImport();
     }
     else if (actionName == "DownloadRepositories") {
+        if (!DataBaseUpdater::canInstall(this)) {
+            return;
+        }
+
         if (!DatabaseBrowser::dbUpdater) {
             DatabaseBrowser::dbUpdater = new DataBaseUpdater(this);
         }
@@ -3259,11 +3585,14 @@ void SaagharWindow::namedActionTriggered(bool checked)
         QVariantHash arguments;
         const QString taskTitle = tr("Clean Up Database");
         const QString connectionID = DatabaseBrowser::defaultConnectionId();
+        // an interrupted clean up continues from its checkpoint
+        const QString checkpointFile = sApp->defaultPath(SaagharApplication::UserDataDir) + "/cleanup-checkpoint";
 
         VAR_ADD(arguments, connectionID);
         VAR_ADD(arguments, taskTitle);
+        VAR_ADD(arguments, checkpointFile);
 
-        cleanUpTask->start("DB_CLEANUP", arguments);
+        cleanUpTask->start(ConcurrentTask::DatabaseCleanup, arguments);
     }
 #endif
 
@@ -3400,9 +3729,36 @@ void SaagharWindow::setupBookmarkManagerUi()
     bookmarkMainLayout->addLayout(bookmarkToolsLayout);//move to bottom of layout! just we want looks similar other dock widgets!
     bookmarkContainer->setLayout(bookmarkMainLayout);
 
-    QFile bookmarkFile(sApp->defaultPath(SaagharApplication::BookmarksFile));
+    m_bookmarkManagerDock->setWidget(bookmarkContainer /*SaagharWidget::bookmarks*/);
+    addDockWidget(Qt::RightDockWidgetArea, m_bookmarkManagerDock);
+
+    m_bookmarkManagerDock->toggleViewAction()->setIcon(QIcon(ICON_FILE("bookmark-folder")));
+    m_bookmarkManagerDock->toggleViewAction()->setObjectName(QString::fromUtf8("copyOfBookmarkManagerDockAction"));
+    connect(m_bookmarkManagerDock->toggleViewAction(), SIGNAL(triggered(bool)), this, SLOT(namedActionTriggered(bool)));
 
-    bool readBookmarkFile = true;
+    // Fixed a bug (unity's global-menu): as a copy for toggleViewAction()
+    //  that we'll add to panelsView submenu.
+    actionInstance("bookmarkManagerDockAction")->setText(m_bookmarkManagerDock->toggleViewAction()->text());
+    actionInstance("bookmarkManagerDockAction")->setCheckable(true);
+    actionInstance("bookmarkManagerDockAction")->setChecked(m_bookmarkManagerDock->toggleViewAction()->isChecked());
+    actionInstance("bookmarkManagerDockAction")->setIcon(QIcon(ICON_FILE("bookmark-folder")));
+    actionInstance("bookmarkManagerDockAction")->setObjectName(QString::fromUtf8("bookmarkManagerDockAction"));
+    connect(m_bookmarkManagerDock, SIGNAL(visibilityChanged(bool)), actionInstance("bookmarkManagerDockAction"), SLOT(setChecked(bool)));
+
+    menuBookmarks = new QMenu(tr("&Bookmarks"), ui->menuBar);
+    menuBookmarks->setObjectName(QString::fromUtf8("menuBookmarks"));
+    menuBookmarks->addAction(m_bookmarkManagerDock->toggleViewAction());
+    menuBookmarks->addSeparator();
+    menuBookmarks->addAction(actionInstance("ImportGanjoorBookmarks", ICON_FILE("bookmarks-import"), tr("&Import Ganjoor's Bookmarks")));
+}
+
+void SaagharWindow::loadBookmarks()
+{
+    if (!SaagharWidget::bookmarks) {
+        return;
+    }
+
+    QFile bookmarkFile(sApp->defaultPath(SaagharApplication::BookmarksFile));
 
     if (!bookmarkFile.exists()) {
         //create an empty XBEL file.
@@ -3417,58 +3773,35 @@ void SaagharWindow::setupBookmarkManagerUi()
         }
     }
 
-    if (!bookmarkFile.open(QFile::ReadOnly | QFile::Text) || !SaagharWidget::bookmarks->read(&bookmarkFile)) {
-        readBookmarkFile = false;
+    if (bookmarkFile.open(QFile::ReadOnly | QFile::Text) && SaagharWidget::bookmarks->read(&bookmarkFile)) {
+        SaagharWidget::bookmarks->setJournalFile(bookmarkFile.fileName() + ".journal");
+        m_bookmarksLoaded = true;
+        return;
     }
 
-    if (readBookmarkFile) {
-        m_bookmarkManagerDock->setWidget(bookmarkContainer /*SaagharWidget::bookmarks*/);
-        addDockWidget(Qt::RightDockWidgetArea, m_bookmarkManagerDock);
-
-        m_bookmarkManagerDock->toggleViewAction()->setIcon(QIcon(ICON_FILE("bookmark-folder")));
-        m_bookmarkManagerDock->toggleViewAction()->setObjectName(QString::fromUtf8("copyOfBookmarkManagerDockAction"));
-        connect(m_bookmarkManagerDock->toggleViewAction(), SIGNAL(triggered(bool)), this, SLOT(namedActionTriggered(bool)));
-
-        // Fixed a bug (unity's global-menu): as a copy for toggleViewAction()
-        //  that we'll add to panelsView submenu.
-        actionInstance("bookmarkManagerDockAction")->setText(m_bookmarkManagerDock->toggleViewAction()->text());
-        actionInstance("bookmarkManagerDockAction")->setCheckable(true);
-        actionInstance("bookmarkManagerDockAction")->setChecked(m_bookmarkManagerDock->toggleViewAction()->isChecked());
-        actionInstance("bookmarkManagerDockAction")->setIcon(QIcon(ICON_FILE("bookmark-folder")));
-        actionInstance("bookmarkManagerDockAction")->setObjectName(QString::fromUtf8("bookmarkManagerDockAction"));
-        connect(m_bookmarkManagerDock, SIGNAL(visibilityChanged(bool)), actionInstance("bookmarkManagerDockAction"), SLOT(setChecked(bool)));
-
-        menuBookmarks = new QMenu(tr("&Bookmarks"), ui->menuBar);
-        menuBookmarks->setObjectName(QString::fromUtf8("menuBookmarks"));
-        menuBookmarks->addAction(m_bookmarkManagerDock->toggleViewAction());
-        menuBookmarks->addSeparator();
-        menuBookmarks->addAction(actionInstance("ImportGanjoorBookmarks", ICON_FILE("bookmarks-import"), tr("&Import Ganjoor's Bookmarks")));
-    }
-    else {
-        //bookmark not loaded!
-        QStringList items = sApp->mainToolBarItems();
-        items.removeAll("bookmarkManagerDockAction");
-        items.removeAll("ImportGanjoorBookmarks");
-        sApp->setMainToolBarItems(items);
-
-        deleteActionInstance("bookmarkManagerDockAction");
-        deleteActionInstance("ImportGanjoorBookmarks");
-        allActionMap.insert("bookmarkManagerDockAction", 0);
-        allActionMap.insert("ImportGanjoorBookmarks", 0);
-        delete SaagharWidget::bookmarks;
-        delete bookmarkContainer;
-        bookmarkContainer = 0;
-        SaagharWidget::bookmarks = 0;
-        delete m_bookmarkManagerDock;
-        m_bookmarkManagerDock = 0;
-        menuBookmarks = 0;
-        showStatusText("!QExtendedSplashScreenCommands:HIDE");
-        QMessageBox warning(QMessageBox::Warning, tr("Warning!"), tr("Bookmarking system was disabled, something going wrong with "
-                            "writing or reading from bookmarks file:\n%1")
-                            .arg(sApp->defaultPath(SaagharApplication::BookmarksFile)), QMessageBox::Ok, this, Qt::Dialog | Qt::MSWindowsFixedSizeDialogHint | Qt::WindowStaysOnTopHint);
-        warning.exec();
-        showStatusText("!QExtendedSplashScreenCommands:SHOW");
-    }
+    //bookmark not loaded!
+    QStringList items = sApp->mainToolBarItems();
+    items.removeAll("bookmarkManagerDockAction");
+    items.removeAll("ImportGanjoorBookmarks");
+    sApp->setMainToolBarItems(items);
+
+    deleteActionInstance("bookmarkManagerDockAction");
+    deleteActionInstance("ImportGanjoorBookmarks");
+    allActionMap.insert("bookmarkManagerDockAction", 0);
+    allActionMap.insert("ImportGanjoorBookmarks", 0);
+    delete SaagharWidget::bookmarks;
+    SaagharWidget::bookmarks = 0;
+    // bookmark container is deleted by its dock widget
+    delete m_bookmarkManagerDock;
+    m_bookmarkManagerDock = 0;
+    delete menuBookmarks;
+    menuBookmarks = 0;
+    showStatusText("!QExtendedSplashScreenCommands:HIDE");
+    QMessageBox warning(QMessageBox::Warning, tr("Warning!"), tr("Bookmarking system was disabled, something going wrong with "
+                        "writing or reading from bookmarks file:\n%1")
+                        .arg(sApp->defaultPath(SaagharApplication::BookmarksFile)), QMessageBox::Ok, this, Qt::Dialog | Qt::MSWindowsFixedSizeDialogHint | Qt::WindowStaysOnTopHint);
+    warning.exec();
+    showStatusText("!QExtendedSplashScreenCommands:SHOW");
 }
 
 void SaagharWindow::ensureVisibleBookmarkedItem(const QString &type, const QString &itemText, const QString &data, bool ensureVisible, bool unbookmark)
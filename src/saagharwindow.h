@@ -25,6 +25,7 @@
 #include "saagharwidget.h"
 
 #include <QMainWindow>
+#include <QPointer>
 #include <QSettings>
 #include <QSpinBox>
 #include <QToolButton>
@@ -42,6 +43,7 @@ class QIrBreadCrumbBar;
 class BreadCrumbSaagharModel;
 class AudioRepoDownloader;
 class SearchOptionsDialog;
+class CorpusStatisticsWidget;
 
 namespace Ui
 {
@@ -148,15 +150,26 @@ private:
     QString m_compareSettings;
     QDockWidget* m_outlineDock;
     QDockWidget* m_bookmarkManagerDock;
+    QDockWidget* m_statisticsDock;
+    CorpusStatisticsWidget* m_statisticsWidget;
 #ifdef MEDIA_PLAYER
     AudioRepoDownloader* m_audioRepoDownloader;
 #endif
     bool m_updateTaskScheduled;
     SearchOptionsDialog* m_searchOptions;
+    bool m_bookmarksLoaded;
+    bool m_sessionTabsRestored;
+
+    // the most recently activated tab is the first one
+    QList<QPointer<SaagharWidget> > m_recentTabs;
+    // restored tabs that are loaded in background when window is idle
+    QList<QPointer<SaagharWidget> > m_tabsToPrefetch;
+    void loadDeferredTab(SaagharWidget* widget);
 
 public slots:
     void updateTabsSubMenus();
     void highlightTextOnPoem(int poemId, int vorder);
+    void openVerse(int poemId, int vorder, const QString &connectionID);
 
 private slots:
     void openPath(const QString &path);
@@ -175,6 +188,7 @@ private slots:
     void setAllAsDirty();
     void setAsDirty(int catId, int poemId);//-1 for skip it
     void actionClosedTabsClicked();
+    void prefetchRestoredTab();
     void namedActionTriggered(bool checked = false);
     void toolbarViewChanges(QAction* action);
     void customizeRandomDialog();
@@ -192,6 +206,10 @@ private slots:
     void print(QPrinter* printer);
     void actionExportAsPDFClicked();
     void actionExportClicked();
+    void actionBatchExportClicked();
+    void processExportResult(const QString &type, const QVariant &results);
+    void actionCreatePoemPack();
+    void processPackResult(const QString &type, const QVariant &results);
     void actionPrintClicked();
     // empty connectionID means DatabaseBrowser::defaultConnectionId()
     void openRandomPoem(int parentID, bool newPage = false, const QString &connectionID = QString());
@@ -218,6 +236,12 @@ private slots:
     //Tools
     void actionGanjoorSiteClicked();
 
+    // deferred startup phases, run by StartupScheduler
+    void loadBookmarks();
+    void restoreSessionTabs();
+    void loadCatalog();
+    void loadAlbums();
+
     //search options
     void showSearchOptionsDialog();
     void showSearchTips();
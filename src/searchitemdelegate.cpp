@@ -32,9 +32,7 @@
 
 SaagharItemDelegate::SaagharItemDelegate(QWidget* parent, QStyle* style, QString phrase) : QItemDelegate(parent)
 {
-    keywordList.clear();
-    keywordList = SearchPatternManager::instance()->phraseToList(phrase, false);
-    keywordList.removeDuplicates();
+    m_keywordHighlighter.setKeywords(SearchPatternManager::instance()->phraseToList(phrase, false));
 
     parentWidget = parent;
 
@@ -185,6 +183,35 @@ void SaagharItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem &o
 }
 #endif // old highlight algorithm
 
+static QColor highlightBackground()
+{
+    QColor highlight = SaagharWidget::matchedTextColor;
+
+    // see: http://gamedev.stackexchange.com/a/38542
+    qreal l = 0.2126 * highlight.redF() * highlight.redF() +
+              0.7152 * highlight.greenF() * highlight.greenF() +
+              0.0722 * highlight.blueF() * highlight.blueF();
+
+    if (l > 0.85) {
+        highlight = highlight.darker(150);
+        highlight.setAlpha(200);
+    }
+    else if (l > 0.6) {
+        highlight = highlight.lighter(105);
+        highlight.setAlpha(40);
+    }
+    else if (l > 0.4) {
+        highlight = highlight.lighter(120);
+        highlight.setAlpha(50);
+    }
+    else {
+        highlight = highlight.lighter(140);
+        highlight.setAlpha(30);
+    }
+
+    return highlight;
+}
+
 // taken from qitemdelegate.cpp
 inline static QString replaceNewLine(QString text)
 {
@@ -329,79 +356,32 @@ void SaagharItemDelegate::updateAdditionalFormats() const
     m_additionalFormats.clear();
     m_textLayout.clearAdditionalFormats();
 
-    const QString &text = m_textLayout.text();
-    qreal pointSize = m_textLayout.font().pointSizeF() + 2.0;
-    //int fontWeight = m_textLayout.font().weight() + 50;
-    QColor highlight = SaagharWidget::matchedTextColor;
-
-    // see: http://gamedev.stackexchange.com/a/38542
-    qreal l = 0.2126 * highlight.redF() * highlight.redF() +
-              0.7152 * highlight.greenF() * highlight.greenF() +
-              0.0722 * highlight.blueF() * highlight.blueF();
-
-    if (l > 0.85) {
-        highlight = highlight.darker(150);
-        highlight.setAlpha(200);
-    }
-    else if (l > 0.6) {
-        highlight = highlight.lighter(105);
-        highlight.setAlpha(40);
-    }
-    else if (l > 0.4) {
-        highlight = highlight.lighter(120);
-        highlight.setAlpha(50);
-    }
-    else {
-        highlight = highlight.lighter(140);
-        highlight.setAlpha(30);
+    const KeywordHighlighter::Spans spans = m_keywordHighlighter.matches(m_textLayout.text());
+    if (spans.isEmpty()) {
+        return;
     }
 
-    int keywordsCount = keywordList.size();
-    for (int i = 0; i < keywordsCount; ++i) {
-        QString keyword = keywordList.at(i);
-        if (keyword.isEmpty()) {
-            continue;
-        }
-
-        keyword = keyword.split("", QString::SkipEmptyParts).join("[" + Tools::OTHER_GLYPHS + "]*") + "[" + Tools::OTHER_GLYPHS + "]*";
-        keyword.replace("@[" + Tools::OTHER_GLYPHS + "]*", "\\S*", Qt::CaseInsensitive); //replace wildcard by word chars
-        keyword.replace(Tools::AE_Variant.at(0), "(" + Tools::AE_Variant.join("|") + ")");
-        keyword.replace(Tools::Ye_Variant.at(0), "(" + Tools::Ye_Variant.join("|") + ")");
-        keyword.replace(Tools::He_Variant.at(0), "(" + Tools::He_Variant.join("|") + ")");
-        keyword.replace(Tools::Ve_Variant.at(0), "(" + Tools::Ve_Variant.join("|") + ")");
-        QRegExp maybeOthers(keyword, Qt::CaseInsensitive);
-
-        int pos = 0;
-        while ((pos = maybeOthers.indexIn(text, pos)) != -1) {
-            QTextLayout::FormatRange fr;
-            fr.start = pos;
-            fr.length = maybeOthers.matchedLength();
-
-            if (fr.length == 0) {
-                break;
-            }
-            pos += fr.length;
+    QTextCharFormat format;
+    format.setFontPointSize(m_textLayout.font().pointSizeF() + 2.0);
+    format.setForeground(SaagharWidget::matchedTextColor);
+    format.setBackground(highlightBackground());
+    format.setFontWeight(99);
 
-            fr.format.setFontPointSize(pointSize);
-            fr.format.setForeground(SaagharWidget::matchedTextColor);
-            fr.format.setBackground(highlight);
-            fr.format.setFontWeight(99);
+    foreach (const KeywordHighlighter::Span &span, spans) {
+        QTextLayout::FormatRange fr;
+        fr.start = span.start;
+        fr.length = span.length;
+        fr.format = format;
 
-            m_additionalFormats << fr;
-        }
+        m_additionalFormats << fr;
     }
 
-    if (!m_additionalFormats.isEmpty()) {
-        m_textLayout.setAdditionalFormats(m_additionalFormats);
-    }
+    m_textLayout.setAdditionalFormats(m_additionalFormats);
 }
 
 void SaagharItemDelegate::keywordChanged(const QString &text)
 {
-    keywordList.clear();
-    QString tmp = text;
-    keywordList = SearchPatternManager::instance()->phraseToList(tmp, false);
-    keywordList.removeDuplicates();
+    m_keywordHighlighter.setKeywords(SearchPatternManager::instance()->phraseToList(text, false));
 
     if (QAbstractScrollArea* scrollArea = qobject_cast<QAbstractScrollArea*>(parent())) {
         scrollArea->viewport()->update();
@@ -414,70 +394,27 @@ void SaagharItemDelegate::keywordChanged(const QString &text)
 ParagraphHighlighter::ParagraphHighlighter(QTextDocument* parent, const QString &phrase)
     : QSyntaxHighlighter(parent)
 {
-    keywordList.clear();
-    keywordList = SearchPatternManager::instance()->phraseToList(phrase, false);
-    keywordList.removeDuplicates();
+    m_keywordHighlighter.setKeywords(SearchPatternManager::instance()->phraseToList(phrase, false));
 }
 
 void ParagraphHighlighter::keywordChanged(const QString &text)
 {
-    keywordList.clear();
-    QString tmp = text;
-    keywordList = SearchPatternManager::instance()->phraseToList(tmp, false);
-    keywordList.removeDuplicates();
+    m_keywordHighlighter.setKeywords(SearchPatternManager::instance()->phraseToList(text, false));
     rehighlight();
 }
 
 void ParagraphHighlighter::highlightBlock(const QString &text)
 {
-    int keywordsCount = keywordList.size();
-
-    QColor highlight = SaagharWidget::matchedTextColor;
-    // see: http://gamedev.stackexchange.com/a/38542
-    qreal l = 0.2126 * highlight.redF() * highlight.redF() +
-              0.7152 * highlight.greenF() * highlight.greenF() +
-              0.0722 * highlight.blueF() * highlight.blueF();
-
-    if (l > 0.85) {
-        highlight = highlight.darker(150);
-        highlight.setAlpha(200);
-    }
-    else if (l > 0.6) {
-        highlight = highlight.lighter(105);
-        highlight.setAlpha(40);
-    }
-    else if (l > 0.4) {
-        highlight = highlight.lighter(120);
-        highlight.setAlpha(50);
-    }
-    else {
-        highlight = highlight.lighter(140);
-        highlight.setAlpha(30);
+    const KeywordHighlighter::Spans spans = m_keywordHighlighter.matches(text);
+    if (spans.isEmpty()) {
+        return;
     }
 
     QTextCharFormat paragraphHighightFormat;
     paragraphHighightFormat.setForeground(SaagharWidget::matchedTextColor);
-    paragraphHighightFormat.setBackground(highlight);
+    paragraphHighightFormat.setBackground(highlightBackground());
 
-    for (int i = 0; i < keywordsCount; ++i) {
-        QString keyword = keywordList.at(i);
-
-        keyword = keyword.split("", QString::SkipEmptyParts).join("[" + Tools::OTHER_GLYPHS + "]*") + "[" + Tools::OTHER_GLYPHS + "]*";
-        keyword.replace("@[" + Tools::OTHER_GLYPHS + "]*", "\\S*", Qt::CaseInsensitive); //replace wildcard by word chars
-        keyword.replace(Tools::AE_Variant.at(0), "(" + Tools::AE_Variant.join("|") + ")");
-        keyword.replace(Tools::Ye_Variant.at(0), "(" + Tools::Ye_Variant.join("|") + ")");
-        keyword.replace(Tools::He_Variant.at(0), "(" + Tools::He_Variant.join("|") + ")");
-        keyword.replace(Tools::Ve_Variant.at(0), "(" + Tools::Ve_Variant.join("|") + ")");
-        QRegExp maybeOthers(keyword, Qt::CaseInsensitive);
-        int index = maybeOthers.indexIn(text);
-        while (index >= 0) {
-            int length = maybeOthers.matchedLength();
-            if (length == 0) {
-                break;
-            }
-
-            setFormat(index, length, paragraphHighightFormat);
-            index = maybeOthers.indexIn(text, index + length);
-        }
+    foreach (const KeywordHighlighter::Span &span, spans) {
+        setFormat(span.start, span.length, paragraphHighightFormat);
     }
 }
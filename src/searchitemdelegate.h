@@ -22,6 +22,8 @@
 #ifndef SEARCHITEMDELEGATE_H
 #define SEARCHITEMDELEGATE_H
 
+#include "keywordhighlighter.h"
+
 #include <QItemDelegate>
 #include <QSyntaxHighlighter>
 #include <QTextLayout>
@@ -51,7 +53,7 @@ private:
     QWidget* parentWidget;
     qreal opacity;
     QStyle* tableStyle;
-    QStringList keywordList;
+    KeywordHighlighter m_keywordHighlighter;
 
     mutable QTextLayout m_textLayout;
     mutable QTextOption m_textOption;
@@ -73,7 +75,7 @@ protected:
     void highlightBlock(const QString &text);
 
 private:
-    QStringList keywordList;
+    KeywordHighlighter m_keywordHighlighter;
 
 private slots:
     void keywordChanged(const QString &text);
@@ -20,6 +20,10 @@ SearchOptionsDialog::SearchOptionsDialog(QWidget* parent) :
     ui->maxResultSpinBox->setValue(SearchResultWidget::maxItemPerPage);
     ui->vowelSignsCheckBox->setChecked(SearchResultWidget::skipVowelSigns);
     ui->vowelLettersCheckBox->setChecked(SearchResultWidget::skipVowelLetters);
+    ui->approximateCheckBox->setChecked(SearchResultWidget::approximateDistance > 0);
+    ui->approximateSpinBox->setValue(qMax(1, SearchResultWidget::approximateDistance));
+    ui->approximateSpinBox->setEnabled(ui->approximateCheckBox->isChecked());
+    connect(ui->approximateCheckBox, SIGNAL(toggled(bool)), ui->approximateSpinBox, SLOT(setEnabled(bool)));
 
     ui->selectionManager->setButtonBoxHidden(true);
     ui->selectionManager->parentsSelectChildren(true);
@@ -62,6 +66,7 @@ void SearchOptionsDialog::accept()
     SearchResultWidget::nonPagedSearch = nonPaged;
     SearchResultWidget::skipVowelSigns = ui->vowelSignsCheckBox->isChecked();
     SearchResultWidget::skipVowelLetters = ui->vowelLettersCheckBox->isChecked();
+    SearchResultWidget::approximateDistance = ui->approximateCheckBox->isChecked() ? ui->approximateSpinBox->value() : 0;
     if (refreshRequired) {
         emit resultsRefreshRequired();
     }
@@ -24,6 +24,10 @@
 
 #include <QApplication>
 #include <QDebug>
+#include <QRegExp>
+
+// separates operands and distances of an encoded NEAR clause
+static const QChar NEAR_SEPARATOR = QLatin1Char('~');
 
 SearchPatternManager* SearchPatternManager::s_instance = 0;
 
@@ -41,6 +45,7 @@ SearchPatternManager::SearchPatternManager(QObject* parent)
     setOperator(SearchPatternManager::And, QLatin1String("+"));
     setOperator(SearchPatternManager::WithOut, QLatin1String("-"));
     setOperator(SearchPatternManager::WholeWord, QLatin1String("\""));
+    setOperator(SearchPatternManager::Near, QLatin1String("NEAR/"));
 }
 
 SearchPatternManager* SearchPatternManager::instance()
@@ -87,12 +92,20 @@ void SearchPatternManager::init()
         int andListSize = subAndList.size();
         for (int j = 0; j < andListSize; ++j) {
             QString str = subAndList.at(j);
-            if (str.remove(m_wildcardCharacter).isEmpty()) { //for remove empty items
+            if (str.remove(m_wildcardCharacter).isEmpty() || isNearOperator(str)) { //for remove empty items
                 continue;
             }
             //str = str.replace(OP(WholeWord), " ");//moved to the first
             //str = wildcardCharacter+str+wildcardCharacter;
             str = Tools::cleanString(subAndList.at(j));
+
+            //"a NEAR/k b NEAR/l c" is one clause, a NEAR without valid operands is ignored
+            int distance;
+            while (j + 2 < andListSize && isNearOperator(subAndList.at(j + 1), &distance) &&
+                    isNearOperand(str) && isNearOperand(subAndList.at(j + 2))) {
+                str += NEAR_SEPARATOR + QString::number(distance) + NEAR_SEPARATOR + Tools::cleanString(subAndList.at(j + 2));
+                j += 2;
+            }
             m_computedPhraseList.insertMulti(i, str);
         }
     }
@@ -252,7 +265,7 @@ QStringList SearchPatternManager::phraseToList(const QString &str,  bool removeW
     QStringList list = tmp.split(" ", QString::SkipEmptyParts);
     int listSize = list.size();
     for (int i = 0; i < listSize; ++i) {
-        if (list.at(i).startsWith(OP(WithOut), Qt::CaseInsensitive)) {
+        if (list.at(i).startsWith(OP(WithOut), Qt::CaseInsensitive) || isNearOperator(list.at(i))) {
             list[i] = "";
         }
         else {
@@ -262,3 +275,75 @@ QStringList SearchPatternManager::phraseToList(const QString &str,  bool removeW
     list.removeAll("");
     return list;
 }
+
+/*static*/
+bool SearchPatternManager::positionalClause(const QString &phrase, PositionalClause* clause, bool approximate)
+{
+    PositionalClause parsedClause;
+
+    if (phrase.contains(NEAR_SEPARATOR)) {
+        const QStringList parts = phrase.split(NEAR_SEPARATOR);
+        if (parts.size() < 3 || parts.size() % 2 == 0) {
+            return false;
+        }
+
+        for (int i = 0; i < parts.size(); ++i) {
+            if (i % 2 == 1) {
+                bool ok;
+                parsedClause.distances << parts.at(i).toInt(&ok);
+                if (!ok) {
+                    return false;
+                }
+            }
+            else {
+                const QStringList tokens = parts.at(i).split(QLatin1Char(' '), QString::SkipEmptyParts);
+                if (tokens.isEmpty()) {
+                    return false;
+                }
+                parsedClause.operands << tokens;
+            }
+        }
+    }
+    else {
+        //a quoted phrase is surrounded by spaces, one that ends with
+        //Ye-As-Kasre is matched by a regexp in search task
+        const QString YeAsKasre = QString(QChar(71, 6)) + " ";
+        const bool quoted = phrase.startsWith(QLatin1Char(' ')) && phrase.endsWith(QLatin1Char(' '));
+        if (phrase.contains("%") || phrase.contains("=") ||
+                (!approximate && (!quoted || phrase.contains(YeAsKasre)))) {
+            return false;
+        }
+
+        const QStringList tokens = phrase.split(QLatin1Char(' '), QString::SkipEmptyParts);
+        if (tokens.isEmpty()) {
+            return false;
+        }
+        parsedClause.operands << tokens;
+    }
+
+    if (clause) {
+        *clause = parsedClause;
+    }
+
+    return true;
+}
+
+bool SearchPatternManager::isNearOperator(const QString &str, int* distance)
+{
+    QRegExp nearExp(QRegExp::escape(OP(Near)) + "(\\d+)", Qt::CaseInsensitive);
+    if (!nearExp.exactMatch(str)) {
+        return false;
+    }
+
+    if (distance) {
+        *distance = nearExp.cap(1).toInt();
+    }
+
+    return true;
+}
+
+bool SearchPatternManager::isNearOperand(const QString &str)
+{
+    return !str.contains(m_wildcardCharacter) && !str.contains("=") &&
+           !Tools::cleanString(str).trimmed().isEmpty();
+}
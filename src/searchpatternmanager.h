@@ -27,6 +27,14 @@
 #include <QStringList>
 #include <QVector>
 
+// an exact phrase or a NEAR clause of search pattern, it's evaluated by PositionalIndex
+struct PositionalClause {
+    // tokens of each operand, an exact phrase has just one operand
+    QList<QStringList> operands;
+    // maximum token distance from end of each operand to start of its neighbour, in either order
+    QList<int> distances;
+};
+
 class SearchPatternManager : public QObject
 {
     Q_OBJECT
@@ -53,6 +61,11 @@ public:
     void filterResults(QStringList*);
     QStringList phraseToList(const QString &str, bool removeWildCard = true);
 
+    // NEAR clauses are encoded as "a~k~b" in output phrases and quoted
+    // phrases are exact phrases, returns false for other phrases.
+    // 'approximate' accepts plain phrases too, their terms are expanded to close variants
+    static bool positionalClause(const QString &phrase, PositionalClause* clause = 0, bool approximate = false);
+
 private:
     Q_DISABLE_COPY(SearchPatternManager)
     SearchPatternManager(QObject* parent = 0);
@@ -60,6 +73,8 @@ private:
 
     QString OP(SearchPatternManager::Operator op);
     QString clearedPhrase(const QString &str);
+    bool isNearOperator(const QString &str, int* distance = 0);
+    bool isNearOperand(const QString &str);
 
     QMap<SearchPatternManager::Operator, QString> m_operators;
     QString m_wildcardCharacter;
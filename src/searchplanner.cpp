@@ -0,0 +1,148 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "searchplanner.h"
+#include "positionalindex.h"
+#include "searchpatternmanager.h"
+#include "trigramindex.h"
+
+#include <QtAlgorithms>
+
+// assumed number of rows when there is no built index, each literal
+// character of a phrase is assumed to make it eight times more selective
+const int estimatedCorpusRows = 1000000;
+
+struct PlannedPhrase {
+    int index;
+    int cost;
+    int matches;
+};
+
+static bool plannedBefore(const PlannedPhrase &first, const PlannedPhrase &second)
+{
+    if (first.cost != second.cost) {
+        return first.cost < second.cost;
+    }
+    if (first.matches != second.matches) {
+        return first.matches < second.matches;
+    }
+
+    // keep user's order for equal phrases
+    return first.index < second.index;
+}
+
+static QList<int> sortedIndexes(QList<PlannedPhrase> planned)
+{
+    qSort(planned.begin(), planned.end(), plannedBefore);
+
+    QList<int> order;
+    foreach (const PlannedPhrase &phrase, planned) {
+        order << phrase.index;
+    }
+
+    return order;
+}
+
+int SearchPlanner::estimatedMatches(const QString &phrase, const QString &connectionID, bool titles)
+{
+    PositionalClause clause;
+    const bool positional = SearchPatternManager::positionalClause(phrase, &clause);
+
+    if (!connectionID.isEmpty()) {
+        int estimate = TrigramIndex::instance()->estimatedMatches(titles ? TrigramIndex::Titles : TrigramIndex::Verses, connectionID, phrase);
+        if (estimate < 0 && positional && !titles) {
+            estimate = PositionalIndex::instance()->estimatedMatches(connectionID, clause);
+        }
+
+        if (estimate >= 0) {
+            return estimate;
+        }
+    }
+
+    QStringList literalParts;
+    if (positional) {
+        foreach (const QStringList &operand, clause.operands) {
+            literalParts << operand;
+        }
+    }
+    else {
+        QString literal = phrase;
+        literalParts = literal.remove("=").split(QLatin1Char('%'), QString::SkipEmptyParts);
+    }
+
+    int longestPart = 0;
+    foreach (const QString &part, literalParts) {
+        longestPart = qMax(longestPart, part.trimmed().size());
+    }
+
+    return estimatedCorpusRows >> qMin(18, 3 * longestPart);
+}
+
+SearchPlanner::FilterCost SearchPlanner::filterCost(const QString &phrase, bool approximate)
+{
+    if (phrase.contains("=")) {
+        return PoemVersesCost;
+    }
+
+    if (SearchPatternManager::positionalClause(phrase, 0, approximate)) {
+        return TokensCost;
+    }
+
+    //QChar(71,6): Simple He, Ye-As-Kasre is matched by a regexp
+    if (phrase.contains("%") || phrase.contains(QString(QChar(71, 6)) + " ")) {
+        return RegExpCost;
+    }
+
+    return ContainsCost;
+}
+
+QList<int> SearchPlanner::pushDownOrder(const QStringList &phrases, const QString &connectionID, bool titles, bool approximate)
+{
+    QList<PlannedPhrase> planned;
+    for (int i = 0; i < phrases.size(); ++i) {
+        // variants of an approximate phrase don't have a common LIKE pattern
+        if (approximate && SearchPatternManager::positionalClause(phrases.at(i), 0, true)) {
+            continue;
+        }
+
+        PlannedPhrase phrase;
+        phrase.index = i;
+        phrase.cost = 0;
+        phrase.matches = estimatedMatches(phrases.at(i), connectionID, titles);
+        planned << phrase;
+    }
+
+    return sortedIndexes(planned);
+}
+
+QList<int> SearchPlanner::filterOrder(const QStringList &phrases, const QString &connectionID, bool titles, bool approximate)
+{
+    QList<PlannedPhrase> planned;
+    for (int i = 0; i < phrases.size(); ++i) {
+        PlannedPhrase phrase;
+        phrase.index = i;
+        phrase.cost = filterCost(phrases.at(i), approximate);
+        phrase.matches = estimatedMatches(phrases.at(i), connectionID, titles);
+        planned << phrase;
+    }
+
+    return sortedIndexes(planned);
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SEARCHPLANNER_H
+#define SEARCHPLANNER_H
+
+#include <QList>
+#include <QStringList>
+
+// Orders AND-ed phrases of a search task by their estimated selectivity, so
+// the most selective ones are pushed down to SQL and row filters run from
+// the cheapest and most selective to the most expensive ones.
+// Estimates come from search indexes when they are built, otherwise from
+// length of literal parts of phrases.
+class SearchPlanner
+{
+public:
+    enum FilterCost {
+        ContainsCost = 0,
+        TokensCost = 1,
+        RegExpCost = 2,
+        PoemVersesCost = 3 //rhyme and radif load all verses of poem
+    };
+
+    static int estimatedMatches(const QString &phrase, const QString &connectionID = QString(), bool titles = false);
+    static FilterCost filterCost(const QString &phrase, bool approximate = false);
+
+    // phrases that SQL LIKE can select a superset of their matches, the most selective first
+    static QList<int> pushDownOrder(const QStringList &phrases, const QString &connectionID = QString(),
+                                    bool titles = false, bool approximate = false);
+    // all phrases in order of evaluation
+    static QList<int> filterOrder(const QStringList &phrases, const QString &connectionID = QString(),
+                                  bool titles = false, bool approximate = false);
+};
+
+#endif // SEARCHPLANNER_H
@@ -0,0 +1,238 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "searchresultcache.h"
+#include "saagharapplication.h"
+#include "searchresultwidget.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+// separates fields of cache key, it can not be part of a search phrase
+static const QChar KEY_SEPARATOR = QChar(0x1F);
+static const quint32 DISK_CACHE_MAGIC = 0x53524331; // "SRC1"
+
+SearchResultCache* SearchResultCache::s_instance = 0;
+
+SearchResultCache* SearchResultCache::instance()
+{
+    if (!s_instance) {
+        s_instance = new SearchResultCache(sApp);
+    }
+
+    return s_instance;
+}
+
+SearchResultCache::SearchResultCache(QObject* parent)
+    : QObject(parent),
+      m_maxEntries(32),
+      m_generation(0)
+{
+}
+
+SearchResultCache::~SearchResultCache()
+{
+    s_instance = 0;
+}
+
+QString SearchResultCache::cacheKey(const QString &databaseFile, const QString &selectionPath,
+                                    const QStringList &phrases, const QStringList &excluded,
+                                    bool skipVowelSigns, bool skipVowelLetters, int approximateDistance,
+                                    bool slowSearch)
+{
+    QStringList fields;
+    fields << databaseFile
+           << selectionPath
+           << phrases.join(QString(KEY_SEPARATOR))
+           << excluded.join(QString(KEY_SEPARATOR))
+           << QString::number(skipVowelSigns ? 1 : 0)
+           << QString::number(skipVowelLetters ? 1 : 0)
+           << QString::number(approximateDistance)
+           << QString::number(slowSearch ? 1 : 0);
+
+    return fields.join(QString(KEY_SEPARATOR) + KEY_SEPARATOR);
+}
+
+int SearchResultCache::generation()
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_generation;
+}
+
+QString SearchResultCache::indexStamp(const QString &databaseFile)
+{
+    QStringList fields;
+    fields << databaseFile
+           << QString::number(SearchResultWidget::skipVowelSigns ? 1 : 0)
+           << QString::number(SearchResultWidget::skipVowelLetters ? 1 : 0)
+           << QString::number(generation());
+
+    return fields.join(QString(KEY_SEPARATOR));
+}
+
+bool SearchResultCache::find(const QString &key, SearchResults* results)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_results.contains(key)) {
+        m_usage.removeOne(key);
+        m_usage.append(key);
+
+        *results = m_results.value(key);
+        return true;
+    }
+
+    if (readFromDisk(key, results)) {
+        insertToMemory(key, *results);
+        return true;
+    }
+
+    return false;
+}
+
+void SearchResultCache::insert(const QString &key, const SearchResults &results, int generation)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (generation != m_generation || m_maxEntries <= 0) {
+        return;
+    }
+
+    insertToMemory(key, results);
+    writeToDisk(key, results);
+}
+
+void SearchResultCache::setMaxEntries(int maxEntries)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_maxEntries = maxEntries;
+    while (m_usage.size() > qMax(0, m_maxEntries)) {
+        m_results.remove(m_usage.takeFirst());
+    }
+}
+
+void SearchResultCache::setDiskCachePath(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_diskCachePath = path;
+    if (!m_diskCachePath.isEmpty()) {
+        QDir().mkpath(m_diskCachePath);
+    }
+}
+
+void SearchResultCache::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+
+    ++m_generation;
+    m_results.clear();
+    m_usage.clear();
+
+    if (!m_diskCachePath.isEmpty()) {
+        QDir cacheDir(m_diskCachePath);
+        foreach (const QString &fileName, cacheDir.entryList(QStringList() << "*.cache", QDir::Files)) {
+            cacheDir.remove(fileName);
+        }
+    }
+}
+
+void SearchResultCache::insertToMemory(const QString &key, const SearchResults &results)
+{
+    if (m_results.contains(key)) {
+        m_usage.removeOne(key);
+    }
+    else if (m_usage.size() >= m_maxEntries) {
+        m_results.remove(m_usage.takeFirst());
+    }
+
+    m_results.insert(key, results);
+    m_usage.append(key);
+}
+
+QString SearchResultCache::diskFileName(const QString &key) const
+{
+    return m_diskCachePath + "/" + QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".cache";
+}
+
+QString SearchResultCache::databaseStamp(const QString &key) const
+{
+    // a database that is changed out of Saaghar invalidates its disk cache
+    const QFileInfo databaseFile(key.left(key.indexOf(KEY_SEPARATOR)));
+
+    return QString("%1:%2").arg(databaseFile.size()).arg(databaseFile.lastModified().toTime_t());
+}
+
+bool SearchResultCache::readFromDisk(const QString &key, SearchResults* results)
+{
+    if (m_diskCachePath.isEmpty()) {
+        return false;
+    }
+
+    QFile file(diskFileName(key));
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+    quint32 magic;
+    QString storedKey;
+    QString storedStamp;
+    in >> magic >> storedKey >> storedStamp;
+
+    if (magic != DISK_CACHE_MAGIC || storedKey != key || storedStamp != databaseStamp(key)) {
+        file.close();
+        file.remove();
+        return false;
+    }
+
+    SearchResults diskResults;
+    in >> diskResults;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    *results = diskResults;
+    return true;
+}
+
+void SearchResultCache::writeToDisk(const QString &key, const SearchResults &results)
+{
+    if (m_diskCachePath.isEmpty()) {
+        return;
+    }
+
+    QFile file(diskFileName(key));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << DISK_CACHE_MAGIC << key << databaseStamp(key) << results;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SEARCHRESULTCACHE_H
+#define SEARCHRESULTCACHE_H
+
+#include "databasebrowser.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+// LRU cache of search results, it's used from search tasks' threads.
+// Cached results are dropped when any database is updated.
+class SearchResultCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SearchResultCache* instance();
+    ~SearchResultCache();
+
+    // key of a search task, 'phrases' and 'excluded' are normalized by SearchPatternManager
+    static QString cacheKey(const QString &databaseFile, const QString &selectionPath,
+                            const QStringList &phrases, const QStringList &excluded,
+                            bool skipVowelSigns, bool skipVowelLetters, int approximateDistance,
+                            bool slowSearch);
+
+    int generation();
+    // key of search indexes and statistics of a database, it changes when any
+    // database is updated or normalization options are changed
+    QString indexStamp(const QString &databaseFile);
+
+    bool find(const QString &key, SearchResults* results);
+    // results of a task that was started in an older generation are dropped
+    void insert(const QString &key, const SearchResults &results, int generation);
+
+    void setMaxEntries(int maxEntries);
+    // empty path disables on-disk tier
+    void setDiskCachePath(const QString &path);
+
+public slots:
+    void invalidate();
+
+private:
+    Q_DISABLE_COPY(SearchResultCache)
+    SearchResultCache(QObject* parent = 0);
+    static SearchResultCache* s_instance;
+
+    QString diskFileName(const QString &key) const;
+    QString databaseStamp(const QString &key) const;
+    bool readFromDisk(const QString &key, SearchResults* results);
+    void writeToDisk(const QString &key, const SearchResults &results);
+    void insertToMemory(const QString &key, const SearchResults &results);
+
+    QMutex m_mutex;
+    QHash<QString, SearchResults> m_results;
+    // least recently used key is the first one
+    QStringList m_usage;
+    int m_maxEntries;
+    int m_generation;
+    QString m_diskCachePath;
+};
+
+#endif // SEARCHRESULTCACHE_H
@@ -35,14 +35,71 @@
 #include <QHeaderView>
 #include <QApplication>
 #include <QMenu>
+#include <QTimer>
+#include <QtConcurrentRun>
 
 int SearchResultWidget::maxItemPerPage = 100;
 bool SearchResultWidget::nonPagedSearch = false;
 bool SearchResultWidget::skipVowelSigns = false;
 bool SearchResultWidget::skipVowelLetters = false;
+int SearchResultWidget::approximateDistance = 0;
 
 int SearchResultWidget::s_searchWidgetCount = 0;
 
+// delay after the last keystroke before filtering starts
+const int filterDelay = 150;
+
+// runs on a worker thread
+static SearchFilterResult runSearchFilter(SearchFilterResult request, QSharedPointer<QAtomicInt> latestGeneration)
+{
+    SearchFilterResult result = request;
+    result.matches.clear();
+    result.filtered.clear();
+
+    if (result.filterKeys.isEmpty()) {
+        result.keys.reserve(result.results.size());
+        result.values.reserve(result.results.size());
+        result.filterKeys.reserve(result.results.size());
+
+        QMap<int, QString>::const_iterator it = result.results.constBegin();
+        const QMap<int, QString>::const_iterator endIterator = result.results.constEnd();
+        while (it != endIterator) {
+            if ((result.keys.size() & 1023) == 0 && latestGeneration->fetchAndAddOrdered(0) != request.generation) {
+                // a partial index is useless
+                result.keys.clear();
+                result.values.clear();
+                result.filterKeys.clear();
+                result.canceled = true;
+                return result;
+            }
+
+            result.keys.append(it.key());
+            result.values.append(it.value());
+            result.filterKeys.append(Tools::cleanString(it.value()).toCaseFolded());
+            ++it;
+        }
+        request.narrow = false;
+    }
+
+    const int count = request.narrow ? request.matches.size() : result.filterKeys.size();
+
+    for (int i = 0; i < count; ++i) {
+        if ((i & 1023) == 0 && latestGeneration->fetchAndAddOrdered(0) != request.generation) {
+            result.canceled = true;
+            return result;
+        }
+
+        const int pos = request.narrow ? request.matches.at(i) : i;
+
+        if (result.filterKeys.at(pos).contains(result.query)) {
+            result.matches.append(pos);
+            result.filtered.insertMulti(result.keys.at(pos), result.values.at(pos));
+        }
+    }
+
+    return result;
+}
+
 SearchResultWidget::SearchResultWidget(QMainWindow* qmw, QWidget* parent, const QString &searchPhrase, const QString &poetName)
     : QWidget(parent)
     , searchResultWidget(0)
@@ -53,7 +110,18 @@ SearchResultWidget::SearchResultWidget(QMainWindow* qmw, QWidget* parent, const
     , actSearchPreviousPage(0)
     , m_mainWindow(qmw)
     , m_taskInQuequedCount(0)
+    , m_filterGeneration(new QAtomicInt(0))
+    , m_filterPending(false)
+    , m_resultsGeneration(0)
 {
+    m_filterTimer = new QTimer(this);
+    m_filterTimer->setSingleShot(true);
+    m_filterTimer->setInterval(filterDelay);
+    connect(m_filterTimer, SIGNAL(timeout()), this, SLOT(startFilter()));
+
+    m_filterWatcher = new QFutureWatcher<SearchFilterResult>(this);
+    connect(m_filterWatcher, SIGNAL(finished()), this, SLOT(applyFilterResult()));
+
     setupUi(m_mainWindow);
 
     QString dockTitle = m_phrase + ": " + m_sectionName;
@@ -68,6 +136,9 @@ SearchResultWidget::SearchResultWidget(QMainWindow* qmw, QWidget* parent, const
 
 SearchResultWidget::~SearchResultWidget()
 {
+    // stops the running filter
+    m_filterGeneration->fetchAndAddOrdered(1);
+
     --s_searchWidgetCount;
     //qDebug() << "SearchResultWidget is destroyed!";
 }
@@ -76,6 +147,14 @@ void SearchResultWidget::setResultList(const QMap<int, QString> &map)
 {
     copyResultList = resultList = map;
 
+    // filter index is rebuilt for the new list
+    ++m_resultsGeneration;
+    m_lastFilterResult = SearchFilterResult();
+    m_filterText.clear();
+    m_filterTimer->stop();
+    m_filterPending = false;
+    m_filterGeneration->fetchAndAddOrdered(1);
+
     if (map.isEmpty()) {
         deleteLater();
         searchResultWidget->deleteLater();
@@ -535,30 +614,95 @@ void SearchResultWidget::maxItemPerPageChange()
 
 void SearchResultWidget::filterResults(const QString &text)
 {
-    QString str = Tools::cleanString(text);
+    QString str = Tools::cleanString(text).toCaseFolded();
+    if (str == m_filterText) {
+        return;
+    }
+
+    m_filterText = str;
+    // stale running filter stops as soon as possible
+    m_filterGeneration->fetchAndAddOrdered(1);
+
     if (str.isEmpty()) {
+        m_filterTimer->stop();
+        m_filterPending = false;
         resultList = copyResultList;
         emit searchFiltered(m_phrase);
         showSearchResult(0);
         return;
-    }//searchTable->setItemDelegateForColumn(2, new SaagharItemDelegate());
-
-    //SaagharItemDelegate *itemDelegate = searchTable->itemDelegateForColumn(2);
-    //itemDelegate->
-    emit searchFiltered(m_phrase + " " + str);
-    //QMap<int, QString> tmpList;
-
-    resultList.clear();
-    QMap<int, QString>::const_iterator it = copyResultList.constBegin();
-    const QMap<int, QString>::const_iterator endIterator = copyResultList.constEnd();
-    while (it != endIterator) {
-        QString value = it.value();
-        value = Tools::cleanString(value);
-        if (value.contains(str, Qt::CaseInsensitive)) {
-            resultList.insertMulti(it.key(), it.value());
+    }
+
+    m_filterTimer->start();
+}
+
+void SearchResultWidget::startFilter()
+{
+    if (m_filterText.isEmpty()) {
+        return;
+    }
+
+    if (m_filterWatcher->isRunning()) {
+        m_filterPending = true;
+        return;
+    }
+
+    SearchFilterResult request;
+    request.generation = m_filterGeneration->fetchAndAddOrdered(0);
+    request.resultsGeneration = m_resultsGeneration;
+    request.query = m_filterText;
+    request.results = copyResultList;
+
+    if (m_lastFilterResult.resultsGeneration == m_resultsGeneration) {
+        request.keys = m_lastFilterResult.keys;
+        request.values = m_lastFilterResult.values;
+        request.filterKeys = m_lastFilterResult.filterKeys;
+
+        // results containing the longer query are a subset of previous matches
+        if (!m_lastFilterResult.query.isEmpty() && m_filterText.contains(m_lastFilterResult.query)) {
+            request.narrow = true;
+            request.matches = m_lastFilterResult.matches;
         }
-        ++it;
     }
+
+    m_filterWatcher->setFuture(QtConcurrent::run(runSearchFilter, request, m_filterGeneration));
+}
+
+void SearchResultWidget::applyFilterResult()
+{
+    const SearchFilterResult result = m_filterWatcher->result();
+
+    if (result.resultsGeneration == m_resultsGeneration && !result.filterKeys.isEmpty()) {
+        if (result.canceled) {
+            // just keep its index
+            if (m_lastFilterResult.resultsGeneration != m_resultsGeneration) {
+                m_lastFilterResult = result;
+                m_lastFilterResult.query.clear();
+                m_lastFilterResult.matches.clear();
+            }
+        }
+        else {
+            m_lastFilterResult = result;
+        }
+    }
+
+    if (m_filterPending) {
+        m_filterPending = false;
+        startFilter();
+        return;
+    }
+
+    if (result.canceled || result.resultsGeneration != m_resultsGeneration || result.query != m_filterText) {
+        return;
+    }
+
+    resultList = result.filtered;
+    applyFilteredList();
+}
+
+void SearchResultWidget::applyFilteredList()
+{
+    emit searchFiltered(m_phrase + " " + m_filterText);
+
     if (resultList.isEmpty()) {
         pageLabel->setText(tr("Nothing found!"));
         searchPreviousPage->setEnabled(false);
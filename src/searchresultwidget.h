@@ -24,15 +24,40 @@
 
 #include <QMainWindow>
 #include <QHash>
+#include <QMap>
 #include <QTableWidget>
 #include <QToolButton>
 #include <QAction>
 #include <QLabel>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QVector>
 
 class QSearchLineEdit;
+class QTimer;
 
 const int ITEM_SEARCH_DATA = Qt::UserRole + 10;
 
+struct SearchFilterResult {
+    SearchFilterResult() : generation(-1), resultsGeneration(-1), narrow(false), canceled(false) {}
+
+    int generation;
+    // result list is changed when a queued search task is finished
+    int resultsGeneration;
+    QString query;
+    QMap<int, QString> results;
+    // flattened 'results' and their cleaned and case folded texts
+    QVector<int> keys;
+    QVector<QString> values;
+    QVector<QString> filterKeys;
+    // when 'narrow' is set, just these positions are matched again
+    bool narrow;
+    QVector<int> matches;
+    QMap<int, QString> filtered;
+    bool canceled;
+};
+
 
 class SearchResultWidget : public QWidget
 {
@@ -53,6 +78,8 @@ public:
     static bool nonPagedSearch;
     static bool skipVowelSigns;
     static bool skipVowelLetters;
+    // maximum edit distance of approximate search, zero disables it
+    static int approximateDistance;
 
 private:
     QDockWidget* searchResultWidget;
@@ -72,6 +99,18 @@ private:
     QMap<int, QString> copyResultList;
     QStringList viewedItems;
 
+    void applyFilteredList();
+
+    QTimer* m_filterTimer;
+    QFutureWatcher<SearchFilterResult>* m_filterWatcher;
+    // the latest filter generation, running filters stop when it changes
+    QSharedPointer<QAtomicInt> m_filterGeneration;
+    // last finished result, keeps the index and is narrowed by a longer query
+    SearchFilterResult m_lastFilterResult;
+    QString m_filterText;
+    bool m_filterPending;
+    int m_resultsGeneration;
+
     Qt::DockWidgetArea m_dockWidgetArea;
     QMainWindow* m_mainWindow;
     int m_taskInQuequedCount;
@@ -83,6 +122,8 @@ private slots:
     void searchPageNavigationClicked(QAction* action);
     void maxItemPerPageChange();
     void filterResults(const QString &text);
+    void startFilter();
+    void applyFilterResult();
     void onConcurrentResultReady(const QString &type, const QVariant &results);
     void onDockLocationChanged(Qt::DockWidgetArea area);
     void createCustomContextMenu(const QPoint &pos);
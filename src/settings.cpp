@@ -23,10 +23,14 @@
 #include "saagharwindow.h"
 #include "saagharapplication.h"
 #include "settingsmanager.h"
+#include "concurrenttasks.h"
+#include "tracer.h"
 
 #include <QColorDialog>
+#include <QDir>
 #include <QFileDialog>
 #include <QImageReader>
+#include <QMessageBox>
 
 QString Settings::s_currentIconPath;
 
@@ -212,6 +216,45 @@ void Settings::setupTaskManagerUi()
     ui->groupBoxTaskManager->setChecked(VARB("TaskManager/UseAdvancedSettings"));
     ui->comboBoxMode->setCurrentIndex(ui->comboBoxMode->findData(VAR("TaskManager/Mode")));
     ui->comboBoxNotification->setCurrentIndex(ui->comboBoxNotification->findData(VAR("TaskManager/Notification")));
+
+    updateTaskLatency();
+    connect(ConcurrentTaskManager::instance(), SIGNAL(latencyStatsChanged()), this, SLOT(updateTaskLatency()));
+
+    // tracing is toggled immediately and it's not stored
+    ui->checkBoxTracing->setChecked(Tracer::isEnabled());
+    ui->pushButtonSaveTrace->setEnabled(Tracer::isEnabled());
+    connect(ui->checkBoxTracing, SIGNAL(toggled(bool)), this, SLOT(setTracingEnabled(bool)));
+    connect(ui->pushButtonSaveTrace, SIGNAL(clicked()), this, SLOT(saveTrace()));
+}
+
+void Settings::setTracingEnabled(bool enabled)
+{
+    if (enabled && !Tracer::isEnabled()) {
+        Tracer::clear();
+    }
+
+    Tracer::setEnabled(enabled);
+    ui->pushButtonSaveTrace->setEnabled(enabled);
+}
+
+void Settings::saveTrace()
+{
+    const QString fileName = QFileDialog::getSaveFileName(this, tr("Save Trace"),
+                             QDir::homePath() + "/saaghar-trace.json",
+                             tr("Chrome Trace (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    if (!Tracer::exportChromeTrace(fileName)) {
+        QMessageBox::warning(this, tr("Save Trace"), tr("Can not write to file: %1").arg(fileName));
+    }
+}
+
+void Settings::updateTaskLatency()
+{
+    ui->labelTaskLatency->setText(tr("Task latency (this session):") + "\n" +
+                                  ConcurrentTaskManager::instance()->latencyReport());
 }
 
 void Settings::initializeActionTables(const QMap<QString, QAction*> &actionsMap, const QStringList &toolBarItems)
@@ -88,6 +88,9 @@ private slots:
     void browseForBackground();
     void browseForIconTheme();
     void browseForDataBasePath();
+    void updateTaskLatency();
+    void setTracingEnabled(bool enabled);
+    void saveTrace();
 
 private:
     void replaceWithNeighbor(int neighbor);
@@ -34,7 +34,19 @@ HEADERS += \
     $$PWD/importer/txtimporter.h \
     $$PWD/importer/importeroptionsdialog.h \
     $$PWD/importer/selectcreatedialog.h \
-    $$PWD/aboutdialog.h
+    $$PWD/aboutdialog.h \
+    $$PWD/corpusexporter.h \
+    $$PWD/corpusstatistics.h \
+    $$PWD/corpusstatisticswidget.h \
+    $$PWD/startupscheduler.h \
+    $$PWD/searchresultcache.h \
+    $$PWD/positionalindex.h \
+    $$PWD/trigramindex.h \
+    $$PWD/termdictionary.h \
+    $$PWD/searchplanner.h \
+    $$PWD/poempack.h \
+    $$PWD/keywordhighlighter.h \
+    $$PWD/tracer.h
 
 FORMS += \
     $$PWD/saagharwindow.ui \
@@ -47,8 +59,12 @@ FORMS += \
     $$PWD/importer/selectcreatedialog.ui \
     $$PWD/aboutdialog.ui
 
+# saaghar-bench has its own main()
+!CONFIG(saaghar_bench) {
+    SOURCES += $$PWD/main.cpp
+}
+
 SOURCES += \
-    $$PWD/main.cpp \
     $$PWD/saagharwindow.cpp \
     $$PWD/searchitemdelegate.cpp \
     $$PWD/saagharwidget.cpp \
@@ -75,7 +91,19 @@ SOURCES += \
     $$PWD/importer/txtimporter.cpp \
     $$PWD/importer/importeroptionsdialog.cpp \
     $$PWD/importer/selectcreatedialog.cpp \
-    $$PWD/aboutdialog.cpp
+    $$PWD/aboutdialog.cpp \
+    $$PWD/corpusexporter.cpp \
+    $$PWD/corpusstatistics.cpp \
+    $$PWD/corpusstatisticswidget.cpp \
+    $$PWD/startupscheduler.cpp \
+    $$PWD/searchresultcache.cpp \
+    $$PWD/positionalindex.cpp \
+    $$PWD/trigramindex.cpp \
+    $$PWD/termdictionary.cpp \
+    $$PWD/searchplanner.cpp \
+    $$PWD/poempack.cpp \
+    $$PWD/keywordhighlighter.cpp \
+    $$PWD/tracer.cpp
 
 include(pQjWidgets/pqjwidgets.pri)
 include(downloader/downloader.pri)
@@ -0,0 +1,168 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "startupscheduler.h"
+#include "tracer.h"
+
+#include <QEvent>
+#include <QMetaObject>
+#include <QTimer>
+#include <QWidget>
+
+// a hidden or minimized window is not painted, phases start anyway (ms)
+const int firstPaintTimeout = 2000;
+
+StartupScheduler::StartupScheduler(QObject* parent)
+    : QObject(parent),
+      m_firstPaintTime(-1),
+      m_finishTime(-1),
+      m_started(false),
+      m_firstPaintDone(false),
+      m_finished(false)
+{
+    m_startupTimer.start();
+}
+
+void StartupScheduler::addPhase(const QString &name, QObject* receiver, const char* member, int priority)
+{
+    Phase phase;
+    phase.name = name;
+    phase.receiver = receiver;
+    phase.member = member;
+    phase.priority = priority;
+
+    // stable insertion, phases with same priority run in order of adding
+    int index = m_phases.size();
+    while (index > 0 && m_phases.at(index - 1).priority > priority) {
+        --index;
+    }
+    m_phases.insert(index, phase);
+
+    if (m_finished) {
+        m_finished = false;
+        QTimer::singleShot(0, this, SLOT(runNextPhase()));
+    }
+}
+
+void StartupScheduler::recordPhase(const QString &name, qint64 elapsed)
+{
+    m_timings << qMakePair(name, elapsed);
+
+    if (Tracer::isEnabled()) {
+        const qint64 duration = elapsed * 1000;
+        Tracer::record("startup", Tracer::intern(name), Tracer::now() - duration, duration);
+    }
+}
+
+void StartupScheduler::start(QWidget* window)
+{
+    if (m_started) {
+        return;
+    }
+
+    m_started = true;
+
+    if (!window) {
+        QTimer::singleShot(0, this, SLOT(firstPaintDone()));
+        return;
+    }
+
+    m_window = window;
+    m_window->installEventFilter(this);
+    QTimer::singleShot(firstPaintTimeout, this, SLOT(firstPaintDone()));
+}
+
+bool StartupScheduler::eventFilter(QObject* receiver, QEvent* event)
+{
+    if (receiver == m_window.data() && event->type() == QEvent::Paint) {
+        m_window->removeEventFilter(this);
+        m_firstPaintTime = m_startupTimer.elapsed();
+
+        // phases run after this paint event is finished and flushed
+        QTimer::singleShot(0, this, SLOT(firstPaintDone()));
+    }
+
+    return QObject::eventFilter(receiver, event);
+}
+
+void StartupScheduler::firstPaintDone()
+{
+    // the paint event or the timeout, whichever comes first
+    if (m_firstPaintDone) {
+        return;
+    }
+
+    m_firstPaintDone = true;
+
+    if (m_window) {
+        m_window->removeEventFilter(this);
+    }
+
+    if (m_firstPaintTime < 0) {
+        m_firstPaintTime = m_startupTimer.elapsed();
+    }
+
+    runNextPhase();
+}
+
+QString StartupScheduler::report() const
+{
+    QStringList lines;
+    qint64 total = 0;
+    for (int i = 0; i < m_timings.size(); ++i) {
+        lines << QString("%1: %2 ms").arg(m_timings.at(i).first, -24).arg(m_timings.at(i).second);
+        total += m_timings.at(i).second;
+    }
+    lines << QString("%1: %2 ms").arg("total (phases)", -24).arg(total);
+    lines << QString("%1: %2 ms").arg("first paint at", -24).arg(m_firstPaintTime);
+    lines << QString("%1: %2 ms").arg("finished at", -24).arg(m_finishTime);
+
+    return lines.join("\n");
+}
+
+void StartupScheduler::runNextPhase()
+{
+    if (m_phases.isEmpty()) {
+        if (!m_finished) {
+            m_finished = true;
+            m_finishTime = m_startupTimer.elapsed();
+            emit finished();
+        }
+        return;
+    }
+
+    const Phase phase = m_phases.takeFirst();
+
+    if (phase.receiver) {
+        QElapsedTimer timer;
+        timer.start();
+
+        if (!QMetaObject::invokeMethod(phase.receiver, phase.member.constData(), Qt::DirectConnection)) {
+            qWarning("StartupScheduler: can not invoke \"%s\" for phase \"%s\"", phase.member.constData(), qPrintable(phase.name));
+        }
+
+        recordPhase(phase.name, timer.elapsed());
+        emit phaseFinished(phase.name, timer.elapsed());
+    }
+
+    // let pending paint and input events be processed between phases
+    QTimer::singleShot(0, this, SLOT(runNextPhase()));
+}
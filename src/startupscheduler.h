@@ -0,0 +1,93 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef STARTUPSCHEDULER_H
+#define STARTUPSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QPointer>
+#include <QStringList>
+
+class QWidget;
+
+// Runs deferred initialization phases one per event loop iteration after
+// main window is painted, so it's shown before heavy loading and it remains
+// responsive.
+class StartupScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StartupScheduler(QObject* parent = 0);
+
+    // 'member' is the name of a slot or Q_INVOKABLE method of 'receiver',
+    // phases with lower priority run first.
+    void addPhase(const QString &name, QObject* receiver, const char* member, int priority = 0);
+    // for the phases that are done synchronously before start()
+    void recordPhase(const QString &name, qint64 elapsed);
+
+    // phases start after the first paint of 'window', or when the event
+    // loop starts if it's null
+    void start(QWidget* window = 0);
+    bool isFinished() const { return m_finished; }
+
+    // milliseconds since the scheduler was created
+    qint64 elapsed() const { return m_startupTimer.elapsed(); }
+    // -1 until 'window' of start() is painted
+    qint64 firstPaintTime() const { return m_firstPaintTime; }
+
+    QList<QPair<QString, qint64> > timings() const { return m_timings; }
+    QString report() const;
+
+signals:
+    void phaseFinished(const QString &name, qint64 elapsed);
+    void finished();
+
+protected:
+    bool eventFilter(QObject* receiver, QEvent* event);
+
+private slots:
+    void runNextPhase();
+    void firstPaintDone();
+
+private:
+    struct Phase {
+        QString name;
+        QPointer<QObject> receiver;
+        QByteArray member;
+        int priority;
+    };
+
+    QList<Phase> m_phases;
+    QPointer<QWidget> m_window;
+    QList<QPair<QString, qint64> > m_timings;
+    QElapsedTimer m_startupTimer;
+    qint64 m_firstPaintTime;
+    qint64 m_finishTime;
+    bool m_started;
+    bool m_firstPaintDone;
+    bool m_finished;
+};
+
+#endif // STARTUPSCHEDULER_H
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "termdictionary.h"
+
+TermDictionary::TermDictionary()
+{
+}
+
+void TermDictionary::clear()
+{
+    m_nodes.clear();
+}
+
+bool TermDictionary::isEmpty() const
+{
+    return m_nodes.isEmpty();
+}
+
+void TermDictionary::insert(const QString &term)
+{
+    if (m_nodes.isEmpty()) {
+        Node root;
+        root.term = term;
+        m_nodes.append(root);
+        return;
+    }
+
+    int current = 0;
+    while (true) {
+        const int dist = distance(term, m_nodes.at(current).term);
+        if (dist == 0) {
+            return;
+        }
+
+        const int child = m_nodes.at(current).children.value(dist, -1);
+        if (child == -1) {
+            Node node;
+            node.term = term;
+            m_nodes.append(node);
+            m_nodes[current].children.insert(dist, m_nodes.size() - 1);
+            return;
+        }
+
+        current = child;
+    }
+}
+
+QStringList TermDictionary::similarTerms(const QString &term, int maxDistance) const
+{
+    QStringList terms;
+    if (m_nodes.isEmpty()) {
+        return terms;
+    }
+
+    QVector<int> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.last());
+        stack.removeLast();
+
+        const int dist = distance(term, node.term);
+        if (dist <= maxDistance) {
+            terms << node.term;
+        }
+
+        // by triangle inequality other subtrees can't have a similar term
+        QHash<int, int>::const_iterator it = node.children.constBegin();
+        while (it != node.children.constEnd()) {
+            if (qAbs(it.key() - dist) <= maxDistance) {
+                stack.append(it.value());
+            }
+            ++it;
+        }
+    }
+
+    return terms;
+}
+
+int TermDictionary::distance(const QString &first, const QString &second)
+{
+    const int firstSize = first.size();
+    const int secondSize = second.size();
+
+    QVector<int> previous(secondSize + 1);
+    QVector<int> current(secondSize + 1);
+    for (int j = 0; j <= secondSize; ++j) {
+        previous[j] = j;
+    }
+
+    for (int i = 1; i <= firstSize; ++i) {
+        current[0] = i;
+        for (int j = 1; j <= secondSize; ++j) {
+            const int substitution = previous.at(j - 1) + (first.at(i - 1) == second.at(j - 1) ? 0 : 1);
+            current[j] = qMin(substitution, qMin(previous.at(j), current.at(j - 1)) + 1);
+        }
+        previous.swap(current);
+    }
+
+    return previous.at(secondSize);
+}
@@ -0,0 +1,56 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TERMDICTIONARY_H
+#define TERMDICTIONARY_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+// BK-tree of distinct terms of corpus, it finds terms within an edit
+// distance of a query term by visiting a small part of the tree.
+class TermDictionary
+{
+public:
+    TermDictionary();
+
+    void clear();
+    bool isEmpty() const;
+
+    // duplicate terms are ignored
+    void insert(const QString &term);
+    // terms that their Levenshtein distance to 'term' is at most 'maxDistance'
+    QStringList similarTerms(const QString &term, int maxDistance) const;
+
+    static int distance(const QString &first, const QString &second);
+
+private:
+    struct Node {
+        QString term;
+        // child node index by its distance to this node
+        QHash<int, int> children;
+    };
+
+    QVector<Node> m_nodes;
+};
+
+#endif // TERMDICTIONARY_H
@@ -0,0 +1,217 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadStorage>
+
+// events per thread, older events are overwritten
+#define RING_BUFFER_SIZE 8192
+
+namespace
+{
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    qint64 start;
+    qint64 duration;
+};
+
+// written just by its owner thread, the exporter reads events up to the
+// published index
+struct ThreadBuffer {
+    ThreadBuffer() : threadId(0), written(0), events(new TraceEvent[RING_BUFFER_SIZE]) {}
+    ~ThreadBuffer() { delete[] events; }
+
+    int threadId;
+    QString threadName;
+    QAtomicInt published;
+    // events before this index are cleared
+    QAtomicInt clearedAt;
+    int written;
+    TraceEvent* events;
+};
+
+typedef QSharedPointer<ThreadBuffer> ThreadBufferPointer;
+
+struct TraceClock {
+    TraceClock() { timer.start(); }
+
+    QElapsedTimer timer;
+};
+
+TraceClock s_clock;
+
+// buffers are kept after their threads finished
+QMutex s_buffersMutex;
+QList<ThreadBufferPointer> s_buffers;
+QThreadStorage<ThreadBufferPointer> s_threadBuffer;
+int s_nextThreadId = 1;
+
+QMutex s_internMutex;
+QHash<QString, QByteArray> s_internedNames;
+
+ThreadBuffer* threadBuffer()
+{
+    if (!s_threadBuffer.hasLocalData()) {
+        ThreadBufferPointer buffer(new ThreadBuffer);
+
+        QThread* thread = QThread::currentThread();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+            buffer->threadName = QLatin1String("main");
+        }
+        else {
+            buffer->threadName = thread->objectName();
+        }
+
+        s_buffersMutex.lock();
+        buffer->threadId = s_nextThreadId++;
+        if (buffer->threadName.isEmpty()) {
+            buffer->threadName = QString("worker %1").arg(buffer->threadId);
+        }
+        s_buffers.append(buffer);
+        s_buffersMutex.unlock();
+
+        s_threadBuffer.setLocalData(buffer);
+    }
+
+    return s_threadBuffer.localData().data();
+}
+
+QString jsonString(const char* str)
+{
+    QString escaped = QString::fromUtf8(str);
+    escaped.replace(QLatin1String("\\"), QLatin1String("\\\\"));
+    escaped.replace(QLatin1String("\""), QLatin1String("\\\""));
+
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+}
+
+QAtomicInt Tracer::s_enabled(0);
+
+void Tracer::setEnabled(bool enabled)
+{
+    s_enabled.fetchAndStoreOrdered(enabled ? 1 : 0);
+}
+
+qint64 Tracer::now()
+{
+    return s_clock.timer.nsecsElapsed() / 1000;
+}
+
+void Tracer::record(const char* category, const char* name, qint64 start, qint64 duration)
+{
+    ThreadBuffer* buffer = threadBuffer();
+
+    TraceEvent &event = buffer->events[buffer->written % RING_BUFFER_SIZE];
+    event.category = category;
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+
+    ++buffer->written;
+    buffer->published.fetchAndStoreRelease(buffer->written);
+}
+
+const char* Tracer::intern(const QString &name)
+{
+    QMutexLocker locker(&s_internMutex);
+
+    QHash<QString, QByteArray>::iterator it = s_internedNames.find(name);
+    if (it == s_internedNames.end()) {
+        it = s_internedNames.insert(name, name.toUtf8());
+    }
+
+    // QByteArray's data is not moved by rehashing
+    return it.value().constData();
+}
+
+bool Tracer::exportChromeTrace(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        return false;
+    }
+
+    s_buffersMutex.lock();
+    const QList<ThreadBufferPointer> buffers = s_buffers;
+    s_buffersMutex.unlock();
+
+    QStringList events;
+    foreach (const ThreadBufferPointer &buffer, buffers) {
+        events << QString("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %1, \"args\": {\"name\": %2}}")
+               .arg(buffer->threadId).arg(jsonString(buffer->threadName.toUtf8().constData()));
+
+        // a span that is being written concurrently may be inconsistent,
+        // it's acceptable for a diagnostic trace
+        const int published = buffer->published.fetchAndAddAcquire(0);
+        const int first = qMax(buffer->clearedAt.fetchAndAddAcquire(0), published - RING_BUFFER_SIZE);
+        for (int i = first; i < published; ++i) {
+            const TraceEvent &event = buffer->events[i % RING_BUFFER_SIZE];
+            events << QString("{\"name\": %1, \"cat\": %2, \"ph\": \"X\", \"ts\": %3, \"dur\": %4, \"pid\": 1, \"tid\": %5}")
+                   .arg(jsonString(event.name)).arg(jsonString(event.category))
+                   .arg(event.start).arg(event.duration).arg(buffer->threadId);
+        }
+    }
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << "{\"traceEvents\": [\n" << events.join(",\n") << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+    return out.status() == QTextStream::Ok;
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker(&s_buffersMutex);
+
+    // owner threads keep writing, so events are just marked as cleared
+    foreach (const ThreadBufferPointer &buffer, s_buffers) {
+        buffer->clearedAt.fetchAndStoreRelease(buffer->published.fetchAndAddAcquire(0));
+    }
+}
+
+void Tracer::initFromEnvironment()
+{
+    const QByteArray value = qgetenv("SAAGHAR_TRACE");
+
+    if (!value.isEmpty() && value != "0") {
+        setEnabled(true);
+    }
+}
+
+QString Tracer::environmentTraceFile()
+{
+    const QString value = QString::fromLocal8Bit(qgetenv("SAAGHAR_TRACE"));
+
+    return (value.isEmpty() || value == QLatin1String("0") || value == QLatin1String("1")) ? QString() : value;
+}
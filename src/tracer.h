@@ -0,0 +1,96 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QString>
+
+#define TRACE_CONCAT_HELPER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_HELPER(a, b)
+
+// Records a span from here to the end of scope when tracing is enabled.
+// 'category' and 'name' have to be string literals or Tracer::intern()ed.
+#define TRACE_SPAN(category, name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(category, name)
+
+// Low overhead tracing: every thread writes its finished spans into its own
+// ring buffer without locking and the buffers are exported as Chrome's
+// trace_event JSON (chrome://tracing or https://ui.perfetto.dev).
+// Tracing is enabled by the settings dialog or by SAAGHAR_TRACE environment
+// variable, when it's a file path the trace is saved to it on exit.
+class Tracer
+{
+public:
+    static bool isEnabled()
+    {
+#if QT_VERSION >= 0x050000
+        return s_enabled.load() != 0;
+#else
+        return s_enabled != 0;
+#endif
+    }
+    static void setEnabled(bool enabled);
+
+    // microseconds since start of application
+    static qint64 now();
+
+    static void record(const char* category, const char* name, qint64 start, qint64 duration);
+    // a stable copy of a dynamic name for using with TRACE_SPAN
+    static const char* intern(const QString &name);
+
+    static bool exportChromeTrace(const QString &fileName);
+    static void clear();
+
+    // SAAGHAR_TRACE
+    static void initFromEnvironment();
+    static QString environmentTraceFile();
+
+private:
+    static QAtomicInt s_enabled;
+};
+
+class TraceSpan
+{
+public:
+    TraceSpan(const char* category, const char* name)
+        : m_category(category),
+          m_name(name),
+          m_start(Tracer::isEnabled() ? Tracer::now() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (m_start >= 0) {
+            Tracer::record(m_category, m_name, m_start, Tracer::now() - m_start);
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    const char* m_category;
+    const char* m_name;
+    qint64 m_start;
+};
+
+#endif // TRACER_H
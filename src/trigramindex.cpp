@@ -0,0 +1,270 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "trigramindex.h"
+#include "databasebrowser.h"
+#include "positionalindex.h"
+#include "searchresultcache.h"
+#include "tools.h"
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QSqlQuery>
+
+// about 64 MB of postings
+const int TrigramIndex::maxPostings = 16 * 1024 * 1024;
+
+TrigramIndex* TrigramIndex::s_instance = 0;
+static QMutex instanceMutex;
+
+TrigramIndex* TrigramIndex::instance()
+{
+    QMutexLocker locker(&instanceMutex);
+
+    if (!s_instance) {
+        // created without parent from any thread, see PositionalIndex::instance()
+        s_instance = new TrigramIndex;
+        s_instance->moveToThread(QCoreApplication::instance()->thread());
+        qAddPostRoutine(destroy);
+    }
+
+    return s_instance;
+}
+
+void TrigramIndex::destroy()
+{
+    delete s_instance;
+}
+
+TrigramIndex::TrigramIndex(QObject* parent)
+    : QObject(parent)
+{
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    s_instance = 0;
+}
+
+bool TrigramIndex::prepare(Table table, const QString &connectionID, const CancelToken &cancelToken)
+{
+    // the index is dropped when any database is updated
+    const QString stamp = SearchResultCache::instance()->indexStamp(DatabaseBrowser::databaseFileFromID(connectionID));
+
+    QMutexLocker locker(&m_mutex);
+
+    TableIndex &index = m_tables[table];
+    if (index.stamp == stamp) {
+        return true;
+    }
+    if (index.skippedStamp == stamp) {
+        return false;
+    }
+
+    TRACE_SPAN("search", table == Verses ? "build verse trigram index" : "build title trigram index");
+
+    index.stamp.clear();
+    index.skippedStamp.clear();
+    index.docs.clear();
+    index.postings.clear();
+
+    QSqlQuery q(DatabaseBrowser::database(connectionID));
+    q.setForwardOnly(true);
+    // assume title's order is zero!
+    q.exec(table == Verses ? "SELECT poem_id, vorder, text FROM verse" : "SELECT id, 0, title FROM poem");
+
+    int postingCount = 0;
+    while (q.next()) {
+        if (index.docs.size() % 4096 == 0 && cancelToken.isCanceled()) {
+            index.docs.clear();
+            index.postings.clear();
+            return false;
+        }
+
+        if (postingCount > maxPostings) {
+            index.docs.clear();
+            index.postings.clear();
+            index.skippedStamp = stamp;
+            return false;
+        }
+
+        const int doc = index.docs.size();
+        index.docs.append(PositionalIndex::verseKey(q.value(0).toInt(), q.value(1).toInt()));
+
+        // same as the text that search task matches phrases against
+        const QString text = " " + Tools::cleanStringFast(q.value(2).toString(), QStringList() << " ") + " ";
+        for (int i = 0; i + 3 <= text.size(); ++i) {
+            DocList &docs = index.postings[trigram(text, i)];
+            // docs are appended in order, so lists remain sorted and unique
+            if (docs.isEmpty() || docs.last() != doc) {
+                docs.append(doc);
+                ++postingCount;
+            }
+        }
+    }
+
+    index.stamp = stamp;
+
+    return true;
+}
+
+void TrigramIndex::release()
+{
+    QMutexLocker locker(&m_mutex);
+
+    for (int i = 0; i < 2; ++i) {
+        m_tables[i].stamp.clear();
+        m_tables[i].skippedStamp.clear();
+        m_tables[i].docs.clear();
+        m_tables[i].docs.squeeze();
+        m_tables[i].postings.clear();
+    }
+}
+
+bool TrigramIndex::find(Table table, const QStringList &phrases, QSet<qint64>* keys)
+{
+    QSet<quint64> trigrams;
+    foreach (const QString &phrase, phrases) {
+        foreach (const QString &part, literalParts(phrase)) {
+            for (int i = 0; i + 3 <= part.size(); ++i) {
+                trigrams.insert(trigram(part, i));
+            }
+        }
+    }
+
+    if (trigrams.isEmpty()) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    const TableIndex &index = m_tables[table];
+
+    // intersect shorter lists first
+    QList<DocList> lists;
+    foreach (quint64 key, trigrams) {
+        const DocList docs = index.postings.value(key);
+        if (docs.isEmpty()) {
+            keys->clear();
+            return true;
+        }
+
+        int i = 0;
+        while (i < lists.size() && lists.at(i).size() < docs.size()) {
+            ++i;
+        }
+        lists.insert(i, docs);
+    }
+
+    DocList docs = lists.at(0);
+    for (int i = 1; i < lists.size() && !docs.isEmpty(); ++i) {
+        docs = intersected(docs, lists.at(i));
+    }
+
+    keys->clear();
+    keys->reserve(docs.size());
+    for (int i = 0; i < docs.size(); ++i) {
+        keys->insert(index.docs.at(docs.at(i)));
+    }
+
+    return true;
+}
+
+int TrigramIndex::estimatedMatches(Table table, const QString &connectionID, const QString &phrase)
+{
+    if (!isIndexable(phrase)) {
+        return -1;
+    }
+
+    const QString stamp = SearchResultCache::instance()->indexStamp(DatabaseBrowser::databaseFileFromID(connectionID));
+
+    // planner should not wait for building of the index
+    if (!m_mutex.tryLock()) {
+        return -1;
+    }
+
+    const TableIndex &index = m_tables[table];
+    int estimate = -1;
+    if (index.stamp == stamp) {
+        estimate = index.docs.size();
+        foreach (const QString &part, literalParts(phrase)) {
+            for (int i = 0; i + 3 <= part.size(); ++i) {
+                estimate = qMin(estimate, index.postings.value(trigram(part, i)).size());
+            }
+        }
+    }
+
+    m_mutex.unlock();
+
+    return estimate;
+}
+
+bool TrigramIndex::isIndexable(const QString &phrase)
+{
+    //QChar(71,6): Simple He, a phrase with Ye-As-Kasre is matched by a regexp
+    if (phrase.contains("=") || phrase.contains(QString(QChar(71, 6)) + " ")) {
+        return false;
+    }
+
+    foreach (const QString &part, literalParts(phrase)) {
+        if (part.size() >= 3) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QStringList TrigramIndex::literalParts(const QString &phrase)
+{
+    // '%' matches a part of word and "%%" matches anything
+    return phrase.split(QLatin1Char('%'), QString::SkipEmptyParts);
+}
+
+// characters are case folded, search task verifies candidates case insensitively
+quint64 TrigramIndex::trigram(const QString &text, int pos)
+{
+    return (quint64(text.at(pos).toCaseFolded().unicode()) << 32) |
+           (quint64(text.at(pos + 1).toCaseFolded().unicode()) << 16) |
+           quint64(text.at(pos + 2).toCaseFolded().unicode());
+}
+
+TrigramIndex::DocList TrigramIndex::intersected(const DocList &first, const DocList &second)
+{
+    DocList docs;
+    int i = 0;
+    int j = 0;
+    while (i < first.size() && j < second.size()) {
+        if (first.at(i) < second.at(j)) {
+            ++i;
+        }
+        else if (first.at(i) > second.at(j)) {
+            ++j;
+        }
+        else {
+            docs.append(first.at(i));
+            ++i;
+            ++j;
+        }
+    }
+
+    return docs;
+}
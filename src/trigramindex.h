@@ -0,0 +1,98 @@
+/***************************************************************************
+ *  This file is part of Saaghar, a Persian poetry software                *
+ *                                                                         *
+ *  Copyright (C) 2016 by S. Razi Alavizadeh                               *
+ *  E-Mail: <s.r.alavizadeh@gmail.com>, WWW: <http://pozh.org>             *
+ *                                                                         *
+ *  This program is free software; you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation; either version 3 of the License,         *
+ *  (at your option) any later version                                     *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details                            *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program; if not, see http://www.gnu.org/licenses/      *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include "concurrenttasks.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// Trigrams of normalized and case folded verse texts and poem titles of one database,
+// it selects candidate rows for substring and wildcard phrases, the candidates
+// are verified by search task. Each table is built lazily from search tasks' threads,
+// a table that has more than 'maxPostings' trigrams is not indexed.
+class TrigramIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Table {
+        Verses = 0,
+        Titles = 1
+    };
+
+    static TrigramIndex* instance();
+    ~TrigramIndex();
+
+    static const int maxPostings;
+
+    // builds 'table' of the database of 'connectionID' if it's not built yet
+    // or it's built for another database, normalization options or database generation.
+    // returns false if building is canceled or the table is too large.
+    bool prepare(Table table, const QString &connectionID, const CancelToken &cancelToken);
+
+    // keys of rows that contain all trigrams of literal parts of 'phrases',
+    // returns false if phrases have no trigram, prepare() must be called before
+    bool find(Table table, const QStringList &phrases, QSet<qint64>* keys);
+
+    // upper bound of rows that match 'phrase', -1 if it's not indexable or 'table' is
+    // not built for the database of 'connectionID' (or it's being built)
+    int estimatedMatches(Table table, const QString &connectionID, const QString &phrase);
+
+    // a phrase that has a literal part of at least three characters, rhyme and
+    // radif phrases and the ones that are matched by a regexp are not indexable
+    static bool isIndexable(const QString &phrase);
+
+public slots:
+    // frees both tables, they are rebuilt by next prepare()
+    void release();
+
+private:
+    Q_DISABLE_COPY(TrigramIndex)
+    TrigramIndex(QObject* parent = 0);
+    static TrigramIndex* s_instance;
+    static void destroy();
+
+    typedef QVector<int> DocList;
+
+    struct TableIndex {
+        QString stamp;
+        // stamp of the database that its table was too large to index
+        QString skippedStamp;
+        QVector<qint64> docs;
+        QHash<quint64, DocList> postings;
+    };
+
+    static QStringList literalParts(const QString &phrase);
+    static quint64 trigram(const QString &text, int pos);
+    static DocList intersected(const DocList &first, const DocList &second);
+
+    QMutex m_mutex;
+    TableIndex m_tables[2];
+};
+
+#endif // TRIGRAMINDEX_H